@@ -0,0 +1,173 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ramps.h"
+
+// *****************************************************************************
+
+void GSP_Ramps::Init(uint32_t sampling_rate)
+{
+	/*
+    Initiate the parameter ramps.
+		sampling_rate
+			ADC sampling rate (Hz)
+	*/
+
+	sample_rate 	= sampling_rate;
+	active 			= 0;
+
+	return;
+}
+
+// *****************************************************************************
+
+int8_t GSP_Ramps::Schedule(int32_t effect, uint8_t param, float from, float to, 
+	float ramp_ms, uint8_t shape)
+{
+	/*
+    To schedule a ramp of an effect parameter. A ramp already running on the
+	same parameter is replaced, starting from the given value.
+		effect, param
+			effect number and parameter index (as in the Effect Command)
+		from, to
+			current and target values
+		ramp_ms
+			ramp time in milliseconds (0 to RAMP_MAX_MS)
+		shape
+			RAMP_LINEAR or RAMP_EXPONENTIAL. Exponential ramps need values
+			with the same sign, otherwise they are linear.
+	Returns the lane, or -1 if all the lanes are in use.
+	*/
+
+	int32_t 	i, n;
+	uint32_t 	samples;
+
+	n 	= -1;
+	for (i = 0; i < RAMP_LANES; i++)
+	{
+		if ((active >> i) & 1)
+		{
+			if (lane[i].effect == effect && lane[i].param == param) 
+			{
+				n 	= i;
+				break;
+			}
+		}
+		else if (n < 0) n 	= i;
+	}
+	if (n < 0) return -1;
+
+	// the lane is left by the audio callback while it is written
+	active 		&= ~(1UL << n);
+
+	ramp_ms 	= fmaxf(fminf(ramp_ms, RAMP_MAX_MS), 0);
+	samples 	= ramp_ms*sample_rate/1000.f;
+	if (samples < 1) samples 	= 1;
+	if (shape >= RAMP_SHAPES || from*to <= 0) shape 	= RAMP_LINEAR;
+
+	lane[n].effect 		= effect;
+	lane[n].param 		= param;
+	lane[n].shape 		= shape;
+	lane[n].value 		= from;
+	lane[n].target 		= to;
+	lane[n].remaining 	= samples;
+	if (shape == RAMP_EXPONENTIAL) lane[n].step 	= powf(to/from, 1.f/samples);
+	else lane[n].step 	= (to - from)/samples;
+
+	active 		|= 1UL << n;
+
+	return n;
+}
+
+// *****************************************************************************
+
+void GSP_Ramps::Cancel(int32_t effect)
+{
+	/*
+    To stop the ramps of an effect, keeping the current values.
+		effect
+			effect number, or -1 for all the ramps
+	*/
+
+	int32_t 	i;
+
+	for (i = 0; i < RAMP_LANES; i++)
+	{
+		if (effect < 0 || lane[i].effect == effect) active 	&= ~(1UL << i);
+	}
+
+	return;
+}
+
+// *****************************************************************************
+
+float GSP_Ramps::Advance(uint32_t n, uint32_t samples)
+{
+	/*
+    To advance a ramp by a block of samples, once per audio callback. The
+	lane is released when the target is reached.
+		n
+			active lane
+		samples
+			samples in the block
+	Returns the parameter value at the end of the block.
+	*/
+
+	uint32_t 	i;
+
+	if (lane[n].remaining <= samples)
+	{
+		lane[n].value 		= lane[n].target;
+		lane[n].remaining 	= 0;
+		active 		&= ~(1UL << n);
+		return lane[n].value;
+	}
+
+	lane[n].remaining 	-= samples;
+	if (lane[n].shape == RAMP_EXPONENTIAL)
+	{
+		for (i = 0; i < samples; i++) lane[n].value 	*= lane[n].step;
+	}
+	else lane[n].value 	+= samples*lane[n].step;
+
+	return lane[n].value;
+}
+
+// *****************************************************************************
+
+void GSP_Ramps::Printout(uint8_t out_list, GSP_SignalChain *chain, char *printout)
+{
+	/*
+    To print the running ramps: effect, parameter index, current value,
+	target and remaining time (ms).
+	*/
+
+	uint32_t 	i;
+	char 		pname[8];
+
+    if (out_list == 0) sprintf(printout, "->RMP: Ramps (%d):", RAMP_LANES);
+    if (out_list == 1) sprintf(printout, "->RMP");
+
+	for (i = 0; i < RAMP_LANES; i++)
+	{
+		if (((active >> i) & 1) == 0) continue;
+		if (strlen(printout) > 200)
+		{
+			strcat(printout, " ...");
+			break;
+		}
+		chain->Name(lane[i].effect, pname);
+		if (out_list == 0)
+			sprintf(printout + strlen(printout), " | %s %d: %-.3f to %-.3f (%-.0f ms)", 
+				pname, lane[i].param, lane[i].value, lane[i].target, 
+				1000.f*lane[i].remaining/sample_rate);
+		else
+			sprintf(printout + strlen(printout), " %s %d %-.3f %-.3f %-.0f", 
+				pname, lane[i].param, lane[i].value, lane[i].target, 
+				1000.f*lane[i].remaining/sample_rate);
+	}
+	strcat(printout, "\n");
+
+	return;
+}
@@ -0,0 +1,45 @@
+#ifndef GSP_RAMPS_H
+#define GSP_RAMPS_H
+
+#include <stdint.h>
+#include "gsp_chain.h"
+
+#define RAMP_LANES 		8 		// parameters ramping at the same time
+#define RAMP_MAX_MS 	60000.f
+
+enum ramp_shapes
+{
+	RAMP_LINEAR 		= 0,
+	RAMP_EXPONENTIAL 	= 1, 	// constant ratio per sample (same sign values)
+	RAMP_SHAPES,
+};
+
+struct GSP_RampLane
+{
+	int32_t 	effect; 		// effect number (see enum gsp_effects)
+	uint8_t 	param; 			// parameter index, as in the Effect Command
+	uint8_t 	shape;
+	float 		value, target;
+	float 		step; 			// increment (linear) or ratio (exponential) per sample
+	uint32_t 	remaining; 		// samples to the target
+};
+
+class GSP_Ramps
+{
+	public:
+		GSP_Ramps() {}
+		~GSP_Ramps() {}
+
+		void 		Init(uint32_t sampling_rate);
+		int8_t 		Schedule(int32_t effect, uint8_t param, float from, float to, 
+						float ramp_ms, uint8_t shape);
+		void 		Cancel(int32_t effect);
+		float 		Advance(uint32_t n, uint32_t samples);
+		void		Printout(uint8_t out_list, GSP_SignalChain *chain, char *printout);
+
+		uint32_t 	sample_rate;	// sampling rate
+		volatile uint32_t 	active; // active lanes (bit mask)
+		GSP_RampLane 	lane[RAMP_LANES];
+};
+
+#endif 	// GSP_RAMPS_H
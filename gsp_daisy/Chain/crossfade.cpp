@@ -0,0 +1,236 @@
+#include <math.h>
+#include <stdio.h>
+
+#include "guitar_dsp.h"
+#include "crossfade.h"
+
+// *****************************************************************************
+
+void GSP_Crossfade::Init(uint32_t sample_rate, uint32_t tick_rate)
+{
+	/*
+    To initiate the scene switch crossfade.
+		sample_rate
+			sampling frequency (Hz)
+		tick_rate
+			frequency of the tick counter used to time the audio callback (Hz)
+	*/
+
+	uint32_t 	i;
+
+	sample_rate_ 	= sample_rate;
+	sample_ticks_ 	= (float)tick_rate/sample_rate;
+
+	// equal-power crossfade: old gain is cos, new gain is sin
+	for (i = 0; i <= XFD_TABLE; i++)
+	{
+		gain_[i] 	= sinf(0.5f*GDSP_PI*i/XFD_TABLE);
+	}
+	gain_[XFD_TABLE + 1] 	= gain_[XFD_TABLE];
+
+	time_ms 		= 0;
+	active 			= 0;
+	hold 			= 0;
+	done_ 			= 0;
+	length_ 		= 0;
+	number_effects 	= 0;
+	shared 			= 0;
+	base_ticks_ 	= 0;
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_Crossfade::SetTime(float ms)
+{
+	/*
+    To set the crossfade time of the scene switch.
+		ms
+			crossfade time (5 to 50 ms), or 0 to switch instantly
+	*/
+
+	if (active) return;
+
+	if (ms <= 0)
+	{
+		time_ms 	= 0;
+		length_ 	= 0;
+		return;
+	}
+	if (ms < XFD_MIN_MS) ms 	= XFD_MIN_MS;
+	if (ms > XFD_MAX_MS) ms 	= XFD_MAX_MS;
+	time_ms 	= ms;
+	length_ 	= (uint32_t)(time_ms*sample_rate_/1000.f);
+	step_ 		= (float)XFD_TABLE/length_;
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_Crossfade::Start()
+{
+	/*
+    To start a transition. The old chain (sgn_chain, number_effects) must be
+	loaded before, and the audio callback runs only the old chain until 
+	Release() is called.
+	*/
+
+	pos_ 			= 0;
+	xfd_ticks_ 		= 0;
+	xfd_samples_ 	= 0;
+	xfd_base_ 		= base_ticks_;
+	done_ 			= 0;
+	hold 			= 1;
+	active 			= 1;
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_Crossfade::Release()
+{
+	/*
+    To start the crossfade, once the new chain is configured.
+	*/
+
+	hold 	= 0;
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_Crossfade::Cut()
+{
+	/*
+    To end an instant transition (time_ms = 0) once released: called by the 
+	audio callback at the start of a block, which then runs only the new chain.
+	*/
+
+	if (!active || hold || length_ > 0) return;
+
+	active 	= 0;
+	done_ 	= 1;
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_Crossfade::Mix(int32_t old_sampl, int32_t old_side, int32_t *sampl, int32_t *side)
+{
+	/*
+    To mix the old and the new chain outputs, with equal-power gains.
+		old_sampl, old_side
+			old chain output (mid and side)
+		sampl, side
+			new chain output (mid and side), replaced by the mix
+	At the end of the crossfade the old chain is dropped (active = 0).
+	*/
+
+	float 		x, g_old, g_new;
+
+	x 		= pos_*step_;
+	if (x > XFD_TABLE) x 	= XFD_TABLE;
+
+	pos_++;
+	if (pos_ >= length_)
+	{
+		active 	= 0;
+		done_ 	= 1;
+	}
+
+	g_old 	= Gain(XFD_TABLE - x);
+	g_new 	= Gain(x);
+	*sampl 	= (int32_t)(g_old*old_sampl + g_new**sampl);
+	*side 	= (int32_t)(g_old*old_side + g_new**side);
+
+	return;
+}
+
+// *****************************************************************************
+
+float GSP_Crossfade::Gain(float x)
+{
+	/*
+    Interpolated gain table, for x from 0 to XFD_TABLE.
+	*/
+
+	uint32_t 	k;
+
+	k 	= (uint32_t)x;
+
+	return gain_[k] + (x - k)*(gain_[k + 1] - gain_[k]);
+}
+
+// *****************************************************************************
+
+void GSP_Crossfade::Account(uint32_t ticks, uint32_t samples)
+{
+	/*
+    To measure the audio callback duration, called once per callback.
+		ticks
+			callback duration (ticks)
+		samples
+			samples processed by the callback (block size)
+	*/
+
+	if (active || done_)
+	{
+		if (!hold && xfd_samples_ < length_)
+		{
+			xfd_ticks_ 	+= ticks;
+			xfd_samples_ 	+= samples;
+		}
+	}
+	else base_ticks_ 	+= 0.001f*((float)ticks/samples - base_ticks_);
+
+	return;
+}
+
+// *****************************************************************************
+
+uint8_t GSP_Crossfade::Done()
+{
+	/*
+    Returns 1 once, when a transition has just finished.
+	*/
+
+	if (done_ == 0) return 0;
+	done_ 	= 0;
+
+	return 1;
+}
+
+// *****************************************************************************
+
+void GSP_Crossfade::Printout(uint8_t out_list, char *printout)
+{
+	/*
+    To print the crossfade time and the processor load (percent of the 
+	sampling period) before and during the last transition.
+	*/
+
+	float 	cpu_base, cpu_xfd;
+
+	cpu_base 	= 100.f*xfd_base_/sample_ticks_;
+	cpu_xfd 	= 0;
+	if (xfd_samples_ > 0) cpu_xfd 	= 100.f*xfd_ticks_/xfd_samples_/sample_ticks_;
+
+    if (out_list == 0)
+    {
+        sprintf(printout, "->XFD: Crossfade (5-50)(ms): %-.1f "
+        "| CPU (%%): %-.1f | Transition CPU (%%): %-.1f (%+.1f)\n", 
+        time_ms, cpu_base, cpu_xfd, cpu_xfd - cpu_base);
+    }
+    if (out_list == 1)
+    {
+        sprintf(printout, "->XFD %-.1f %-.1f %-.1f\n", 
+        time_ms, cpu_base, cpu_xfd);
+    }
+
+	return;
+}
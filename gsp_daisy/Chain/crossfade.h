@@ -0,0 +1,51 @@
+#ifndef GSP_CROSSFADE_H
+#define GSP_CROSSFADE_H
+
+#include <stdint.h>
+#include "gsp_chain.h"
+
+#define XFD_TABLE 		256 	// equal-power gain table (quarter of sine)
+#define XFD_MIN_MS 		5.f
+#define XFD_MAX_MS 		50.f
+
+class GSP_Crossfade
+{
+	public:
+		GSP_Crossfade() {}
+		~GSP_Crossfade() {}
+
+		void 		Init(uint32_t sample_rate, uint32_t tick_rate);
+		void 		SetTime(float ms);
+		void 		Start();
+		void 		Release();
+		void 		Cut();
+		void 		Mix(int32_t old_sampl, int32_t old_side, int32_t *sampl, int32_t *side);
+		void 		Account(uint32_t ticks, uint32_t samples);
+		uint8_t 	Done();
+		void		Printout(uint8_t out_list, char *printout);
+
+		float 		time_ms; 			// crossfade time (0 = scene switch off)
+		volatile uint8_t 	active; 	// old chain still running
+		volatile uint8_t 	hold; 		// new chain being configured (old chain only)
+		int32_t 	sgn_chain[MAX_EFFECT_NUMBER]; 	// old chain
+		uint32_t 	number_effects;
+		int8_t 		branch[MAX_EFFECT_NUMBER];
+		float 		branch_level[GSP_BRANCHES];
+		int32_t 	stereo_split;
+		uint32_t 	shared; 		// single instances kept by the new chain (bit mask)
+
+	private:
+		float 		Gain(float x);
+
+		float 		gain_[XFD_TABLE + 2];
+		uint32_t 	sample_rate_;
+		float 		sample_ticks_; 		// ticks per sample period
+		uint32_t 	length_, pos_;
+		float 		step_;
+		float 		base_ticks_; 		// mean callback ticks before the switch
+		float 		xfd_base_;
+		uint32_t 	xfd_ticks_, xfd_samples_;
+		volatile uint8_t 	done_;
+};
+
+#endif 	// GSP_CROSSFADE_H
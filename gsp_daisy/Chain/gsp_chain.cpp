@@ -17,15 +17,22 @@ using namespace daisy;
 void GSP_SignalChain::New()
 {
 	/*
-    To initiate the signal chain
+    To initiate the signal chain, with the first instance of each effect
+	in the order of their numbers (the second instances are left out)
 	*/
 
-	uint32_t i;
+	uint32_t i, n;
+
+	n 	= 0;
 	for (i = 0; i < MAX_EFFECT_NUMBER; i++)
 	{
-		sgn_chain[i] = i;
+		if (i < GSP_CMP2 || i > GSP_EQZ2) sgn_chain[n++] 	= i;
+		branch[i] 	= GSP_MAIN;
 	}
-	number_effects 	= MAX_EFFECT_NUMBER;
+	for (i = GSP_CMP2; i <= GSP_EQZ2; i++) sgn_chain[n++] 	= i;
+	number_effects 	= GSP_EFFECTS;
+	Merge(0.5, 0.5);
+	Stereo(-1);
 	
 	return;
 }
@@ -83,6 +90,11 @@ void GSP_SignalChain::Clear()
     To clear the effect chain (no effects on chain)
 	*/
 
+	uint32_t i;
+	for (i = 0; i < MAX_EFFECT_NUMBER; i++)
+	{
+		branch[i] 	= GSP_MAIN;
+	}
 	number_effects 	= 0;
 	
 	return;
@@ -224,6 +236,68 @@ int32_t GSP_SignalChain::Locate(int32_t effect)
 
 // *****************************************************************************
 
+void GSP_SignalChain::Branch(int32_t effect, int32_t to_branch)
+{
+	/*
+    To move an effect to a parallel branch, or back to the main chain.
+	Consecutive effects in branches make a parallel section: the signal is
+	split at the section input, each branch processes its own effects in
+	chain order, and both outputs are mixed at the section output. A branch
+	with no effects carries the dry signal (parallel wet/dry).
+		effect
+			effect number (enumerator, like GSP_CHS or GSP_DTN)
+		to_branch
+			GSP_MAIN, GSP_BRANCH_A or GSP_BRANCH_B
+	*/
+
+	if (effect < 0) return;
+	if (effect >= MAX_EFFECT_NUMBER) return;
+	if (to_branch < GSP_MAIN || to_branch >= GSP_BRANCHES) return;
+
+	branch[effect] 	= to_branch;
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_SignalChain::Merge(float level_a, float level_b)
+{
+	/*
+    To set the levels of the branches at the merge of a parallel section.
+		level_a, level_b
+			gains of branches A and B (0 to 1)
+	*/
+
+	branch_level[GSP_MAIN] 		= 1;
+	branch_level[GSP_BRANCH_A] 	= fmaxf(fminf(level_a, 1.), 0.);
+	branch_level[GSP_BRANCH_B] 	= fmaxf(fminf(level_b, 1.), 0.);
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_SignalChain::Stereo(int32_t from_pos)
+{
+	/*
+    To set where the signal becomes stereo. Effects from this chain position
+	on run their stereo version (if any), the others process the mid (L+R)
+	only and the side (L-R) by-passes them.
+		from_pos
+			first stereo position in chain (< 0: mono output, >= number of
+			effects: stereo output with mono effects)
+	*/
+
+	if (from_pos < 0) from_pos 	= -1;
+	if (from_pos > (int32_t)number_effects) from_pos 	= number_effects;
+	stereo_split 	= from_pos;
+
+	return;
+}
+
+// *****************************************************************************
+
 void GSP_SignalChain::Name(int32_t effect, char *printout)
 {
 	/*
@@ -260,6 +334,13 @@ void GSP_SignalChain::Name(int32_t effect, char *printout)
 	if (effect == GSP_VOL) sprintf(printout, "VOL");
 	if (effect == GSP_LIM) sprintf(printout, "LIM");
 	if (effect == GSP_NGT) sprintf(printout, "NGT");
+	if (effect == GSP_LPR) sprintf(printout, "LPR");
+	if (effect == GSP_MBC) sprintf(printout, "MBC");
+	if (effect == GSP_CMP2) sprintf(printout, "CMP#2");
+	if (effect == GSP_OVD2) sprintf(printout, "OVD#2");
+	if (effect == GSP_PHR2) sprintf(printout, "PHR#2");
+	if (effect == GSP_WAH2) sprintf(printout, "WAH#2");
+	if (effect == GSP_EQZ2) sprintf(printout, "EQZ#2");
 
  	return;
 }
@@ -312,6 +393,8 @@ void GSP_SignalChain::Effect_Name(int32_t effect, char *printout)
 	    if (efc_id == GSP_VOL) sprintf(printout, "->Volume VOL\n");
 	    if (efc_id == GSP_LIM) sprintf(printout, "->Limiter LIM\n");
 	    if (efc_id == GSP_NGT) sprintf(printout, "->NoiseGate NGT\n");
+	    if (efc_id == GSP_LPR) sprintf(printout, "->Looper LPR\n");
+	    if (efc_id == GSP_MBC) sprintf(printout, "->MultibandCompressor MBC\n");
     }
 
  	return;
@@ -329,6 +412,7 @@ int32_t GSP_SignalChain::Number(char* name)
 			and can have any lenght, but only the first three
 			characters will be used. It also can be mixed with
 			capital letters: 'Phr', 'DTN', 'cHS', etc.
+			A second instance is given by "#2" after the name: "ovd#2".
 	*/
 	
 	char st[4];
@@ -337,6 +421,17 @@ int32_t GSP_SignalChain::Number(char* name)
 	st[2] 	= tolower(name[2]);
 	st[3] 	= 0;
 	
+	if (name[0] != 0 && name[1] != 0 && name[2] != 0 
+		&& name[3] == '#' && name[4] == '2')
+	{
+		if (strcmp(st, "cmp") == 0) return GSP_CMP2;
+		if (strcmp(st, "ovd") == 0) return GSP_OVD2;
+		if (strcmp(st, "phr") == 0) return GSP_PHR2;
+		if (strcmp(st, "wah") == 0) return GSP_WAH2;
+		if (strcmp(st, "eqz") == 0) return GSP_EQZ2;
+		return -1;
+	}
+
 	if (strcmp(st, "lvd") == 0) return GSP_LVD;
 	if (strcmp(st, "cmp") == 0) return GSP_CMP;
 	if (strcmp(st, "ovd") == 0) return GSP_OVD;
@@ -357,6 +452,8 @@ int32_t GSP_SignalChain::Number(char* name)
 	if (strcmp(st, "vol") == 0) return GSP_VOL;
 	if (strcmp(st, "lim") == 0) return GSP_LIM;
 	if (strcmp(st, "ngt") == 0) return GSP_NGT;
+	if (strcmp(st, "lpr") == 0) return GSP_LPR;
+	if (strcmp(st, "mbc") == 0) return GSP_MBC;
 
 	return -1;
 }
@@ -386,8 +483,9 @@ int32_t GSP_SignalChain::RemoveEffect(char ct[])
 
 void GSP_SignalChain::Printout(uint8_t out_list, char* printout)
 {
-    uint32_t i;
-    char  pname[4];
+    uint32_t i, j, k;
+    int32_t  b;
+    char  pname[8];
     //char* pchar;
     
     if (out_list == 0)
@@ -396,11 +494,34 @@ void GSP_SignalChain::Printout(uint8_t out_list, char* printout)
  
         for (i = 0; i < number_effects; i++)
         {
+            if (branch[sgn_chain[i]] != GSP_MAIN)
+            {
+                // parallel section: [A:...|B:...]
+                for (k = i; k < number_effects && branch[sgn_chain[k]] != GSP_MAIN; k++);
+                if (stereo_split >= (int32_t)i && stereo_split < (int32_t)k) 
+                    strcat(printout, "(ST)->");
+                for (b = GSP_BRANCH_A; b < GSP_BRANCHES; b++)
+                {
+                    strcat(printout, b == GSP_BRANCH_A ? "[A:" : "|B:");
+                    for (j = i; j < k; j++)
+                    {
+                        if (branch[sgn_chain[j]] != b) continue;
+                        Name(sgn_chain[j], pname);
+                        strcat(printout, pname);
+                        strcat(printout, "->");
+                    }
+                }
+                strcat(printout, "]->");
+                i   = k - 1;
+                continue;
+            }
+            if (stereo_split == (int32_t)i) strcat(printout, "(ST)->");
             Name(sgn_chain[i], pname);
             strcat(printout, pname);
             strcat(printout, "->");
         }
 
+        if (stereo_split >= (int32_t)number_effects) strcat(printout, "(ST)->");
         strcat(printout, "Out->\n");
         //*pchar 	= 0; 		//sprintf(pchar, "%c", 0);
         strcat(printout, "\0"); 	//strcat(printout, pchar);
@@ -410,10 +531,33 @@ void GSP_SignalChain::Printout(uint8_t out_list, char* printout)
         sprintf(printout, "->(LVD) ");
         for (i = 0; i < number_effects; i++)
         {
+            if (branch[sgn_chain[i]] != GSP_MAIN)
+            {
+                // parallel section: [A ... B ...]
+                for (k = i; k < number_effects && branch[sgn_chain[k]] != GSP_MAIN; k++);
+                if (stereo_split >= (int32_t)i && stereo_split < (int32_t)k) 
+                    strcat(printout, "ST ");
+                for (b = GSP_BRANCH_A; b < GSP_BRANCHES; b++)
+                {
+                    strcat(printout, b == GSP_BRANCH_A ? "[A " : "B ");
+                    for (j = i; j < k; j++)
+                    {
+                        if (branch[sgn_chain[j]] != b) continue;
+                        Name(sgn_chain[j], pname);
+                        strcat(printout, pname);
+                        strcat(printout, " ");
+                    }
+                }
+                strcat(printout, "] ");
+                i   = k - 1;
+                continue;
+            }
+            if (stereo_split == (int32_t)i) strcat(printout, "ST ");
             Name(sgn_chain[i], pname);
             strcat(printout, pname);
             strcat(printout, " ");
         }
+        if (stereo_split >= (int32_t)number_effects) strcat(printout, "ST ");
         //*pchar 	= 0; 		//sprintf(pchar, "%c", 0);
         strcat(printout, "\n\0");
     }
@@ -3,7 +3,11 @@
 
 #include <stdint.h>
 
-#define MAX_EFFECT_NUMBER 	19
+#define GSP_EFFECTS 		21 		// effect types (first instances)
+#define MAX_EFFECT_NUMBER 	26 		// effect instances, first and second
+
+// The effect numbers are used by the binary protocol and the presets: new
+// effects are appended, the existing numbers never change.
 
 enum gsp_effects
 {
@@ -26,9 +30,24 @@ enum gsp_effects
 	GSP_VOL = 16, 				// Output volume
 	GSP_LIM = 17,				// Soft limiter
 	GSP_NGT = 18,				// Noise Gate
+	GSP_CMP2 = 19, 				// Second instances: cmp#2, ovd#2, phr#2,
+	GSP_OVD2 = 20, 				// wah#2 and eqz#2
+	GSP_PHR2 = 21,
+	GSP_WAH2 = 22,
+	GSP_EQZ2 = 23,
+	GSP_LPR = 24, 				// Looper
+	GSP_MBC = 25, 				// Multiband compressor
 	GSP_LAST, 					// None
 };
 
+enum gsp_branches
+{
+	GSP_MAIN 		= 0, 		// serial chain
+	GSP_BRANCH_A 	= 1, 		// parallel branches, split from the previous
+	GSP_BRANCH_B 	= 2, 		// main effect and merged into the next one
+	GSP_BRANCHES,
+};
+
 class GSP_SignalChain
 {
 	public:
@@ -42,6 +61,9 @@ class GSP_SignalChain
 		void 		FromLast(int32_t to_pos);
 		void 		Append(int32_t effect);
 		void 		Remove(int32_t effect);
+		void 		Branch(int32_t effect, int32_t to_branch);
+		void 		Merge(float level_a, float level_b);
+		void 		Stereo(int32_t from_pos);
 		int32_t 	Locate(int32_t effect);
 		void	    Name(int32_t effect, char *printout);
         void        Effect_Name(int32_t effect, char *printout);
@@ -51,10 +73,13 @@ class GSP_SignalChain
 
 		int32_t 	sgn_chain[MAX_EFFECT_NUMBER];
 		uint32_t 	number_effects;
-        uint32_t    max_effect_number = MAX_EFFECT_NUMBER;
+		int8_t 		branch[MAX_EFFECT_NUMBER]; 		// branch of each effect (enumerator)
+		float 		branch_level[GSP_BRANCHES]; 	// merge levels of branches A and B
+		int32_t 	stereo_split; 					// first stereo position (-1: mono)
+        uint32_t    max_effect_number = GSP_EFFECTS;
 	private:
-        int8_t      alpha_names[MAX_EFFECT_NUMBER] = {8, 0, 5, 7, 11, 12, 13, 14, 17, 18, 
-            3, 1, 2, 4, 10, 15, 9, 16, 6};
+        int8_t      alpha_names[GSP_EFFECTS] = {8, 0, 5, 7, 11, 12, 13, 14, 17, 24, 
+            25, 18, 3, 1, 2, 4, 10, 15, 9, 16, 6};
         int32_t     GSP_LVD = -1;
 };
 
@@ -30,6 +30,9 @@ void GSP_Chorus::Init(uint32_t sampling_rate, int16_t *ptr_buffer, uint32_t buff
 	SetDelayMilliSeconds(1);
 	SetDepth(5.);
 	SetMixer(0.5);
+	SetSpread(90.);
+	if (type_ == CHORUS) smooth_params 	= (1 << 1) | (1 << 3) | (1 << 7);
+	else smooth_params 	= (1 << 1) | (1 << 6);
 	Switch(GSP_OFF);
 
 	return;
@@ -155,7 +158,7 @@ int32_t GSP_Chorus::Process(int32_t sampl, uint32_t buffer_pointer)
 	*/
  
 
-	static uint32_t   shift, ptr;
+	uint32_t   shift, ptr;
   
 	shift   = shift_ + amplit_*lfo.GetValue();
 
@@ -165,6 +168,48 @@ int32_t GSP_Chorus::Process(int32_t sampl, uint32_t buffer_pointer)
 	return mix_inp_*sampl + mix_out_*(*(ptr_buffer_ + ptr));
 }
 
+void GSP_Chorus::SetSpread(float spread_deg)
+{
+	/*
+    To set the stereo spread of the Chorus effect.
+		spread_deg
+			phase offset of the right channel LFO (0 to 180 degrees)
+	*/
+
+	spread 		= fmaxf(fminf(spread_deg, 180), 0);
+	offset_ 	= spread*512./360.;
+
+	return;
+}
+
+void GSP_Chorus::ProcessStereo(int32_t *mid, int32_t *side, uint32_t buffer_pointer)
+{
+	/*
+    To compute the Chorus effect on a stereo signal, in mid/side form. The 
+	left and right channels are delayed by LFOs with phase offset (spread).
+		mid, side:
+			Input and processed mid (L+R)/2 and side (L-R)/2 samples
+	*/
+
+	uint32_t 	shift, ptr;
+	int32_t 	left, right;
+
+	shift   = shift_ + amplit_*lfo.GetValue();
+	if (buffer_pointer >= shift) ptr     = buffer_pointer - shift;
+	else ptr     = buffer_size_ - shift + buffer_pointer;
+	left 	= *(ptr_buffer_ + ptr);
+
+	shift   = shift_ + amplit_*lfo.GetOffsetValue(offset_);
+	if (buffer_pointer >= shift) ptr     = buffer_pointer - shift;
+	else ptr     = buffer_size_ - shift + buffer_pointer;
+	right 	= *(ptr_buffer_ + ptr);
+
+	*mid 	= mix_inp_**mid + mix_out_*(left + right)*0.5f;
+	*side 	= mix_inp_**side + mix_out_*(left - right)*0.5f;
+
+	return;
+}
+
 void GSP_Chorus::Printout(uint8_t out_list, int32_t chn_pos, char *printout)
 {
 
@@ -274,3 +319,24 @@ void GSP_Chorus::SetParams(float fn[])
 	return;
 }
 
+int8_t GSP_Chorus::SetParam(uint8_t idx, float value)
+{
+	/*
+    To change a single smoothable parameter (see smooth_params) at the 
+	sampling rate, for parameter ramps.
+		idx
+			parameter index, as in GetParams and SetParams
+		value
+			new value
+	Returns 0, or -1 if the parameter isn't smoothable.
+	*/
+
+	if (((smooth_params >> idx) & 1) == 0) return -1;
+
+	if (idx == 1) SetDepth(value);
+	else if (type_ == CHORUS && idx == 3) SetMixer(value);
+	else SetGain(value);
+
+	return 0;
+}
+
@@ -28,9 +28,12 @@ class GSP_Chorus
 		void 		SetGain(float output_gain);
 		void 		ComputeParameters();
 		int32_t 	Process(int32_t sampl, uint32_t buffer_pointer);
+		void 		SetSpread(float spread_deg);
+		void 		ProcessStereo(int32_t *mid, int32_t *side, uint32_t buffer_pointer);
 		void		Printout(uint8_t out_list, int32_t chn_pos, char *printout);
 		void 		GetParams(float param[]);
 		void 		SetParams(float param[]);
+		int8_t 		SetParam(uint8_t idx, float value);
 
 		uint32_t 	sample_rate;	// sampling rate
 		uint8_t   	state;
@@ -38,7 +41,9 @@ class GSP_Chorus
 		float     	mixer;
 		float     	gain;
 		float     	depth;
+		float 		spread; 		// right channel LFO phase offset (degrees)
 		uint8_t 	number_params = 8;
+		uint8_t 	smooth_params; 	// parameters with ramps (bit mask)
 		LowFreqOsc  lfo;
 
 	private:
@@ -48,6 +53,7 @@ class GSP_Chorus
 		float     	amplit_;
 		float     	mix_inp_, mix_out_;
 		uint32_t  	shift_;
+		float 		offset_; 		// spread in LFO table steps
 };
 
 
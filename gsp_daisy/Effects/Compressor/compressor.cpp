@@ -1,5 +1,6 @@
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "guitar_dsp.h"
 #include "compressor.h"
@@ -15,11 +16,20 @@ void GSP_Compressor::Init(uint32_t sampling_rate)
 	*/
 
 	sample_rate 	= sampling_rate;
+	env_ 			= 0.;
+	gain_ 			= 1.;
+	dgain_ 			= 0.;
+	count_ 			= 0;
+	la_len_ 		= 0;
+	level_ 			= NULL;
 	
 	SetAttackMilliSeconds(10.);
 	SetReleaseMilliSeconds(1000.);
 	SetGainDB(20);
 	SetThresholdDB(40);
+	SetEngine(CMP_CLASSIC);
+	SetKneeDB(6.);
+	SetLookAheadMilliSeconds(0.);
 	Switch(GSP_OFF);
 	
 	return;
@@ -146,6 +156,78 @@ void  GSP_Compressor::SetThresholdDB(uint32_t thrsd)
 	return;
 }
 
+void GSP_Compressor::SetEngine(float eng)
+{
+	/*
+	Set the Compressor engine. The classic engine has a feedback peak 
+	detector and table gains (2:1 above the threshold). The feed-forward
+	engines have a peak or RMS detector and a soft knee (also 2:1), with
+	the gain computed every CMP_BLOCK samples and ramped in between.
+		eng
+			Classic (0), Peak (1) or RMS (2)
+	*/
+
+	engine 		= (uint8_t)fminf(fmaxf(eng + 0.5, 0), CMP_ENGINES - 1);
+
+	return;
+}
+
+void GSP_Compressor::SetKneeDB(float knee)
+{
+	/*
+	Set the soft knee width of the feed-forward engines: the ratio changes
+	smoothly from 1:1 to 2:1 within knee/2 dB around the threshold.
+		knee
+			knee width in dB: 0 (hard knee) to 24.
+	*/
+
+	knee_db 	= fmaxf(fminf(knee, 24), 0);
+
+	return;
+}
+
+void GSP_Compressor::SetLookAheadMilliSeconds(float la_ms)
+{
+	/*
+	Set the look-ahead of the feed-forward engines: the signal is delayed,
+	so the gain is reduced before the attacks reach the output. The line
+	is cleared if its length changes.
+		la_ms
+			look-ahead in milliseconds: 0 (off) to 5.
+	*/
+
+	uint32_t 	len;
+
+	lookahead_ms 	= fmaxf(fminf(la_ms, 5), 0);
+	len 			= lookahead_ms*sample_rate/1000.;
+	if (len > CMP_LOOKAHEAD) len 	= CMP_LOOKAHEAD;
+
+	if (len != la_len_)
+	{
+		memset(la_buf_, 0, sizeof(la_buf_));
+		la_len_ 	= len;
+		la_pos_ 	= 0;
+	}
+
+	return;
+}
+
+void GSP_Compressor::SetLevel(const float *level)
+{
+	/*
+	To use a detector of the Level Detector instead of the own one, so
+	several effects can share it. The shared envelope is updated once per
+	block, and the RMS engine takes its square as the mean square.
+		level
+			pointer to the envelope (0 to ADC_HALFRES), or NULL for the
+			own detector
+	*/
+
+	level_ 		= level;
+
+	return;
+}
+
 void GSP_Compressor::Switch(uint8_t mode)
 {
 	/*
@@ -170,19 +252,41 @@ int32_t GSP_Compressor::Process(int32_t sampl)
 		Compressor.Process
 			Processed output
 	*/
+
+	return Process(sampl, sampl);
+}
+
+int32_t GSP_Compressor::Process(int32_t sampl, int32_t key)
+{
+	/*
+    To compute the Compressor effect with a side-chain: the gain follows the
+	level of the key signal.
+		sampl:
+			Input sample
+		key:
+			Key (side-chain) sample
+		Compressor.Process
+			Processed output
+	*/
  
-    static int32_t 	k;
-	static float 	xL, yt, xG, yG, sout;
+    int32_t 	k;
+	float 	xL, yt, xG, yG, sout;
+
+	if (engine != CMP_CLASSIC) return ProcessFF(sampl, key);
 
-    if (sampl >= 0) xL 		= sampl - T_;
-    else xL 	= -sampl - T_;
+    if (level_ != NULL) yL_ 	= *level_ - T_; // shared level detector
+    else
+    {
+        if (key >= 0) xL 		= key - T_;
+        else xL 	= -key - T_;
  
-    yt 		= alfa_rel_*(y1_ - xL) + xL; // release level detector
+        yt 		= alfa_rel_*(y1_ - xL) + xL; // release level detector
 
-    if (xL > yt) y1_ 		= xL;
-    else y1_ 	= yt;
+        if (xL > yt) y1_ 		= xL;
+        else y1_ 	= yt;
 
-    yL_ 	= alfa_atk_*(yL_ - y1_) + y1_; // attack level detector
+        yL_ 	= alfa_atk_*(yL_ - y1_) + y1_; // attack level detector
+    }
     k		= yL_*yL2i_;
    
     if (k < 0) k 	= 0;
@@ -203,6 +307,95 @@ int32_t GSP_Compressor::Process(int32_t sampl)
 	return (int32_t)sout;
 }
 
+int32_t GSP_Compressor::ProcessFF(int32_t sampl, int32_t key)
+{
+	/*
+    To compute the feed-forward engines. The detector runs every sample,
+	while the gain computer (logarithm and exponential) runs once per 
+	block of CMP_BLOCK samples, and the gain is ramped towards its result.
+		sampl:
+			Input sample
+		key:
+			Key (side-chain) sample
+		Compressor.ProcessFF
+			Processed output
+	*/
+
+	float 	x, a, lv;
+
+	if (level_ != NULL)
+	{
+		// RMS engine: the detector should be in RMS mode (lvc), a peak
+		// detector gives the Peak engine response
+		env_ 	= *level_;
+		if (engine == CMP_RMS) env_ 	= env_*env_;
+	}
+	else
+	{
+		x 		= (float)key;
+		if (engine == CMP_RMS) x 	= x*x;
+		else x 	= fabsf(x);
+
+		a 		= x > env_ ? alfa_atk_ : alfa_rel_;
+		env_ 	= a*(env_ - x) + x;
+	}
+
+	if (count_ == 0)
+	{
+		// level in dBFS (20*log10(2) = 6.0206, 20*log10(32768) = 90.309)
+		lv 		= FastLog2(fmaxf(env_, 1.f));
+		if (engine == CMP_RMS) lv 	= 3.0103f*lv - 90.309f;
+		else lv 	= 6.0206f*lv - 90.309f;
+
+		count_ 	= CMP_BLOCK;
+		a 		= GainComputer(lv, TdB_, knee_db, Rinv_);
+		a 		= FastExp2(0.16609640f*a); 		// 10^(a/20)
+		dgain_ 	= (a - gain_)*(1.f/CMP_BLOCK);
+	}
+	count_--;
+	gain_ 	+= dgain_;
+
+	if (la_len_ > 0)
+	{
+		x 					= la_buf_[la_pos_];
+		la_buf_[la_pos_] 	= sampl;
+		if (++la_pos_ >= la_len_) la_pos_ 	= 0;
+	}
+	else x 	= sampl;
+
+	return (int32_t)(M_*gain_*x);
+}
+
+float GSP_Compressor::GainComputer(float level_db, float thrsd_db, 
+	float knee, float ratio_inv)
+{
+	/*
+	Static gain computer of the feed-forward engines (also used by the 
+	multiband compressor), with a soft knee.
+		level_db
+			detector level (dBFS)
+		thrsd_db
+			threshold (dBFS, negative)
+		knee
+			knee width (dB)
+		ratio_inv
+			inverse of the compression ratio
+	Returns the gain change in dB (up to 0).
+	*/
+
+	float 	d, t;
+
+	d 		= level_db - thrsd_db;
+	if (2*d <= -knee) return 0;
+	if (2*d < knee)
+	{
+		t 	= d + 0.5f*knee;
+		return (ratio_inv - 1)*t*t/(2*knee);
+	}
+
+	return (ratio_inv - 1)*d;
+}
+
 void GSP_Compressor::Printout(uint8_t out_list, int32_t chn_pos, char *printout)
 {
     if (out_list == 0)
@@ -211,15 +404,18 @@ void GSP_Compressor::Printout(uint8_t out_list, int32_t chn_pos, char *printout)
 	    "| Attack (20-2000)(ms): %-.1f "
         "| Release (20-2000)(ms): %-.1f "
 	    "| Gain (0-80)(dB): %ld "
-    	"| Threshold (0-80)(dB): %ld\n", 
+    	"| Threshold (0-80)(dB): %ld "
+	    "| Engine: Classic(0)|Peak(1)|RMS(2) %d "
+	    "| Knee (0-24)(dB): %-.1f "
+	    "| Look-ahead (0-5)(ms): %-.1f\n", 
         chn_pos, state, attack_ms, release_ms, 
-        gain_db, threshold_db);
+        gain_db, threshold_db, engine, knee_db, lookahead_ms);
     }
     if (out_list == 1)
     {
-        sprintf(printout, "->CMP (%ld) %d %-.1f %-.1f %ld %ld\n", 
+        sprintf(printout, "->CMP (%ld) %d %-.1f %-.1f %ld %ld %d %-.1f %-.1f\n", 
         chn_pos, state, attack_ms, release_ms, 
-        gain_db, threshold_db);
+        gain_db, threshold_db, engine, knee_db, lookahead_ms);
     }
 	
 	return;
@@ -233,6 +429,9 @@ void GSP_Compressor::GetParams(float fn[])
 	fn[2]   = release_ms;
 	fn[3]   = gain_db;
 	fn[4]   = threshold_db;
+	fn[5]   = engine;
+	fn[6]   = knee_db;
+	fn[7]   = lookahead_ms;
 	
 	return;
 }
@@ -245,6 +444,31 @@ void GSP_Compressor::SetParams(float fn[])
 	SetReleaseMilliSeconds(fn[2]);
 	SetGainDB(fn[3]);
 	SetThresholdDB(fn[4]);
+	SetEngine(fn[5]);
+	SetKneeDB(fn[6]);
+	SetLookAheadMilliSeconds(fn[7]);
 
 	return;
 }
+
+int8_t GSP_Compressor::SetParam(uint8_t idx, float value)
+{
+	/*
+    To change a single smoothable parameter (see smooth_params) at the 
+	sampling rate, for parameter ramps. The gain is
+	not rounded to whole decibels.
+		idx
+			parameter index, as in GetParams and SetParams
+		value
+			new value
+	Returns 0, or -1 if the parameter isn't smoothable.
+	*/
+
+	if (((smooth_params >> idx) & 1) == 0) return -1;
+
+	value 		= fmaxf(fminf(value, 80), 0);
+	gain_db 	= value + 0.5;
+	M_ 			= powf(10, value/20);
+
+	return 0;
+}
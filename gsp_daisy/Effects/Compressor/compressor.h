@@ -3,6 +3,16 @@
 #define GSP_COMPRESSOR
 
 #define NDB 	512
+#define CMP_BLOCK 		8 		// gain computer period (samples)
+#define CMP_LOOKAHEAD 	512 	// look-ahead line (samples, 5 ms at 96 kHz)
+
+enum cmp_engines
+{
+	CMP_CLASSIC 	= 0, 		// feedback peak detector, table gain (classic sound)
+	CMP_PEAK 		= 1, 		// feed-forward peak detector, soft knee
+	CMP_RMS 		= 2, 		// feed-forward RMS detector, soft knee
+	CMP_ENGINES,
+};
 
 class GSP_Compressor
 {
@@ -17,17 +27,29 @@ class GSP_Compressor
 		void 		SetReleaseMilliSeconds(float rel_ms);
 		void 		SetGainDB(uint32_t gain);
 		void 		SetThresholdDB(uint32_t thrsd);
+		void 		SetEngine(float eng);
+		void 		SetKneeDB(float knee);
+		void 		SetLookAheadMilliSeconds(float la_ms);
+		void 		SetLevel(const float *level);
 		void 		Switch(uint8_t mode);
 		int32_t 	Process(int32_t sampl);
+		int32_t 	Process(int32_t sampl, int32_t key);
 		void		Printout(uint8_t out_list, int32_t chn_pos, char *printout);
 		void 		GetParams(float param[]);
 		void 		SetParams(float param[]);
+		int8_t 		SetParam(uint8_t idx, float value);
+		static float 	GainComputer(float level_db, float thrsd_db, 
+						float knee, float ratio_inv);
 
 		uint32_t 	sample_rate;	// sampling rate
 		uint32_t	gain_db;
 		int32_t   	threshold_db;
 		float     	attack_ms, release_ms;
-		uint8_t 	number_params = 5;
+		uint8_t 	engine; 		// see enum cmp_engines
+		float 		knee_db; 		// soft knee width
+		float 		lookahead_ms;
+		uint8_t 	number_params = 8;
+		uint8_t 	smooth_params = (1 << 3); 	// parameters with ramps (bit mask)
 		uint8_t 	state;
 
 	private:
@@ -37,8 +59,17 @@ class GSP_Compressor
 		float   	y1_, yL_;
 		float 		Rinv_;
 		float   	alfa_atk_, alfa_rel_;
+		const float *level_; 		// shared detector (or NULL)
 		float 		yL2i_, cB2i_;
 		float   	lgyt_[NDB], ex10_[NDB];
+
+		// feed-forward engines
+		int32_t 	ProcessFF(int32_t sampl, int32_t key);
+		float 		env_; 			// detector: peak level or mean square
+		float 		gain_, dgain_; 	// gain ramp of the current block
+		uint32_t 	count_; 		// samples to the next gain computation
+		int32_t 	la_buf_[CMP_LOOKAHEAD];
+		uint32_t 	la_len_, la_pos_;
 };
 
 #endif 	// GSP_COMPRESSOR 	Compressor 
@@ -24,14 +24,19 @@ void GSP_DelayFB::Init(uint32_t sampling_rate, int16_t *ptr_buffer, uint32_t buf
 
 	sample_rate 	= sampling_rate;
 	ptr_buffer_ 	= ptr_buffer;
+	ptr_right_ 		= NULL;
+	ptr_tail_ 		= NULL;
 	buffer_size_ 	= buffer_size;
 	gain 			= 1.;
+	spillover 		= 0;
+	tail 			= 0;
 	
 	if(type_ == DELAY_FB) SetDelayMilliSeconds(31.);
 	if (type_ == ECHO_FB) SetDelayMilliSeconds(1000.);
 	
 	SetDecayRate(0.7);
 	SetGain(1.);
+	SetSpread(0);
 	Switch(GSP_OFF);
 	
 	return;
@@ -111,11 +116,21 @@ void GSP_DelayFB::SetGain(float output_gain)
 void GSP_DelayFB::Switch(uint8_t mode)
 {
 	/*
-    To switch the effect on and off.
+    To switch the effect on and off. With spillover, the delay tail keeps
+	ringing after the effect is switched off (see Tail).
 		mode
 			Condition switch: ON or OFF
 	*/
 
+	if (mode == GSP_OFF && state == GSP_ON && spillover)
+	{
+		tail_peak_ 	= 0;
+		tail_count_ = 0;
+		tail_age_ 	= 0;
+		tail 		= 1;
+	}
+	if (mode != GSP_OFF) tail 	= 0;
+
 	state 		= GSP_ON;
 	if (mode == GSP_OFF) state = GSP_OFF;
 
@@ -154,6 +169,162 @@ int32_t GSP_DelayFB::Process(int32_t sampl, uint32_t buffer_pointer)
 	return out_sampl_;
 }
 
+int32_t GSP_DelayFB::Tail(int32_t sampl, uint32_t buffer_pointer)
+{
+	/*
+    To compute the Feedback Delay tail, after the effect is switched off
+	with spillover. The delay line runs with no input: along the first 
+	delay time it reads the repetitions left in the main buffer, then its 
+	own output, kept in the tail buffer (see SetTailBuffer). The main 
+	buffer gets the input plus the tail, as when the effect is on, so the 
+	effects reading it later still find the by-passed signal. Without a 
+	tail buffer the tail recirculates in the main buffer. The tail stops 
+	(tail = 0) when its peak stays below GSP_TAIL_LEVEL along a whole 
+	delay time.
+		sampl:
+			Input sample (by-passed)
+		buffer_pointer
+			buffer pointer (must be updated by user, once per sample)
+		Delay_FB.Tail
+			Input sample plus tail
+	*/
+
+	if (buffer_pointer >= delay_samples_)
+	{
+		delay_pointer_	= buffer_pointer - delay_samples_;
+	}
+	else
+	{
+		delay_pointer_	= buffer_size_ + buffer_pointer - delay_samples_;
+	}
+
+	if (ptr_tail_ == NULL)
+	{
+		out_sampl_ 		= decay_rate*(*(ptr_buffer_ + delay_pointer_));
+		ptr_buffer_[buffer_pointer]	= (int16_t)out_sampl_;
+	}
+	else
+	{
+		if (tail_age_ < delay_samples_)
+		{
+			out_sampl_ 	= decay_rate*(*(ptr_buffer_ + delay_pointer_));
+			tail_age_++;
+		}
+		else out_sampl_ 	= decay_rate*(*(ptr_tail_ + delay_pointer_));
+		ptr_tail_[buffer_pointer]	= (int16_t)out_sampl_;
+	}
+
+	if (out_sampl_ > tail_peak_) tail_peak_ 	= out_sampl_;
+	if (-out_sampl_ > tail_peak_) tail_peak_ 	= -out_sampl_;
+	tail_count_++;
+	if (tail_count_ >= delay_samples_)
+	{
+		if (tail_peak_ < GSP_TAIL_LEVEL) tail 	= 0;
+		tail_peak_ 	= 0;
+		tail_count_ = 0;
+	}
+
+	out_sampl_ 		+= sampl;
+	if (out_sampl_ > ADC_MAXVAL) out_sampl_ = ADC_MAXVAL;
+	if (out_sampl_ < ADC_MINVAL) out_sampl_ = ADC_MINVAL;
+	if (ptr_tail_ != NULL) ptr_buffer_[buffer_pointer]	= (int16_t)out_sampl_;
+
+	return out_sampl_;
+}
+
+void GSP_DelayFB::SetStereoBuffer(int16_t *ptr_buffer)
+{
+	/*
+    To set the buffer of the right delay line, used in ping-pong mode.
+		*ptr_buffer
+			buffer with the same size of the main buffer. It can be shared
+			by the Delay and Echo instances.
+	*/
+
+	ptr_right_ 		= ptr_buffer;
+
+	return;
+}
+
+void GSP_DelayFB::SetTailBuffer(int16_t *ptr_buffer)
+{
+	/*
+    To set the buffer of the tail delay line, used after a switch off with 
+	spillover.
+		*ptr_buffer
+			buffer with the same size of the main buffer, owned by this 
+			instance
+	*/
+
+	ptr_tail_ 		= ptr_buffer;
+
+	return;
+}
+
+void GSP_DelayFB::SetSpread(float ping_pong)
+{
+	/*
+    To set the stereo mode of the Feedback Delay.
+		ping_pong
+			0: repetitions on both channels, 1: repetitions bounce between 
+			left and right (needs SetStereoBuffer)
+	*/
+
+	spread 		= (ping_pong > 0.5);
+
+	return;
+}
+
+void GSP_DelayFB::ProcessStereo(int32_t *mid, int32_t *side, uint32_t buffer_pointer)
+{
+	/*
+    To compute the Feedback Delay effect on a stereo signal, in mid/side 
+	form. The main buffer is updated here (no need to store the output).
+	In ping-pong mode two delay lines feed each other:
+		left[n] 	= scale*mid + decay*right[n - delay] 	(main buffer)
+		right[n] 	= decay*left[n - delay] 				(right buffer)
+		mid, side:
+			Input and processed mid (L+R)/2 and side (L-R)/2 samples
+		buffer_pointer
+			buffer pointer (must be updated by user, once per sample)
+	*/
+
+	int32_t 	left, right;
+
+	if (spread == 0 || ptr_right_ == NULL)
+	{
+		*mid 	= Process(*mid, buffer_pointer);
+		*side 	= scale_**side;
+		ptr_buffer_[buffer_pointer]	= (int16_t)*mid;
+		return;
+	}
+
+	if (buffer_pointer >= delay_samples_)
+	{
+		delay_pointer_	= buffer_pointer - delay_samples_;
+	}
+	else
+	{
+		delay_pointer_	= buffer_size_ + buffer_pointer - delay_samples_;
+	}
+
+	left 		= scale_**mid + decay_rate*(*(ptr_right_ + delay_pointer_));
+	right 		= decay_rate*(*(ptr_buffer_ + delay_pointer_));
+	if (left > ADC_MAXVAL) left = ADC_MAXVAL;
+	if (left < ADC_MINVAL) left = ADC_MINVAL;
+
+	ptr_buffer_[buffer_pointer]	= (int16_t)left;
+	ptr_right_[buffer_pointer]	= (int16_t)right;
+
+	left 		+= scale_**side;
+	right 		+= scale_*(*mid - *side);
+
+	*mid 	= (left + right)/2;
+	*side 	= (left - right)/2;
+
+	return;
+}
+
 void GSP_DelayFB::Printout(uint8_t out_list, int32_t chn_pos, char *printout)
 {
 
@@ -165,16 +336,17 @@ void GSP_DelayFB::Printout(uint8_t out_list, int32_t chn_pos, char *printout)
     		"->DFB (%ld): OFF(0)|ON(1) %d "
 	    	"| Delay Time (0.2-100)(ms): %-.1f "
 		    "| Decay rate (0-0.95): %-.3f "
-    		"| Gain (0-1): %-.3f\n", 
+    		"| Gain (0-1): %-.3f "
+    		"| Spillover (0-1): %d\n", 
 	    	chn_pos, state, delay_ms, decay_rate, 
-		    gain);
+		    gain, spillover);
         }
         if (out_list == 1)
         {
 		    sprintf(printout, 
-    		"->DFB (%ld) %d %-.1f %-.3f %-.3f\n", 
+    		"->DFB (%ld) %d %-.1f %-.3f %-.3f %d\n", 
 	    	chn_pos, state, delay_ms, decay_rate, 
-		    gain);
+		    gain, spillover);
         }
 	}
 	if (type_ == ECHO_FB)
@@ -185,16 +357,17 @@ void GSP_DelayFB::Printout(uint8_t out_list, int32_t chn_pos, char *printout)
 	    	"->EFB (%ld): OFF(0)|ON(1) %d "
 		    "| Delay Time (50-)(ms): %-.1f "
     		"| Decay rate (0-0.95): %-.3f "
-	    	"| Gain (0-1): %-.3f\n", 
+	    	"| Gain (0-1): %-.3f "
+	    	"| Spillover (0-1): %d\n", 
 		    chn_pos, state, delay_ms, decay_rate, 
-    		gain);
+    		gain, spillover);
         }
         if (out_list == 1)
         {
 		    sprintf(printout, 
-    		"->EFB (%ld) %d %-.1f %-.3f %-.3f\n", 
+    		"->EFB (%ld) %d %-.1f %-.3f %-.3f %d\n", 
 	    	chn_pos, state, delay_ms, decay_rate, 
-		    gain);
+		    gain, spillover);
         }
 	}
 	
@@ -208,6 +381,7 @@ void GSP_DelayFB::GetParams(float fn[])
 	fn[1]   = delay_ms;
 	fn[2]   = decay_rate;
 	fn[3]   = gain;
+	fn[4]   = spillover;
 	
 	return;
 }
@@ -215,6 +389,7 @@ void GSP_DelayFB::GetParams(float fn[])
 void GSP_DelayFB::SetParams(float fn[])
 {
 
+	spillover 	= (fn[4] > 0.5);
 	Switch(fn[0]);
 	if (type_ == DELAY_FB) fn[1]   = fminf(fn[1], 100);
 	if (type_ == ECHO_FB) fn[1]   = fmaxf(fn[1], 50);
@@ -225,4 +400,24 @@ void GSP_DelayFB::SetParams(float fn[])
 	return;
 }
 
+int8_t GSP_DelayFB::SetParam(uint8_t idx, float value)
+{
+	/*
+    To change a single smoothable parameter (see smooth_params) at the 
+	sampling rate, for parameter ramps.
+		idx
+			parameter index, as in GetParams and SetParams
+		value
+			new value
+	Returns 0, or -1 if the parameter isn't smoothable.
+	*/
+
+	if (((smooth_params >> idx) & 1) == 0) return -1;
+
+	if (idx == 2) SetDecayRate(value);
+	else SetGain(value);
+
+	return 0;
+}
+
 
@@ -26,24 +26,39 @@ class GSP_DelayFB
 		void 		SetGain(float output_gain);
 		void 		Switch(uint8_t mode);
 		int32_t 	Process(int32_t sampl, uint32_t buffer_pointer);
+		int32_t 	Tail(int32_t sampl, uint32_t buffer_pointer);
+		void 		SetStereoBuffer(int16_t *ptr_buffer);
+		void 		SetTailBuffer(int16_t *ptr_buffer);
+		void 		SetSpread(float ping_pong);
+		void 		ProcessStereo(int32_t *mid, int32_t *side, uint32_t buffer_pointer);
 		void		Printout(uint8_t out_list, int32_t chn_pos, char *printout);
 		void 		GetParams(float param[]);
 		void 		SetParams(float param[]);
+		int8_t 		SetParam(uint8_t idx, float value);
 		
 		uint32_t 	sample_rate;	// sampling rate
 		uint8_t   	state;
 		float   	delay_ms;
 		float     	gain = 1.;
 		float     	decay_rate;
-		uint8_t 	number_params = 4;
+		uint8_t 	spillover; 		// tail rings after switched off
+		uint8_t 	tail; 			// tail ringing
+		float 		spread; 		// ping-pong (0 or 1)
+		uint8_t 	number_params = 5;
+		uint8_t 	smooth_params = (1 << 2) | (1 << 3); 	// parameters with ramps (bit mask)
 		
 	private:
 		uint32_t  	delay_samples_;
 		int16_t 	*ptr_buffer_;
+		int16_t 	*ptr_right_; 	// right delay line (ping-pong)
+		int16_t 	*ptr_tail_; 	// tail delay line (spillover)
 		uint32_t 	buffer_size_;
 		uint32_t 	delay_pointer_;
 		int32_t 	out_sampl_;
 		float 		scale_;
+		int32_t 	tail_peak_;
+		uint32_t 	tail_count_;
+		uint32_t 	tail_age_; 		// samples since switched off
 };
 
 #endif 	// GPS_DELAYFB 	Feedback Delay
@@ -24,6 +24,11 @@ void GSP_DelayFF::Init(uint32_t sampling_rate, int16_t *ptr_buffer, uint32_t buf
 	
 	repeats = 4;
 	gain 	= 1;
+	spillover 	= 0;
+	tail 		= 0;
+	comb_ 		= NULL;
+	engine 		= FF_COMB;
+	next_pointer_ 	= 0;
 	
 	if(type_ == DELAY_FF) SetDelayMilliSeconds(31.);
 	if(type_ == ECHO_FF) SetDelayMilliSeconds(1000.);
@@ -31,6 +36,7 @@ void GSP_DelayFF::Init(uint32_t sampling_rate, int16_t *ptr_buffer, uint32_t buf
 	SetRepeats(4);
 	SetDecayRate(0.9);
 	SetGain(1.);
+	SetSpread(0);
 	Switch(GSP_OFF);
 	
 	return;
@@ -48,6 +54,8 @@ void GSP_DelayFF::SetDelaySamples(uint32_t dly_spl)
 
 	delay_samples_ 	= fmax(fmin(dly_spl, buffer_size_/repeats - 1), 10);
 	delay_ms 		= (float)delay_samples_/sample_rate*1000.;
+	span_ 			= repeats*delay_samples_;
+	warm_ 			= delay_samples_;
 
 	return;
 }
@@ -79,6 +87,8 @@ void GSP_DelayFF::SetDecayRate(float decay)
 	*/
 
 	decay_rate 		= fmaxf(fminf(decay, 1.), 0.);
+	decay_pow_ 		= powf(decay_rate, repeats);
+	warm_ 			= delay_samples_;
 	SetGain(gain);
 	
 	return;
@@ -116,6 +126,7 @@ void GSP_DelayFF::SetRepeats(uint32_t rpts)
 	*/
 
 	repeats 	= fmax(fmin(rpts, 8), 1);
+	decay_pow_ 	= powf(decay_rate, repeats);
 	
 	SetDelaySamples(delay_samples_);
 	SetGain(gain);
@@ -123,14 +134,55 @@ void GSP_DelayFF::SetRepeats(uint32_t rpts)
 	return;
 }
 
+void GSP_DelayFF::SetEngine(uint8_t eng)
+{
+	/*
+    To select how the repetitions are computed.
+		eng
+			FF_TAPS: one buffer read per repetition, so the cost grows
+			with the number of repeats (reference).
+			FF_COMB: recursive comb with a cancelling tap at repeats 
+			times the delay, so the cost is the same for any number of
+			repeats. Needs a comb line (SetCombBuffer).
+	*/
+
+	engine 		= eng == FF_TAPS ? FF_TAPS : FF_COMB;
+	warm_ 		= delay_samples_;
+
+	return;
+}
+
+void GSP_DelayFF::SetCombBuffer(float *comb_buffer)
+{
+	/*
+    To give the comb line of the FF_COMB engine, with the same size as the
+	delay buffer (or NULL, to use only FF_TAPS).
+		comb_buffer
+			comb line
+	*/
+
+	comb_ 		= comb_buffer;
+	warm_ 		= delay_samples_;
+
+	return;
+}
+
 void GSP_DelayFF::Switch(uint8_t mode)
 {
 	/*
-    To switch the effect on and off.
+    To switch the effect on and off. With spillover, the repetitions of the
+	samples taken before the switch off are still played (see Tail).
 		mode
 			Condition switch: ON or OFF
 	*/
 
+	if (mode == GSP_OFF && state == GSP_ON && spillover && repeats > 1)
+	{
+		tail_count_ = 0;
+		tail 		= 1;
+	}
+	if (mode != GSP_OFF) tail 	= 0;
+
 	state 		= GSP_ON;
 	if (mode == GSP_OFF) state = GSP_OFF;
 
@@ -141,38 +193,171 @@ void GSP_DelayFF::Switch(uint8_t mode)
 int32_t GSP_DelayFF::Process(int32_t sampl, uint32_t buffer_pointer)
 {
 	/*
-    To compute the Feedback Delay effect.
+    To compute the Feedforward Delay effect. The repetitions 1 to repeats-1
+	of the buffer samples, echo[n] = sum(decay^k*x[n - k*delay]), are 
+	summed tap by tap (FF_TAPS), or by the recursive comb (FF_COMB)
+		echo[n] = decay*(x[n - delay] + echo[n - delay]) 
+			- decay^repeats*x[n - repeats*delay]
+	whose last term cancels the repetitions beyond the last one. The comb
+	runs on the taps during one delay time after any change of delay, 
+	decay or repeats, or a gap in the buffer pointer, until its line holds 
+	a whole delay time of valid values.
 		sampl:
 			Input sample
-		Delay_FB.Process
+		buffer_pointer
+			buffer pointer (must be updated by user, once per sample)
+		Delay_FF.Process
 			Processed output
 	*/
   
-	static int32_t out_sampl;
-	static uint32_t i;
-	static float   gn;
-  
-	out_sampl   	= scale_*sampl;
+	int32_t out_sampl;
+	uint32_t i, span_pointer;
+	float   gn, echo;
 
+	if (buffer_pointer != next_pointer_) warm_ 	= delay_samples_;
+	next_pointer_ 	= buffer_pointer + 1;
+	if (next_pointer_ == buffer_size_) next_pointer_ 	= 0;
+  
 	if (buffer_pointer >= delay_samples_) delay_pointer_     = buffer_pointer - delay_samples_;
 	else delay_pointer_	= buffer_size_ - delay_samples_ + buffer_pointer;
+
+	if (engine == FF_COMB && comb_ != NULL && warm_ == 0)
+	{
+		if (buffer_pointer >= span_) span_pointer 	= buffer_pointer - span_;
+		else span_pointer 	= buffer_size_ - span_ + buffer_pointer;
+
+		echo 		= decay_rate*(ptr_buffer_[delay_pointer_] + comb_[delay_pointer_]) 
+			- decay_pow_*ptr_buffer_[span_pointer];
+	}
+	else
+	{
+		echo 		= 0;
+		gn    		= 1;
+  
+		for (i = 1; i < repeats; i++) 
+		{
+			gn  		*= decay_rate;
+			echo  		+= gn*(*(ptr_buffer_ + delay_pointer_));
+			if (delay_pointer_ >= delay_samples_) delay_pointer_ 	-= delay_samples_;
+			else delay_pointer_ 	+= buffer_size_ - delay_samples_;
+		}
+		if (warm_ > 0) warm_--;
+	}
+	if (comb_ != NULL) comb_[buffer_pointer] 	= echo;
+
+	out_sampl   	= scale_*(sampl + echo);
+  
+	if (out_sampl > ADC_MAXVAL) out_sampl = ADC_MAXVAL;
+	if (out_sampl < ADC_MINVAL) out_sampl = ADC_MINVAL;
 	
+	return out_sampl;
+}
+
+int32_t GSP_DelayFF::Tail(int32_t sampl, uint32_t buffer_pointer)
+{
+	/*
+    To compute the Feedforward Delay tail, after the effect is switched off
+	with spillover. Only the repetitions of samples older than the switch 
+	off are added, so the tail ends (tail = 0) after (repeats - 1) delay 
+	times.
+		sampl:
+			Input sample (by-passed)
+		buffer_pointer
+			buffer pointer (must be updated by user, once per sample)
+		Delay_FF.Tail
+			Input sample plus tail
+	*/
+
+	int32_t 	out_sampl;
+	uint32_t 	i;
+	float 		gn;
+
+	out_sampl   	= sampl;
+
+	if (buffer_pointer >= delay_samples_) delay_pointer_     = buffer_pointer - delay_samples_;
+	else delay_pointer_	= buffer_size_ - delay_samples_ + buffer_pointer;
+
 	gn    		= scale_;
-  
+
 	for (i = 1; i < repeats; i++) 
 	{
 		gn  		*= decay_rate;
-		out_sampl  	+= gn*(*(ptr_buffer_ + delay_pointer_));
+		if (i*delay_samples_ > tail_count_) out_sampl  	+= gn*(*(ptr_buffer_ + delay_pointer_));
 		if (delay_pointer_ >= delay_samples_) delay_pointer_ 	-= delay_samples_;
 		else delay_pointer_ 	+= buffer_size_ - delay_samples_;
 	}
-  
+
+	tail_count_++;
+	if (tail_count_ >= (repeats - 1)*delay_samples_) tail 	= 0;
+
 	if (out_sampl > ADC_MAXVAL) out_sampl = ADC_MAXVAL;
 	if (out_sampl < ADC_MINVAL) out_sampl = ADC_MINVAL;
-	
+
 	return out_sampl;
 }
 
+void GSP_DelayFF::SetSpread(float ping_pong)
+{
+	/*
+    To set the stereo mode of the Feedforward Delay.
+		ping_pong
+			0: repetitions on both channels, 1: repetitions alternate 
+			between left (odd) and right (even)
+	*/
+
+	spread 		= (ping_pong > 0.5);
+
+	return;
+}
+
+void GSP_DelayFF::ProcessStereo(int32_t *mid, int32_t *side, uint32_t buffer_pointer)
+{
+	/*
+    To compute the Feedforward Delay effect on a stereo signal, in mid/side
+	form. Without ping-pong the repetitions go to the mid only.
+		mid, side:
+			Input and processed mid (L+R)/2 and side (L-R)/2 samples
+		buffer_pointer
+			buffer pointer (must be updated by user, once per sample)
+	*/
+
+	int32_t 	out_left, out_right;
+	uint32_t 	i;
+	float 		gn;
+
+	if (spread == 0)
+	{
+		*mid 	= Process(*mid, buffer_pointer);
+		*side 	= scale_**side;
+		return;
+	}
+
+	out_left 	= 0;
+	out_right 	= 0;
+
+	if (buffer_pointer >= delay_samples_) delay_pointer_     = buffer_pointer - delay_samples_;
+	else delay_pointer_	= buffer_size_ - delay_samples_ + buffer_pointer;
+
+	gn    		= scale_;
+
+	for (i = 1; i < repeats; i++) 
+	{
+		gn  		*= decay_rate;
+		if (i & 1) out_left 	+= gn*(*(ptr_buffer_ + delay_pointer_));
+		else out_right 	+= gn*(*(ptr_buffer_ + delay_pointer_));
+		if (delay_pointer_ >= delay_samples_) delay_pointer_ 	-= delay_samples_;
+		else delay_pointer_ 	+= buffer_size_ - delay_samples_;
+	}
+
+	*mid 	= scale_**mid + (out_left + out_right)/2;
+	*side 	= scale_**side + (out_left - out_right)/2;
+
+	if (*mid > ADC_MAXVAL) *mid = ADC_MAXVAL;
+	if (*mid < ADC_MINVAL) *mid = ADC_MINVAL;
+
+	return;
+}
+
 void GSP_DelayFF::Printout(uint8_t out_list, int32_t chn_pos, char *printout)
 {
 
@@ -185,16 +370,18 @@ void GSP_DelayFF::Printout(uint8_t out_list, int32_t chn_pos, char *printout)
 		    "| Delay Time (0.2-100)(ms): %-.1f "
     		"| Decay rate (0-1): %-.3f "
 	    	"| Number of repeats (1-8): %ld "
-		    "| Gain (0-1): %-.3f\n", 
+		    "| Gain (0-1): %-.3f "
+		    "| Spillover (0-1): %d "
+		    "| Engine: Taps(0)|Comb(1) %d\n", 
     		chn_pos, state, delay_ms, decay_rate, 
-	    	repeats, gain);
+	    	repeats, gain, spillover, engine);
         }
         if (out_list == 1)
         {
     		sprintf(printout, 
-	    	"->DFF (%ld) %d %-.1f %-.3f %ld %-.3f\n", 
+	    	"->DFF (%ld) %d %-.1f %-.3f %ld %-.3f %d %d\n", 
     		chn_pos, state, delay_ms, decay_rate, 
-	    	repeats, gain);
+	    	repeats, gain, spillover, engine);
         }
  	}
 	if (type_ == ECHO_FF)
@@ -206,16 +393,18 @@ void GSP_DelayFF::Printout(uint8_t out_list, int32_t chn_pos, char *printout)
 		    "| Delay Time (50-)(ms): %-.1f "
     		"| Decay rate (0-1): %-.3f "
 	    	"| Number of repeats (1-8): %ld "
-		    "| Gain (0-1): %-.3f\n", 
+		    "| Gain (0-1): %-.3f "
+		    "| Spillover (0-1): %d "
+		    "| Engine: Taps(0)|Comb(1) %d\n", 
     		chn_pos, state, delay_ms, decay_rate, 
-	    	repeats, gain);
+	    	repeats, gain, spillover, engine);
         }
         if (out_list == 1)
         {
     		sprintf(printout, 
-	    	"->EFF (%ld) %d %-.1f %-.3f %ld %-.3f\n", 
+	    	"->EFF (%ld) %d %-.1f %-.3f %ld %-.3f %d %d\n", 
     		chn_pos, state, delay_ms, decay_rate, 
-	    	repeats, gain);
+	    	repeats, gain, spillover, engine);
         }
 	}
 	return;
@@ -229,6 +418,8 @@ void GSP_DelayFF::GetParams(float fn[])
 	fn[2]   = decay_rate;
 	fn[3]   = repeats;
 	fn[4]   = gain;
+	fn[5]   = spillover;
+	fn[6]   = engine;
 	
 	return;
 }
@@ -236,6 +427,7 @@ void GSP_DelayFF::GetParams(float fn[])
 void GSP_DelayFF::SetParams(float fn[])
 {
 
+	spillover 	= (fn[5] > 0.5);
 	Switch(fn[0]);
     if (type_ == DELAY_FF)	fn[1]   = fminf(fn[1], 100);
     if (type_ == ECHO_FF)	fn[1]   = fmaxf(fn[1], 50);
@@ -243,8 +435,29 @@ void GSP_DelayFF::SetParams(float fn[])
 	SetDecayRate(fn[2]);
 	SetRepeats(fn[3]);
 	SetGain(fn[4]);
+	SetEngine(fn[6] > 0.5 ? FF_COMB : FF_TAPS);
 
 	return;
 }
 
+int8_t GSP_DelayFF::SetParam(uint8_t idx, float value)
+{
+	/*
+    To change a single smoothable parameter (see smooth_params) at the 
+	sampling rate, for parameter ramps.
+		idx
+			parameter index, as in GetParams and SetParams
+		value
+			new value
+	Returns 0, or -1 if the parameter isn't smoothable.
+	*/
+
+	if (((smooth_params >> idx) & 1) == 0) return -1;
+
+	if (idx == 2) SetDecayRate(value);
+	else SetGain(value);
+
+	return 0;
+}
+
 
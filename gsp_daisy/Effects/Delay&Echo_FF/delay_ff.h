@@ -10,6 +10,12 @@ enum delayff
 	ECHO_FF 	= 1,
 };
 
+enum delayff_engines
+{
+	FF_TAPS 	= 0, 		// one buffer read per repetition (reference)
+	FF_COMB 	= 1, 		// recursive comb, constant cost
+};
+
 class GSP_DelayFF
 {
 	private:
@@ -25,11 +31,17 @@ class GSP_DelayFF
 		void 		SetDecayRate(float decay);
 		void 		SetRepeats(uint32_t rpts);
 		void 		SetGain(float output_gain);
+		void 		SetEngine(uint8_t eng);
+		void 		SetCombBuffer(float *comb_buffer);
 		void 		Switch(uint8_t mode);
 		int32_t 	Process(int32_t sampl, uint32_t buffer_pointer);
+		int32_t 	Tail(int32_t sampl, uint32_t buffer_pointer);
+		void 		SetSpread(float ping_pong);
+		void 		ProcessStereo(int32_t *mid, int32_t *side, uint32_t buffer_pointer);
 		void		Printout(uint8_t out_list, int32_t chn_pos, char *printout);
 		void 		GetParams(float param[]);
 		void 		SetParams(float param[]);
+		int8_t 		SetParam(uint8_t idx, float value);
 		
 		uint32_t 	sample_rate;	// sampling rate
 		uint8_t   	state;
@@ -37,7 +49,12 @@ class GSP_DelayFF
 		uint32_t 	repeats;
 		float     	gain;
 		float     	decay_rate;
-		uint8_t 	number_params = 5;
+		uint8_t 	spillover; 		// tail rings after switched off
+		uint8_t 	tail; 			// tail ringing
+		float 		spread; 		// ping-pong (0 or 1)
+		uint8_t 	engine; 		// FF_TAPS or FF_COMB
+		uint8_t 	number_params = 7;
+		uint8_t 	smooth_params = (1 << 2) | (1 << 4); 	// parameters with ramps (bit mask)
 		
 	private:
 		uint32_t  	delay_samples_;
@@ -46,6 +63,12 @@ class GSP_DelayFF
 		uint32_t 	delay_pointer_;
 		int32_t 	out_sampl_;
 		float 		scale_;
+		uint32_t 	tail_count_;
+		float 		*comb_; 		// repetitions 1 to repeats-1, per sample (or NULL)
+		float 		decay_pow_; 	// decay_rate^repeats
+		uint32_t 	span_; 			// repeats*delay_samples_
+		uint32_t 	warm_; 			// samples until the comb line is valid
+		uint32_t 	next_pointer_; 	// expected buffer pointer of the next sample
 };
 
 #endif 	// GPS_DELAY_FF 	Feedback Delay
@@ -137,9 +137,9 @@ int32_t GSP_Detune::Process(int32_t sampl, uint32_t buffer_pointer)
 			Processed output
 	*/
  
-    static int32_t    sout;
-    static uint32_t   pt1, pt2;
-    static float      alfa;
+    int32_t    sout;
+    uint32_t   pt1, pt2;
+    float      alfa;
   
     if (i_ < mp_)
     {
@@ -237,5 +237,28 @@ void GSP_Detune::SetParams(float fn[])
 	return;
 }
 
+int8_t GSP_Detune::SetParam(uint8_t idx, float value)
+{
+	/*
+    To change a single smoothable parameter (see smooth_params) at the 
+	sampling rate, for parameter ramps. The detune
+	windows aren't restarted.
+		idx
+			parameter index, as in GetParams and SetParams
+		value
+			new value
+	Returns 0, or -1 if the parameter isn't smoothable.
+	*/
+
+	if (((smooth_params >> idx) & 1) == 0) return -1;
+
+	if (idx == 2) mixer 	= fmaxf(fminf(value, 1), 0);
+	else gain 	= fmaxf(value, 0.1);
+	outef_ 		= mixer*gain;
+	outsg_ 		= (1 - mixer)*gain;
+
+	return 0;
+}
+
 
 
@@ -20,6 +20,7 @@ class GSP_Detune
 		void		Printout(uint8_t out_list, int32_t chn_pos, char *printout);
 		void 		GetParams(float param[]);
 		void 		SetParams(float param[]);
+		int8_t 		SetParam(uint8_t idx, float value);
 
 		uint32_t 	sample_rate;	// sampling rate
 		float		gain;
@@ -27,6 +28,7 @@ class GSP_Detune
 		float 		mixer;
 		uint8_t 	state;
 		uint8_t 	number_params = 4;
+		uint8_t 	smooth_params = (1 << 2) | (1 << 3); 	// parameters with ramps (bit mask)
 
 	private:
 	
@@ -230,5 +230,28 @@ void GSP_Equalizer::SetParams(float fn[])
 	return;
 }
 
+int8_t GSP_Equalizer::SetParam(uint8_t idx, float value)
+{
+	/*
+    To change a single smoothable parameter (see smooth_params) at the 
+	sampling rate, for parameter ramps. The filter
+	states are kept.
+		idx
+			parameter index, as in GetParams and SetParams
+		value
+			new value
+	Returns 0, or -1 if the parameter isn't smoothable.
+	*/
+
+	if (((smooth_params >> idx) & 1) == 0) return -1;
+
+	value 		= fmaxf(value, 0.);
+	if (idx == 1) gain_low 		= value;
+	else if (idx == 2) gain_medium 	= value;
+	else gain_high 	= value;
+
+	return 0;
+}
+
 
 
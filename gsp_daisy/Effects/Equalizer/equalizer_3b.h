@@ -19,12 +19,14 @@ class GSP_Equalizer
 		void		Printout(uint8_t out_list, int32_t chn_pos, char *printout);
 		void 		GetParams(float param[]);
 		void 		SetParams(float param[]);
+		int8_t 		SetParam(uint8_t idx, float value);
 
 		uint8_t		state;
 		uint32_t 	sample_rate;
 		float		gain_low, gain_medium, gain_high;
 		float		freq_low, freq_high;
 		uint8_t 	number_params = 6;
+		uint8_t 	smooth_params = (1 << 1) | (1 << 2) | (1 << 3); 	// parameters with ramps (bit mask)
 	
 	private:
 		float		b_l_1_,	b_l_0_,	a_l_1_;
@@ -3,9 +3,13 @@
 #include <string.h>
 
 #include "guitar_dsp.h"
-#include "level_detector.h"
 #include "lfo.h"
 
+// the profiles without duty cycle are the same for every LFO, so their 
+// tables are computed once and shared (less memory and cache lines)
+uint16_t 	LowFreqOsc::shared_[LFO_SHARED][512];
+bool 		LowFreqOsc::shared_init_ 	= false;
+
 // *****************************************************************************
 
 void LowFreqOsc::Init(uint32_t sampling_rate)
@@ -16,6 +20,26 @@ void LowFreqOsc::Init(uint32_t sampling_rate)
 			ADC sampling rate (Hz)
 	*/
 
+	uint32_t i;
+
+	if (!shared_init_)
+	{
+		for (i = 0; i < 512; i++)
+		{
+			// sin (0-2pi) -> (0:65535)
+			shared_[LFO_SIN][i] 		= 32767.*sin(2.*GDSP_PI * (float)(i / 512.)) + 32768;
+			// sin (0-pi) -> (0:65535)
+			shared_[LFO_HALFSINE][i] 	= 65535.*sin(GDSP_PI * (float)(i / 512.));
+			// ramp /|/|/|/|...
+			shared_[LFO_RAMP][i] 		= 128*i;
+			// saw tooth |\|\|\|\|...
+			shared_[LFO_SAW][i] 		= 65408 - 128*i;
+			// saw /\/\/\/\...
+			shared_[LFO_TRIANGLE][i] 	= i < 256 ? 256*i : 65535 - 256*(i - 256);
+		}
+		shared_init_ 	= true;
+	}
+
 	sample_rate = sampling_rate;
 	max_gain 	= 65532;
 
@@ -24,6 +48,8 @@ void LowFreqOsc::Init(uint32_t sampling_rate)
 
 	SetDutyCycle(50.f);
 	phase_  	= 0.;
+	source_ 	= NULL;
+	level_ 		= NULL;
 
 	return;
 }
@@ -116,42 +142,11 @@ void LowFreqOsc::SetProfile(uint8_t prof)
 	
 	switch (profile)
 	{
-		case LFO_SIN:    // sin (0-2pi) -> (0:65535)
-			for (i = 0; i < 512; i++)
-			{
-				ampl_[i] = 32767.*sin(2.*GDSP_PI * (float)(i / 512.)) + 32768;
-			}
-			break;
-		case LFO_HALFSINE:    // sin (0-pi) -> (0:65535)
-			for (i = 0; i < 512; i++)
-			{
-				ampl_[i] = 65535.*sin(GDSP_PI * (float)(i / 512.));
-			}
-			break;
-		case LFO_RAMP:  // ramp /|/|/|/|...
-			for (i = 0; i < 512; i++)
-			{
-				ampl_[i] = 128*i;
-			}
-			break;
-		case LFO_SAW:  // saw tooth |\|\|\|\|...
-			for (i = 0; i < 512; i++)
-			{
-				ampl_[i] = 65408 - 128*i;
-			}
-			break;
-		case LFO_TRIANGLE:  // saw /\/\/\/\...
-			for (i = 0; i < 512; i++)
-			{
-				if (i < 256)
-				{
-					ampl_[i] = 256*i;
-				}
-				else
-				{
-					ampl_[i] = 65535 - 256*(i - 256);
-				}
-			}
+		case LFO_SIN:    		// shared tables (Init)
+		case LFO_HALFSINE:
+		case LFO_RAMP:
+		case LFO_SAW:
+		case LFO_TRIANGLE:
 			break;
 		case LFO_SQUARE:  // step _|-|_|-|_|...
 			for (i = 0; i < 512; i++)
@@ -204,6 +199,49 @@ void LowFreqOsc::SetGain(uint32_t gain)
 	return;
 }
 
+void LowFreqOsc::SetSource(const uint32_t *source)
+{
+	/*
+	To drive the LFO_EXTERNAL profile by a signal updated every sample (the
+	second input, for instance), instead of SetGain.
+		source
+			pointer to the amplitude (0 to 65535), or NULL to use SetGain
+	*/
+
+	source_ 	= source;
+
+	return;
+}
+
+void LowFreqOsc::SetLevel(const float *level)
+{
+	/*
+	To drive the LFO_LEVEL and LFO_REVERSE_LEVEL profiles by an envelope
+	detector of the Level Detector.
+		level
+			pointer to the envelope (0 to ADC_HALFRES), or NULL for silence
+	*/
+
+	level_ 		= level;
+
+	return;
+}
+
+uint32_t LowFreqOsc::Level()
+{
+	/*
+	Envelope scaled from 0 to 65535.
+	*/
+
+	float 	lv;
+
+	if (level_ == NULL) return 0;
+	lv 		= 2*(*level_);
+	if (lv > ADC_RES - 1) lv 	= ADC_RES - 1;
+
+	return (uint32_t)lv;
+}
+
 uint32_t LowFreqOsc::GetAmplitude()
 {
 	/*
@@ -224,28 +262,55 @@ uint32_t LowFreqOsc::GetValue()
 
 	if (profile == LFO_EXTERNAL)
 	{
+		if (source_ != NULL) return *source_;
 		return gain_;
 	}
 	else
 	{
 		if (profile == LFO_LEVEL)
-			return LevelDetectorPower();
+			return Level();
 		else
         {
             if (profile == LFO_REVERSE_LEVEL)
             {
-			    return ADC_RES - LevelDetectorPower();
+			    return ADC_RES - Level();
             }
             else
     		{
 	    		phase_  += rate_;
 		    	if (phase_ > 512) phase_ = 0;
+    			if (profile < LFO_SHARED) return shared_[profile][(uint32_t)phase_];
     			return ampl_[(uint32_t)phase_];
 	    	}
         }
 	}
 }
 
+uint32_t LowFreqOsc::GetOffsetValue(float offset)
+{
+	/*
+	Amplitude of the Low Frequency Oscilator shifted in phase, without
+	advancing the phase. Shall be called after GetValue, for a second 
+	(stereo) channel.
+		offset
+			phase offset, in table steps (512 steps = 360 degrees)
+		LowFreqOsc
+			Amplitude at given time (0 to 65535)
+	*/
+
+	float 	phase;
+
+	if (profile == LFO_EXTERNAL) return source_ != NULL ? *source_ : gain_;
+	if (profile == LFO_LEVEL) return Level();
+	if (profile == LFO_REVERSE_LEVEL) return ADC_RES - Level();
+
+	phase 	= phase_ + offset;
+	while (phase >= 512) phase 	-= 512;
+
+	if (profile < LFO_SHARED) return shared_[profile][(uint32_t)phase];
+	return ampl_[(uint32_t)phase];
+}
+
 void LowFreqOsc::Printout(int32_t profile, char *printout)
 {
     if (profile == LFO_SIN)             sprintf(printout, "->Sine Freq\n");
@@ -3,6 +3,7 @@
 #define GSP_LFO
 
 #define     PROFILES_NUMBER  11       
+#define     LFO_SHARED       5 		// profiles with a table shared by all the LFOs
 enum lfo_wave
 {
 	LFO_SIN, 			// Sine <0:2*pi>
@@ -31,8 +32,11 @@ class LowFreqOsc
 		void 		SetDutyCycle(float duty_cycle);
 		void 		SetProfile(uint8_t prof);
 		void 		SetGain(uint32_t gain);
+		void 		SetSource(const uint32_t *source);
+		void 		SetLevel(const float *level);
 		uint32_t	GetAmplitude();
 		uint32_t 	GetValue();
+		uint32_t 	GetOffsetValue(float offset);
         void        Printout(int32_t chn_pos, char *printout);
 		uint32_t 	sample_rate;	// sampling rate
 		uint8_t   	profile;
@@ -42,12 +46,18 @@ class LowFreqOsc
 		uint32_t 	max_gain; 		// LFO Amplitude
 		
 	private:
-		uint32_t  	ampl_[512]; 	// lookup table (internal use)
 		float     	phase_;   		// current phase (internal use)
 		float     	rate_;			// phase angle increment
 		uint32_t 	gain_;			// amplitude of LFO for LFO_EXTERNAL profile
 									// or decay rate for exponential decay or inverse ED
+		const uint32_t 	*source_; 	// sample rate source for LFO_EXTERNAL (or NULL)
+		const float 	*level_; 	// envelope for LFO_LEVEL (or NULL)
+		uint32_t 	Level();
 		uint32_t 	duty_; 			// duty cycle in fraction of time lenght
+		uint16_t  	ampl_[512]; 	// lookup table of the duty cycle profiles
+
+		static uint16_t shared_[LFO_SHARED][512]; 	// sine, half sine, ramp, saw and triangle
+		static bool 	shared_init_;
 };
 
 #endif 	// GPS_LFO 	Low Frequency Oscillator
@@ -0,0 +1,111 @@
+#include <math.h>
+
+#include "guitar_dsp.h"
+#include "envelope.h"
+
+// *****************************************************************************
+
+void GSP_Envelope::Init(uint32_t sampling_rate)
+{
+	/*
+    Initiate the Envelope Class: the attack/release peak detector of the
+	level detector and the dynamics effects.
+		sampling_rate
+			ADC sampling rate (Hz)
+	*/
+
+	sample_rate 	= sampling_rate;
+	rms 			= 0;
+
+	SetTimes(10., 1000.);
+	Reset();
+
+	return;
+}
+
+void GSP_Envelope::SetTimes(float atk_ms, float rel_ms)
+{
+	/*
+    To set the detector times. Times shorter than one sample give an
+	instantaneous response.
+		atk_ms
+			attack time in milliseconds (rise of the envelope)
+		rel_ms
+			release time in milliseconds (decay of the peaks)
+	*/
+
+	float 	atk, rel;
+
+	attack_ms 	= fmaxf(atk_ms, 0);
+	release_ms 	= fmaxf(rel_ms, 0);
+
+	atk 		= attack_ms*sample_rate/1000.;
+	rel 		= release_ms*sample_rate/1000.;
+	alfa_atk_ 	= atk >= 1 ? expf(-1./atk) : 0;
+	alfa_rel_ 	= rel >= 1 ? expf(-1./rel) : 0;
+
+	return;
+}
+
+void GSP_Envelope::SetMode(uint8_t rms_mode)
+{
+	/*
+    To choose the detector.
+		rms_mode
+			0: peak detector (default), 1: RMS detector, the mean square 
+			rises with the attack time and falls with the release time
+	*/
+
+	rms 		= rms_mode > 0;
+	Reset();
+
+	return;
+}
+
+void GSP_Envelope::Reset()
+{
+	/*
+    To clear the detector.
+	*/
+
+	y1_ 		= 0;
+	level 		= 0;
+
+	return;
+}
+
+float GSP_Envelope::Process(int32_t sampl)
+{
+	/*
+    To compute the envelope: the peaks decay with the release time, and
+	the envelope follows them with the attack time. In RMS mode, the 
+	envelope is the square root of the smoothed mean square.
+		sampl:
+			Input sample
+		Envelope.Process
+			Envelope (also in level)
+	*/
+
+	float 	xL, yt;
+
+	if (rms)
+	{
+		xL 		= (float)sampl*sampl;
+		yt 		= xL > y1_ ? alfa_atk_ : alfa_rel_;
+		y1_ 	= yt*(y1_ - xL) + xL;
+		level 	= sqrtf(y1_);
+		return level;
+	}
+
+    if (sampl >= 0) xL 		= sampl;
+    else xL 	= -sampl;
+
+    yt 		= alfa_rel_*(y1_ - xL) + xL; // release level detector
+
+    if (xL > yt) y1_ 		= xL;
+    else y1_ 	= yt;
+
+    level 	= alfa_atk_*(level - y1_) + y1_; // attack level detector
+
+	return level;
+}
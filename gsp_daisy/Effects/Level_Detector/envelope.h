@@ -0,0 +1,30 @@
+#pragma once
+#ifndef GSP_ENVELOPE
+#define GSP_ENVELOPE
+
+#include <stdint.h>
+
+class GSP_Envelope
+{
+	public:
+		GSP_Envelope() {}
+		~GSP_Envelope() {}
+
+		void 		Init(uint32_t sampling_rate);
+		void 		SetTimes(float atk_ms, float rel_ms);
+		void 		SetMode(uint8_t rms_mode);
+		void 		Reset();
+		float 		Process(int32_t sampl);
+
+		uint32_t 	sample_rate;	// sampling rate
+		float 		attack_ms, release_ms;
+		uint8_t 	rms; 			// 0: peak detector, 1: RMS detector
+		float 		level; 			// envelope (0 to ADC_HALFRES)
+
+	private:
+
+		float   	alfa_atk_, alfa_rel_;
+		float 		y1_; 			// release (peak hold) stage, or mean square
+};
+
+#endif 	// GSP_ENVELOPE 	Envelope detector
@@ -1,182 +1,321 @@
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "guitar_dsp.h"
 #include "level_detector.h"
 
-int32_t 	conv_ 	= 65536;
-float   	y1_ 	= 0;
-float		yL_		= 0;
-float 		ytm_ 	= 1;
-int32_t 	atk_samples_	= 48;
-int32_t 	rel_samples_ 	= 48000;
-float 		atk_ms_ 	= 0.001;
-float 		rel_ms_ 	= 1.0;
-float   	alfa_atk_ 	= 0.979382181331240;	// atk = 0.001 s
-float 		alfa_rel_ 	= 0.999979166883679;	// rel = 1 s
-int32_t 	lgti_ 		= 0;
-
 // *****************************************************************************
 
-void LevelDetectorSetTimes(uint32_t sample_rate, float atk_ms, float rel_ms)
+void GSP_LevelDetector::Init(uint32_t sampling_rate)
+{
+	/*
+    Initiate the Level Detector Class: a set of envelope detectors shared by
+	the effects. Each detector follows the chain input or the output of an
+	effect, and runs only while some effect uses it. Detector 0 drives the
+	LFO_LEVEL and LFO_REVERSE_LEVEL profiles; the others are free.
+		sampling_rate
+			ADC sampling rate (Hz)
+	*/
+
+	uint8_t 	d;
+	int32_t 	i;
+
+	sample_rate 	= sampling_rate;
+	for (d = 0; d < LVD_DETECTORS; d++)
+	{
+		env_[d].Init(sample_rate);
+		tap[d] 			= LVD_INPUT;
+		subscribers[d] 	= 0;
+		level[d] 		= 0;
+		len_[d] 		= 0;
+		SetTimes(d, 1., d == 0 ? 1000. : 100.);
+	}
+	for (i = 0; i < MAX_EFFECT_NUMBER; i++) route_[i] 	= -1;
+	for (i = 0; i < MAX_EFFECT_NUMBER; i++) Route(i, -1);
+	Update();
+
+	return;
+}
+
+void GSP_LevelDetector::SetSampleRate(uint32_t sampling_rate)
 {
 	/*
-    Initiate the LevelDetector at given parameters
-		sample_rate
-			ADC sampling rate (samples per second)
-		atk_tm
-			attack time in milliseconds 
-			atk_smp = atk_ms*sample_rate/1000 where atk_smp
-			is the attack time in samples
-		rel_tm
-			release time in milliseconds 
-			rel_smp = rel_ms*sample_rate/1000 where rel_smp
-			is the release time in samples
+    To change the sampling rate, keeping the times, taps and routes.
+		sampling_rate
+			ADC sampling rate (Hz)
 	*/
 
-	atk_ms_ 		= fmaxf(atk_ms, 10./(float)sample_rate);
-	atk_samples_ 	= atk_ms_*sample_rate/1000.;
-	
-	rel_ms_ 		= fmaxf(rel_ms, 10./(float)sample_rate);
-	rel_samples_ 	= rel_ms_*sample_rate/1000.;
+	uint8_t 	d;
 
-	alfa_atk_ 	= expf(-1./(float)atk_samples_);
-	alfa_rel_ 	= expf(-1./(float)rel_samples_);
-	
-	y1_			= 0;
-	yL_ 		= 0;
+	sample_rate 	= sampling_rate;
+	for (d = 0; d < LVD_DETECTORS; d++)
+	{
+		env_[d].sample_rate 	= sample_rate;
+		env_[d].SetTimes(env_[d].attack_ms, env_[d].release_ms);
+	}
 
-	ytm_ 		= (float)conv_/ADC_HALFRES;
-	
 	return;
 }
 
-void LevelDetectorSetSamples(uint32_t sample_rate, int32_t atk_smp, int32_t rel_smp)
+void GSP_LevelDetector::SetTimes(uint8_t det, float atk_ms, float rel_ms)
+{
+	/*
+    To set the times of a detector.
+		det
+			detector (0 to LVD_DETECTORS - 1)
+		atk_ms
+			attack time in milliseconds (rise of the envelope)
+		rel_ms
+			release time in milliseconds (decay of the peaks)
+	*/
+
+	if (det >= LVD_DETECTORS) return;
+
+	env_[det].SetTimes(fmaxf(atk_ms, 10./(float)sample_rate),
+		fmaxf(rel_ms, 10./(float)sample_rate));
+
+	return;
+}
+
+void GSP_LevelDetector::SetMode(uint8_t det, uint8_t rms)
+{
+	/*
+    To choose the peak or the RMS response of a detector. A compressor in
+	its RMS engine needs an RMS detector: a peak one gives the peak response.
+		det
+			detector (0 to LVD_DETECTORS - 1)
+		rms
+			0: peak detector, 1: RMS detector
+	*/
+
+	if (det >= LVD_DETECTORS) return;
+
+	env_[det].SetMode(rms);
+	level[det] 	= 0;
+
+	return;
+}
+
+int32_t GSP_LevelDetector::SetTap(uint8_t det, int32_t effect)
+{
+	/*
+    To select the signal followed by a detector: the chain input or the
+	output of an effect in the chain. An effect out of the chain leaves the
+	envelope frozen.
+		det
+			detector (0 to LVD_DETECTORS - 1)
+		effect
+			effect number (see enum gsp_effects), or LVD_INPUT
+	Returns 0 if succeeded or -1 if the detector or the effect is invalid.
+	*/
+
+	if (det >= LVD_DETECTORS) return -1;
+	if (effect < LVD_INPUT || effect >= MAX_EFFECT_NUMBER) return -1;
+
+	tap[det] 	= effect;
+	len_[det] 	= 0;
+	Update();
+
+	return 0;
+}
+
+int32_t GSP_LevelDetector::Route(int32_t effect, int32_t det)
+{
+	/*
+    To give a detector to an effect. The LFOs of phaser, wahwah, chorus,
+	vibrato, tremolo and volume read it in their LFO_LEVEL profiles (detector
+	0 by default); compressor and noise gate use it instead of their own
+	detector (none by default).
+		effect
+			effect number (see enum gsp_effects)
+		det
+			detector (0 to LVD_DETECTORS - 1), or -1 for the default
+	Returns 0 if succeeded or -1 if the effect can't use a detector.
+	*/
+
+	uint8_t 	lfo;
+
+	if (det >= LVD_DETECTORS) return -1;
+
+	lfo 	= effect == GSP_PHR || effect == GSP_WAH || effect == GSP_CHS
+		|| effect == GSP_VBT || effect == GSP_TML || effect == GSP_VOL
+		|| effect == GSP_PHR2 || effect == GSP_WAH2;
+	if (!lfo && effect != GSP_CMP && effect != GSP_NGT
+		&& effect != GSP_CMP2) return -1;
+
+	if (det < 0) det 	= lfo ? 0 : -1;
+	route_[effect] 	= det;
+	Subscribe(effect, 0);
+
+	return 0;
+}
+
+int32_t GSP_LevelDetector::Routed(int32_t effect)
+{
+	/*
+    Returns the detector of an effect, or -1 if none.
+	*/
+
+	if (effect < 0 || effect >= MAX_EFFECT_NUMBER) return -1;
+
+	return route_[effect];
+}
+
+void GSP_LevelDetector::Subscribe(int32_t effect, uint8_t on)
 {
 	/*
-    Initiate the LevelDetector at given parameters
-		sample_rate
-			ADC sampling rate (samples per second)
-		atk_smp
-			attack time in number of samples 
-			atk_smp = atk_ms*sample_rate/1000 where atk_ms
-			is the attack time in milliseconds
-		rel_smp
-			release time in number of samples 
-			rel_smp = rel_ms*sample_rate/1000 where rel_ms
-			is the release time in milliseconds
+    To tell whether an effect is using its detector (switched on, in the
+	chain and, for an LFO, in a level profile). Detectors without users
+	aren't computed. Called from the main loop.
+		effect
+			effect number (see enum gsp_effects)
+		on
+			1 if the effect uses its detector, 0 if not
 	*/
 
-	float atkms, relms;
-	
-	atkms 		= (float)atk_smp/sample_rate*1000.;
-	relms 		= (float)rel_smp/sample_rate*1000.;
-	LevelDetectorSetTimes(sample_rate, atkms, relms);
-	
+	uint8_t 	d;
+
+	if (effect < 0 || effect >= MAX_EFFECT_NUMBER) return;
+
+	for (d = 0; d < LVD_DETECTORS; d++) subscribers[d] 	&= ~(1UL << effect);
+	if (on && route_[effect] >= 0) subscribers[route_[effect]] 	|= 1UL << effect;
+	Update();
+
 	return;
 }
 
-float LevelDetectorGetAttackMS()
+const float *GSP_LevelDetector::Level(int32_t effect)
 {
 	/*
-    Retrieve the attack time in milliseconds from
-	LevelDetector
-		LevelDetectorGetAttack
-			attack time in number of samples 
-			atk_smp = atk_ms*sample_rate/1000 where atk_ms
-			is the attack time in milliseconds
+    Returns the envelope read by an effect (0 to ADC_HALFRES), or NULL if
+	the effect has no detector.
 	*/
-	
-	return atk_ms_;
+
+	if (Routed(effect) < 0) return NULL;
+
+	return &level[route_[effect]];
 }
 
-float LevelDetectorGetReleaseMS()
+void GSP_LevelDetector::Update()
 {
 	/*
-    Retrieve the release time in milliseconds from
-	Level Detector
-		LevelDetectorGetRelease
-			release time in number of samples 
-			rel_smp = rel_ms*sample_rate/1000 where rel_ms
-			is the release time in milliseconds
+	To refresh the masks read by the audio callback.
 	*/
-	
-	return rel_ms_;
+
+	uint8_t 	d, act;
+	uint32_t 	tp;
+
+	act 	= 0;
+	tp 		= 0;
+	for (d = 0; d < LVD_DETECTORS; d++)
+	{
+		if (subscribers[d] == 0) continue;
+		act 	|= 1 << d;
+		tp 		|= 1UL << (tap[d] + 1);
+	}
+	active 	= act;
+	taps 	= tp;
+
+	return;
 }
 
-int32_t LevelDetectorProcess(int32_t sampl)
+void GSP_LevelDetector::Capture(int32_t effect, int32_t sampl)
 {
 	/*
-    To compute the LevelDetector. The power level can
-	be retrieved by LevelDetectorPower(). Power level range
-	from 0 to 65535.
-		sampl:
-			Input sample
+    To store a sample of a tapped point for the active detectors. Shall be
+	called only for the points set in taps, once per sample.
+		effect
+			effect whose output is sampl, or LVD_INPUT
+		sampl
+			sample
 	*/
- 
-	static float 	xL, yt;
-
-    if (sampl >= 0) xL 		= sampl;
-    else xL 	= -sampl;
- 
-    yt 		= alfa_rel_*(y1_ - xL) + xL; // release level detector
-
-    if (xL > yt) y1_ 		= xL;
-    else y1_ 	= yt;
-
-    yL_ 	= alfa_atk_*(yL_ - y1_) + y1_; // attack level detector
-
-	
-    lgti_ 	= yL_*conv_;
-    
-    if (lgti_ < 0) lgti_ 		= 0;
-    if (lgti_ >= conv_) lgti_ 	= conv_ - 1;
-    
-    return lgti_;
+
+	uint8_t 	d;
+
+	for (d = 0; d < LVD_DETECTORS; d++)
+	{
+		if (tap[d] != effect || ((active >> d) & 1) == 0) continue;
+		if (len_[d] < LVD_BLOCK) buf_[d][len_[d]++] 	= sampl;
+	}
+
+	return;
 }
 
-int32_t LevelDetectorPower()
+void GSP_LevelDetector::Process()
 {
 	/*
-    To retrieve the power level computed from the stream
-	input. The power level is scaled from 0 to 65535
-		LevelDetector Power
-			level power ranging from 0 to 65535
+    To compute the active detectors over the samples captured in the block.
+	Shall be called once per block, after the chain: the effects read the
+	envelopes of the previous block.
 	*/
- 
-    return lgti_;
+
+	uint8_t 	d;
+	uint32_t 	n;
+
+	for (d = 0; d < LVD_DETECTORS; d++)
+	{
+		if (((active >> d) & 1) == 0) continue;
+		for (n = 0; n < len_[d]; n++) env_[d].Process(buf_[d][n]);
+		level[d] 	= env_[d].level;
+		len_[d] 	= 0;
+	}
+
+	return;
 }
 
-void LevelDetectorPrintout(uint8_t out_list, char *printout)
+void GSP_LevelDetector::Printout(uint8_t out_list, uint8_t det, GSP_SignalChain *chain,
+	char *printout)
 {
+	int32_t 	i;
+	char 		pname[8];
+	float 		ldb;
+
+	if (det >= LVD_DETECTORS) det 	= 0;
+	chain->Name(tap[det], pname);
+	ldb 	= level[det] >= 1 ? 20*log10f(level[det]*ADC_INVHRESF) : -90.3;
 
     if (out_list == 0)
     {
-        sprintf(printout, "->LVD: Attack (0.2-)(ms): %8.3f "
-        "| Release (0.2-)(ms): %8.3f\n%c", 
-        LevelDetectorGetAttackMS(),
-        LevelDetectorGetReleaseMS(), 0);
+        sprintf(printout, "->LVD (%d): Tap: %s "
+        "| Attack (0.2-)(ms): %-.3f "
+        "| Release (0.2-)(ms): %-.3f "
+        "| Mode: Peak(0)|RMS(1) %d "
+        "| Level (dBFS): %-.1f | Users:",
+        det, pname, env_[det].attack_ms, env_[det].release_ms, env_[det].rms, ldb);
     }
     if (out_list == 1)
     {
-        sprintf(printout, "->LVD %8.3f %8.3f\n%c", 
-        LevelDetectorGetAttackMS(),
-        LevelDetectorGetReleaseMS(), 0);
+        sprintf(printout, "->LVD (%d) %s %-.3f %-.3f %d %-.1f",
+        det, pname, env_[det].attack_ms, env_[det].release_ms, env_[det].rms, ldb);
     }
-	
+
+	for (i = 0; i < MAX_EFFECT_NUMBER; i++)
+	{
+		if (route_[i] != det) continue;
+		chain->Name(i, pname);
+		strcat(printout, " ");
+		strcat(printout, pname);
+		if (((subscribers[det] >> i) & 1) == 0) strcat(printout, "(idle)");
+	}
+	strcat(printout, "\n");
+
 	return;
 }
 
-void LevelDetectorParameters(float fn[])
+void GSP_LevelDetector::GetParams(float fn[])
 {
-	
-	fn[0]   = LevelDetectorGetAttackMS();
-	fn[1]   = LevelDetectorGetReleaseMS();
-	
+
+	fn[0]   = env_[0].attack_ms;
+	fn[1]   = env_[0].release_ms;
+
 	return;
 }
 
-// void LevelDetectorSetParams switch to 
-//	LevelDetectorSetTimes(sample_rate, fn[0], fn[1]);
+void GSP_LevelDetector::SetParams(float fn[])
+{
 
+	SetTimes(0, fn[0], fn[1]);
 
+	return;
+}
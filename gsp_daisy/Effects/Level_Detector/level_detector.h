@@ -3,14 +3,49 @@
 #define GSP_POWERLEVEL
 
 #include "../guitar_dsp.h"
+#include "envelope.h"
+#include "gsp_chain.h"
 
-void 	LevelDetectorSetTimes(uint32_t sample_rate, float atk_ms, float rls_ms);
-void 	LevelDetectorSetSamples(uint32_t sample_rate, int32_t atk_smp, int32_t rls_smp);
-float 	LevelDetectorGetAttackMS();
-float 	LevelDetectorGetReleaseMS();
-int32_t	LevelDetectorProcess(int32_t sampl);
-int32_t LevelDetectorPower();
-void 	LevelDetectorPrintout(uint8_t out_list, char *printout);
-void 	LevelDetectorParameters(float fn[]);
+#define LVD_DETECTORS 	4 		// shared envelope detectors (0 is the lvd one)
+#define LVD_BLOCK 		64 		// samples captured per block (AUDIO_MAX_BLOCK)
+#define LVD_INPUT 		-1 		// tap at the chain input (position of lvd)
+
+class GSP_LevelDetector
+{
+	public:
+		GSP_LevelDetector() {}
+		~GSP_LevelDetector() {}
+
+		void 		Init(uint32_t sampling_rate);
+		void 		SetSampleRate(uint32_t sampling_rate);
+		void 		SetTimes(uint8_t det, float atk_ms, float rel_ms);
+		void 		SetMode(uint8_t det, uint8_t rms);
+		int32_t 	SetTap(uint8_t det, int32_t effect);
+		int32_t 	Route(int32_t effect, int32_t det);
+		int32_t 	Routed(int32_t effect);
+		void 		Subscribe(int32_t effect, uint8_t on);
+		const float *Level(int32_t effect);
+		void 		Capture(int32_t effect, int32_t sampl);
+		void 		Process();
+		void		Printout(uint8_t out_list, uint8_t det, GSP_SignalChain *chain,
+						char *printout);
+		void 		GetParams(float param[]);
+		void 		SetParams(float param[]);
+
+		uint32_t 	sample_rate;	// sampling rate
+		int32_t 	tap[LVD_DETECTORS]; 		// tapped effect output (LVD_INPUT: chain input)
+		uint32_t 	subscribers[LVD_DETECTORS]; // consumers in use (bit mask of effects)
+		float 		level[LVD_DETECTORS]; 		// envelopes (0 to ADC_HALFRES), once per block
+		uint8_t 	active; 		// detectors with consumers (bit mask)
+		uint32_t 	taps; 			// points tapped by active detectors (bit mask, bit tap + 1)
+
+	private:
+		void 		Update();
+
+		GSP_Envelope 	env_[LVD_DETECTORS];
+		int8_t 		route_[MAX_EFFECT_NUMBER]; 	// detector of each consumer (-1: none)
+		int32_t 	buf_[LVD_DETECTORS][LVD_BLOCK]; 	// samples of the current block
+		uint32_t 	len_[LVD_DETECTORS];
+};
 
 #endif 	// GSP_POWERLEVEL 	Power level detector
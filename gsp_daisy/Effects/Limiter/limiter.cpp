@@ -81,7 +81,7 @@ int32_t GSP_Limiter::Process(int32_t sampl)
 			Processed output
     */
 
-    static int32_t  sout, a_smpl, strg;
+    int32_t  sout, a_smpl, strg;
 
 	a_smpl 	= input_gain*(float)sampl;
 	sout 	= sampl;
@@ -172,3 +172,22 @@ void GSP_Limiter::SetParams(float fn[])
 
 	return;
 }
+
+int8_t GSP_Limiter::SetParam(uint8_t idx, float value)
+{
+	/*
+    To change a single smoothable parameter (see smooth_params) at the 
+	sampling rate, for parameter ramps.
+		idx
+			parameter index, as in GetParams and SetParams
+		value
+			new value
+	Returns 0, or -1 if the parameter isn't smoothable.
+	*/
+
+	if (((smooth_params >> idx) & 1) == 0) return -1;
+
+	SetGain(value);
+
+	return 0;
+}
@@ -18,10 +18,13 @@ class GSP_Limiter
 		void		Printout(uint8_t out_list, int32_t chn_pos, char *printout);
 		void 		GetParams(float param[]);
 		void 		SetParams(float param[]);
+		int8_t 		SetParam(uint8_t idx, float value);
 
 		uint8_t		state;
 		float		smooth;
 		float 		input_gain;
+		uint8_t 	number_params = 3;
+		uint8_t 	smooth_params = (1 << 2); 	// parameters with ramps (bit mask)
 	
 	private:
 		uint32_t 	sample_rate_;
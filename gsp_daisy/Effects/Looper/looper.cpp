@@ -0,0 +1,435 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "looper.h"
+
+// *****************************************************************************
+
+static inline int16_t Saturate(int32_t x)
+{
+	if (x > ADC_MAXVAL) return ADC_MAXVAL;
+	if (x < ADC_MINVAL) return ADC_MINVAL;
+	return (int16_t)x;
+}
+
+// *****************************************************************************
+
+void GSP_Looper::Init(uint32_t sampling_rate, int16_t *loop_buffer,
+	int16_t *layer_buffer, uint32_t buffer_size)
+{
+	/*
+    Initiate the Looper Class. The loop is kept in two buffers: the last
+	layer, which can be undone, and the sum of all the older ones. Where an
+	overdub didn't reach, the last layer buffer still holds the previous
+	layer, which isn't muted by undo.
+		sampling_rate
+			ADC sampling rate (Hz)
+		loop_buffer
+			older layers (16 bit PCM, SDRAM)
+		layer_buffer
+			last layer (16 bit PCM, SDRAM)
+		buffer_size
+			size of each buffer (samples): maximum loop length
+	*/
+
+	sample_rate 	= sampling_rate;
+	loop_ 			= loop_buffer;
+	layer_ 			= layer_buffer;
+	size_ 			= buffer_size - buffer_size % LPR_BURST;
+
+	mode 			= LPR_IDLE;
+	length 			= 0;
+	layers 			= 0;
+	undone 			= 0;
+	request_ 		= LPR_NONE;
+	pos_ 			= 0;
+	j_ 				= 0;
+	odd_ 			= 0;
+	dirty_ 			= 0;
+	mute_ 			= 0;
+	dub_start_ 		= 0;
+	dub_len_ 		= 0;
+	acc_ 			= 0;
+
+	SetLevel(1.);
+	SetSpeed(0);
+	Switch(GSP_OFF);
+
+	return;
+}
+
+void GSP_Looper::SetLevel(float lvl)
+{
+	/*
+	Set the playback level of the loop. The input is always sent to the
+	output at unity gain.
+		lvl
+			loop level: 0 to 1.
+	*/
+
+	level 		= fmaxf(fminf(lvl, 1.), 0.);
+
+	return;
+}
+
+void GSP_Looper::SetSpeed(float spd)
+{
+	/*
+	Set the loop speed. At half speed the loop plays one octave down and
+	twice as long, and the new layers are recorded with half of the input
+	samples (they play one octave up at normal speed).
+		spd
+			Normal (0) or half (1) speed
+	*/
+
+	half 		= spd > 0.5 ? 1 : 0;
+
+	return;
+}
+
+int8_t GSP_Looper::Control(uint8_t action)
+{
+	/*
+    To drive the loop transport (main loop). The action is applied by
+	Process at the next burst boundary (LPR_BURST samples).
+		action
+			see enum lpr_actions. LPR_TAP gives the next step of a single
+			footswitch: record, play, overdub, play, overdub...
+	Returns 0, or -1 if the action isn't possible in the current mode.
+	*/
+
+	uint8_t 	md;
+
+	md 		= mode;
+	if (action == LPR_TAP)
+	{
+		if (md == LPR_IDLE) action 	= length > 0 ? LPR_PLAY : LPR_RECORD;
+		else if (md == LPR_PLAYING) action 	= LPR_OVERDUB;
+		else action 	= LPR_PLAY;
+	}
+
+	switch (action)
+	{
+		case LPR_STOP:
+		case LPR_RECORD:
+		case LPR_CLEAR:
+			break;
+		case LPR_PLAY:
+			if (length == 0 && md != LPR_RECORDING) return -1;
+			break;
+		case LPR_OVERDUB:
+			if (length == 0 && md != LPR_RECORDING) return -1;
+			// the muted layer is dropped: it's cleared before the new one
+			// (Process doesn't write the last layer while it is undone).
+			// Out of the overdub range it's the previous layer, still in use
+			if (undone)
+			{
+				if (dub_start_ + dub_len_ <= length)
+				{
+					memset(layer_ + dub_start_, 0, sizeof(int16_t)*dub_len_);
+				}
+				else
+				{
+					memset(layer_ + dub_start_, 0, sizeof(int16_t)*(length - dub_start_));
+					memset(layer_, 0, sizeof(int16_t)*(dub_start_ + dub_len_ - length));
+				}
+			}
+			break;
+		case LPR_UNDO:
+			if (layers < 2 || undone || md == LPR_RECORDING) return -1;
+			break;
+		case LPR_REDO:
+			if (undone == 0 || md == LPR_RECORDING) return -1;
+			break;
+		default:
+			return -1;
+	}
+
+	request_ 	= action;
+
+	return 0;
+}
+
+void GSP_Looper::Apply(uint8_t action)
+{
+	/*
+	To apply an action at a burst boundary (audio callback).
+	*/
+
+	// the recording is closed at the current position
+	if (mode == LPR_RECORDING && action != LPR_RECORD && action != LPR_CLEAR)
+	{
+		length 	= pos_;
+		pos_ 	= 0;
+		if (length == 0) mode 	= LPR_IDLE;
+	}
+
+	switch (action)
+	{
+		case LPR_STOP:
+			mode 	= LPR_IDLE;
+			break;
+		case LPR_RECORD:
+			mode 	= LPR_RECORDING;
+			length 	= 0;
+			layers 	= 1;
+			undone 	= 0;
+			dub_len_ 	= 0;
+			break;
+		case LPR_PLAY:
+			if (length > 0) mode 	= LPR_PLAYING;
+			break;
+		case LPR_OVERDUB:
+			if (length == 0) break;
+			if (mode != LPR_OVERDUBBING)
+			{
+				if (undone == 0) layers++; 	// else it replaces the muted one
+				dub_start_ 	= pos_;
+				dub_len_ 	= 0;
+			}
+			mode 	= LPR_OVERDUBBING;
+			undone 	= 0;
+			break;
+		case LPR_UNDO:
+			if (mode == LPR_OVERDUBBING) mode 	= LPR_PLAYING;
+			undone 	= 1;
+			break;
+		case LPR_REDO:
+			undone 	= 0;
+			break;
+		case LPR_CLEAR:
+			mode 	= LPR_IDLE;
+			length 	= 0;
+			layers 	= 0;
+			undone 	= 0;
+			dub_len_ 	= 0;
+			break;
+		default:
+			break;
+	}
+
+	if (mode == LPR_IDLE || mode == LPR_RECORDING) pos_ 	= 0;
+
+	return;
+}
+
+uint8_t GSP_Looper::Dubbed(uint32_t pos)
+{
+	/*
+	Returns 1 if the last overdub reached the loop position pos.
+	*/
+
+	uint32_t 	d;
+
+	d 	= pos >= dub_start_ ? pos - dub_start_ : pos + length - dub_start_;
+
+	return d < dub_len_;
+}
+
+void GSP_Looper::Fetch()
+{
+	/*
+	To read the current burst of both buffers, with the first sample of the
+	next burst (half speed interpolation).
+	*/
+
+	uint32_t 	next;
+
+	next 	= pos_ + LPR_BURST;
+	if (next >= length) next 	= 0;
+
+	memcpy(loop_blk_, loop_ + pos_, sizeof(int16_t)*LPR_BURST);
+	memcpy(layer_blk_, layer_ + pos_, sizeof(int16_t)*LPR_BURST);
+	loop_blk_[LPR_BURST] 	= loop_[next];
+	layer_blk_[LPR_BURST] 	= layer_[next];
+
+	return;
+}
+
+void GSP_Looper::Flush()
+{
+	/*
+	To write the current burst back, if it was changed.
+	*/
+
+	if (dirty_ == 0) return;
+
+	memcpy(loop_ + pos_, loop_blk_, sizeof(int16_t)*LPR_BURST);
+	memcpy(layer_ + pos_, layer_blk_, sizeof(int16_t)*LPR_BURST);
+	dirty_ 	= 0;
+
+	return;
+}
+
+void GSP_Looper::Switch(uint8_t mode)
+{
+	/*
+    To switch the effect on and off. The loop is paused while off.
+		mode
+			Condition switch: ON or OFF
+	*/
+
+	state 		= GSP_ON;
+	if (mode == GSP_OFF) state = GSP_OFF;
+
+	return;
+}
+
+int32_t GSP_Looper::Process(int32_t sampl)
+{
+	/*
+    To compute the Looper effect. The buffers are accessed one burst at a
+	time (LPR_BURST samples), read at its first sample and written back at
+	the end. An overdub adds the last layer to the older ones and records
+	the input as the new last layer.
+		sampl:
+			Input sample
+		Looper.Process
+			Processed output: input plus the loop
+	*/
+
+	int32_t 	x, y;
+	uint8_t 	write;
+
+	if (j_ == 0 && odd_ == 0)
+	{
+		if (request_ != LPR_NONE)
+		{
+			Apply(request_);
+			request_ 	= LPR_NONE;
+		}
+		if (mode == LPR_PLAYING || mode == LPR_OVERDUBBING) Fetch();
+		mute_ 	= undone && Dubbed(pos_);
+	}
+	if (mode == LPR_IDLE) return sampl;
+
+	// at half speed each loop sample takes a pair of input samples
+	write 	= half == 0 || odd_;
+	if (half && odd_ == 0) acc_ 	= sampl;
+	x 		= half ? (acc_ + sampl) >> 1 : sampl;
+	y 		= 0;
+
+	if (mode == LPR_RECORDING)
+	{
+		if (write)
+		{
+			loop_blk_[j_] 	= Saturate(x);
+			layer_blk_[j_] 	= 0;
+			dirty_ 	= 1;
+		}
+	}
+	else
+	{
+		y 	= loop_blk_[j_];
+		if (mute_ == 0) y 	+= layer_blk_[j_];
+		if (half && odd_)
+		{
+			y 	+= loop_blk_[j_ + 1];
+			if (mute_ == 0) y 	+= layer_blk_[j_ + 1];
+			y 	>>= 1;
+		}
+		if (mode == LPR_OVERDUBBING && write)
+		{
+			loop_blk_[j_] 	= Saturate(loop_blk_[j_] + layer_blk_[j_]);
+			layer_blk_[j_] 	= Saturate(x);
+			dirty_ 	= 1;
+		}
+	}
+
+	// next sample
+	if (write == 0)
+	{
+		odd_ 	= 1;
+	}
+	else
+	{
+		odd_ 	= 0;
+		j_++;
+		if (j_ == LPR_BURST)
+		{
+			Flush();
+			if (mode == LPR_OVERDUBBING && dub_len_ < length) dub_len_ 	+= LPR_BURST;
+			j_ 		= 0;
+			pos_ 	+= LPR_BURST;
+			if (mode == LPR_RECORDING)
+			{
+				// buffer full: the loop is closed and played
+				if (pos_ + LPR_BURST > size_)
+				{
+					length 	= pos_;
+					pos_ 	= 0;
+					mode 	= LPR_PLAYING;
+				}
+			}
+			else if (pos_ >= length) pos_ 	= 0;
+		}
+	}
+
+	return sampl + (int32_t)(level*y);
+}
+
+void GSP_Looper::Printout(uint8_t out_list, int32_t chn_pos, char *printout)
+{
+	float 	len;
+
+	len 	= (float)(mode == LPR_RECORDING ? pos_ : length)/sample_rate;
+
+    if (out_list == 0)
+    {
+        sprintf(printout, "->LPR (%ld): OFF(0)|ON(1) %d "
+	    "| Level (0-1): %-.3f "
+	    "| Speed: Normal(0)|Half(1) %d "
+	    "| Mode: Idle(0)|Record(1)|Play(2)|Overdub(3) %d "
+	    "| Length (s): %-.2f "
+	    "| Layers: %lu "
+	    "| Undo: %d\n",
+        chn_pos, state, level, half, mode, len, layers, undone);
+    }
+    if (out_list == 1)
+    {
+        sprintf(printout, "->LPR (%ld) %d %-.3f %d %d %-.2f %lu %d\n",
+        chn_pos, state, level, half, mode, len, layers, undone);
+    }
+
+	return;
+}
+
+void GSP_Looper::GetParams(float fn[])
+{
+
+	fn[0]   = state;
+	fn[1]   = level;
+	fn[2]   = half;
+
+	return;
+}
+
+void GSP_Looper::SetParams(float fn[])
+{
+
+	Switch(fn[0]);
+	SetLevel(fn[1]);
+	SetSpeed(fn[2]);
+
+	return;
+}
+
+int8_t GSP_Looper::SetParam(uint8_t idx, float value)
+{
+	/*
+    To change a single smoothable parameter (see smooth_params) at the
+	sampling rate, for parameter ramps.
+		idx
+			parameter index, as in GetParams and SetParams
+		value
+			new value
+	Returns 0, or -1 if the parameter isn't smoothable.
+	*/
+
+	if (((smooth_params >> idx) & 1) == 0) return -1;
+
+	SetLevel(value);
+
+	return 0;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#ifndef GSP_LOOPER
+#define GSP_LOOPER
+
+#include "../guitar_dsp.h"
+
+#define LPR_BURST 		16 		// samples per SDRAM access (one 32 byte cache line)
+
+enum lpr_modes
+{
+	LPR_IDLE 		= 0, 		// empty or stopped
+	LPR_RECORDING 	= 1, 		// first layer, sets the loop length
+	LPR_PLAYING 	= 2,
+	LPR_OVERDUBBING = 3, 		// plays and records a new layer
+	LPR_MODES,
+};
+
+enum lpr_actions
+{
+	LPR_STOP 		= 0,
+	LPR_RECORD 		= 1,
+	LPR_PLAY 		= 2,
+	LPR_OVERDUB 	= 3,
+	LPR_UNDO 		= 4, 		// mutes the last layer
+	LPR_REDO 		= 5, 		// brings it back
+	LPR_CLEAR 		= 6,
+	LPR_TAP 		= 7, 		// single footswitch: record, play, overdub, play...
+	LPR_ACTIONS,
+	LPR_NONE 		= 255,
+};
+
+class GSP_Looper
+{
+	public:
+		GSP_Looper() {}
+		~GSP_Looper() {}
+
+		void 		Init(uint32_t sampling_rate, int16_t *loop_buffer,
+						int16_t *layer_buffer, uint32_t buffer_size);
+		void 		SetLevel(float lvl);
+		void 		SetSpeed(float spd);
+		int8_t 		Control(uint8_t action);
+		void 		Switch(uint8_t mode);
+		int32_t 	Process(int32_t sampl);
+		void		Printout(uint8_t out_list, int32_t chn_pos, char *printout);
+		void 		GetParams(float param[]);
+		void 		SetParams(float param[]);
+		int8_t 		SetParam(uint8_t idx, float value);
+
+		uint32_t 	sample_rate;	// sampling rate
+		float 		level; 			// loop playback level
+		uint8_t 	half; 			// half speed (1) or normal speed (0)
+		volatile uint8_t 	mode; 			// see enum lpr_modes
+		volatile uint32_t 	length; 		// loop length (samples, 0 if empty)
+		uint32_t 	layers; 		// recorded layers (first recording included)
+		uint8_t 	undone; 		// last layer muted by undo
+		uint8_t 	state;
+		uint8_t 	number_params = 3;
+		uint8_t 	smooth_params = (1 << 1); 	// parameters with ramps (bit mask)
+
+	private:
+
+		void 		Apply(uint8_t action);
+		void 		Fetch();
+		void 		Flush();
+		uint8_t 	Dubbed(uint32_t pos);
+
+		int16_t 	*loop_, *layer_; 	// older layers and the last one
+		uint32_t 	size_;
+		volatile uint8_t 	request_; 	// pending action (see Control)
+		uint32_t 	pos_; 			// first sample of the current burst
+		uint32_t 	j_; 			// sample in the burst
+		uint8_t 	odd_; 			// second sample of a half speed pair
+		uint8_t 	dirty_; 		// burst changed, to be written back
+		uint8_t 	mute_; 			// last layer of the burst muted by undo
+		uint32_t 	dub_start_; 	// first sample of the last overdub
+		uint32_t 	dub_len_; 		// samples reached by the last overdub
+		int32_t 	acc_; 			// first input of a half speed pair
+		int16_t 	loop_blk_[LPR_BURST + 1]; 	// current burst, plus the first
+		int16_t 	layer_blk_[LPR_BURST + 1]; 	// sample of the next one
+};
+
+#endif 	// GSP_LOOPER 	Looper
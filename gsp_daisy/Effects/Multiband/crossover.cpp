@@ -0,0 +1,117 @@
+#include <math.h>
+
+#include "guitar_dsp.h"
+#include "crossover.h"
+
+// *****************************************************************************
+
+void GSP_Crossover::Init(uint32_t sampling_rate, float freq)
+{
+	/*
+    Initiate the Crossover Class: a 4th order Linkwitz-Riley split (two
+	Butterworth sections per band), whose bands sum to a 2nd order allpass.
+		sampling_rate
+			ADC sampling rate (Hz)
+		freq
+			crossover frequency (Hz)
+	*/
+
+	uint8_t 	i;
+
+	sample_rate 	= sampling_rate;
+	for (i = 0; i < 2; i++)
+	{
+		l1_[i] 	= 0;
+		l2_[i] 	= 0;
+		h1_[i] 	= 0;
+		h2_[i] 	= 0;
+	}
+	p1_ 	= 0;
+	p2_ 	= 0;
+
+	SetFrequency(freq);
+
+	return;
+}
+
+void GSP_Crossover::SetFrequency(float freq)
+{
+	/*
+	Set the crossover frequency. The filter states are kept.
+		freq
+			crossover frequency (Hz): 20 to 0.4*sample_rate
+	*/
+
+	float 	w, c, alpha, a0;
+
+	frequency 	= fmaxf(fminf(freq, 0.4*sample_rate), 20);
+
+	w 		= GDSP_2PI*frequency/sample_rate;
+	c 		= cosf(w);
+	alpha 	= sinf(w)*0.70710678f; 		// sin(w)/(2 Q), Q = 1/sqrt(2)
+	a0 		= 1 + alpha;
+
+	lb0_ 	= 0.5*(1 - c)/a0; 		// b2 = b0
+	lb1_ 	= (1 - c)/a0;
+	hb0_ 	= 0.5*(1 + c)/a0; 		// b2 = b0
+	hb1_ 	= -(1 + c)/a0;
+	a1_ 	= -2*c/a0;
+	a2_ 	= (1 - alpha)/a0;
+
+	return;
+}
+
+void GSP_Crossover::Split(float x, float *low, float *high)
+{
+	/*
+    To split a sample into the low and high bands (transposed direct form
+	II sections).
+		x
+			Input sample
+		low, high
+			Band samples, in phase: low + high = Allpass(x)
+	*/
+
+	float 	y, u;
+	uint8_t i;
+
+	y 	= x;
+	u 	= x;
+	for (i = 0; i < 2; i++)
+	{
+		x 		= y;
+		y 		= lb0_*x + l1_[i];
+		l1_[i] 	= lb1_*x - a1_*y + l2_[i];
+		l2_[i] 	= lb0_*x - a2_*y;
+
+		x 		= u;
+		u 		= hb0_*x + h1_[i];
+		h1_[i] 	= hb1_*x - a1_*u + h2_[i];
+		h2_[i] 	= hb0_*x - a2_*u;
+	}
+
+	*low 	= y;
+	*high 	= u;
+
+	return;
+}
+
+float GSP_Crossover::Allpass(float x)
+{
+	/*
+	To give a band that doesn't go through this crossover the same phase
+	as the sum of its bands (band summing of cascaded crossovers).
+		x
+			Input sample
+		Crossover.Allpass
+			Allpass output (b0 = a2, b1 = a1, b2 = 1)
+	*/
+
+	float 	y;
+
+	y 		= a2_*x + p1_;
+	p1_ 	= a1_*x - a1_*y + p2_;
+	p2_ 	= x - a2_*y;
+
+	return y;
+}
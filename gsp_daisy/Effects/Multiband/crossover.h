@@ -0,0 +1,30 @@
+#pragma once
+#ifndef GSP_CROSSOVER
+#define GSP_CROSSOVER
+
+#include <stdint.h>
+
+class GSP_Crossover
+{
+	public:
+		GSP_Crossover() {}
+		~GSP_Crossover() {}
+
+		void 		Init(uint32_t sampling_rate, float freq);
+		void 		SetFrequency(float freq);
+		void 		Split(float x, float *low, float *high);
+		float 		Allpass(float x);
+
+		uint32_t 	sample_rate;	// sampling rate
+		float 		frequency; 		// crossover frequency (Hz)
+
+	private:
+
+		// 2nd order Butterworth sections (low and high pass share a1 and a2)
+		float 		lb0_, lb1_, hb0_, hb1_, a1_, a2_;
+		float 		l1_[2], l2_[2]; 	// low pass states (two sections)
+		float 		h1_[2], h2_[2]; 	// high pass states (two sections)
+		float 		p1_, p2_; 			// allpass states
+};
+
+#endif 	// GSP_CROSSOVER 	Linkwitz-Riley crossover
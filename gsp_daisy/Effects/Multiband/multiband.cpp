@@ -0,0 +1,248 @@
+#include <math.h>
+#include <stdio.h>
+
+#include "multiband.h"
+
+// *****************************************************************************
+
+void GSP_Multiband::Init(uint32_t sampling_rate)
+{
+	/*
+    Initiate the Multiband Compressor Class: two Linkwitz-Riley crossovers
+	split the signal into three bands, each one with its own detector and
+	gain computer, and the bands are summed back in phase.
+		sampling_rate
+			ADC sampling rate (Hz)
+	*/
+
+	uint8_t 	k;
+
+	sample_rate 	= sampling_rate;
+	for (k = 0; k < MBC_BANDS; k++)
+	{
+		env_[k] 	= 0;
+		gain_[k] 	= 1;
+		dgain_[k] 	= 0;
+	}
+	count_ 			= 0;
+
+	xlow_.Init(sample_rate, 250);
+	xhigh_.Init(sample_rate, 2000);
+	SetAttackMilliSeconds(10.);
+	SetReleaseMilliSeconds(500.);
+	SetFrequencies(250, 2000);
+	for (k = 0; k < MBC_BANDS; k++) SetThresholdDB(k, 20);
+	Switch(GSP_OFF);
+
+	return;
+}
+
+void GSP_Multiband::SetAttackMilliSeconds(float atk_ms)
+{
+	/*
+    To set the attack of the band detectors (response time).
+		atk_ms
+			attack in milliseconds, (1000/sample_rate to 2000).
+	*/
+
+	attack_ms   = fmaxf(fminf(atk_ms, 2000), 1000./sample_rate);
+	alfa_atk_ 	= expf(-1./attack_ms/sample_rate*1000.);
+
+	return;
+}
+
+void GSP_Multiband::SetReleaseMilliSeconds(float rel_ms)
+{
+	/*
+    To set the release time of the band detectors (sustain time).
+		rel_ms
+			release time in milliseconds, (1000/sample_rate to 2000).
+	*/
+
+	release_ms  = fmaxf(fminf(rel_ms, 2000), 1000./sample_rate);
+	alfa_rel_ 	= expf(-1./release_ms/sample_rate*1000.);
+
+	return;
+}
+
+void GSP_Multiband::SetFrequencies(float f_low, float f_high)
+{
+	/*
+    To set the crossover frequencies. The filter states are kept.
+		f_low, f_high
+			low/medium and medium/high crossovers (Hz):
+			60 < f_low < 1000, 500 < f_high < 8000
+	*/
+
+	float 	fl;
+
+	if (f_low > f_high)
+	{
+		fl 		= f_low;
+		f_low 	= f_high;
+		f_high 	= fl;
+	}
+	freq_low 	= fmaxf(fminf(f_low, 1000), 60);
+	freq_high 	= fmaxf(fminf(f_high, 8000), 500);
+
+	xlow_.SetFrequency(freq_low);
+	xhigh_.SetFrequency(freq_high);
+
+	return;
+}
+
+void GSP_Multiband::SetThresholdDB(uint8_t band, float thrsd)
+{
+	/*
+	Set the threshold of a band in dB (positive, as the Compressor). Above
+	the threshold the band is compressed (MBC_RATIO), and the makeup gain
+	keeps 0 dBFS peaks at 0 dBFS, so lower thresholds sustain more.
+	A null threshold leaves the band unchanged.
+		band
+			0 = low, 1 = medium, 2 = high
+		thrsd
+			threshold in dB: 0 to 40.
+	*/
+
+	if (band >= MBC_BANDS) return;
+
+	threshold_db[band] 	= fmaxf(fminf(thrsd, 40), 0);
+	makeup_[band] 		= (1 - 1/MBC_RATIO)*threshold_db[band];
+
+	return;
+}
+
+void GSP_Multiband::Switch(uint8_t mode)
+{
+	/*
+    To switch the effect on and off.
+		mode
+			Condition switch: ON or OFF
+	*/
+
+	state 		= GSP_ON;
+	if (mode == GSP_OFF) state = GSP_OFF;
+
+	return;
+}
+
+int32_t GSP_Multiband::Process(int32_t sampl)
+{
+	/*
+    To compute the Multiband Compressor effect. The bands are processed
+	side by side, as lanes of the same loops; the gain computers run once
+	per block of CMP_BLOCK samples, and the gains are ramped in between.
+		sampl:
+			Input sample
+		Multiband.Process
+			Processed output
+	*/
+
+	float 	x[MBC_BANDS], r, a, lv, y;
+	uint8_t k;
+
+	// low = AP_high(LR_low), medium + high = AP_high(HP_low): in phase
+	xlow_.Split((float)sampl, &x[0], &r);
+	xhigh_.Split(r, &x[1], &x[2]);
+	x[0] 	= xhigh_.Allpass(x[0]);
+
+	for (k = 0; k < MBC_BANDS; k++)
+	{
+		a 		= fabsf(x[k]);
+		lv 		= a > env_[k] ? alfa_atk_ : alfa_rel_;
+		env_[k] = lv*(env_[k] - a) + a;
+	}
+
+	if (count_ == 0)
+	{
+		count_ 	= CMP_BLOCK;
+		for (k = 0; k < MBC_BANDS; k++)
+		{
+			lv 		= 6.0206f*FastLog2(fmaxf(env_[k], 1.f)) - 90.309f;
+			a 		= GSP_Compressor::GainComputer(lv, -threshold_db[k],
+						MBC_KNEE, 1/MBC_RATIO) + makeup_[k];
+			a 		= FastExp2(0.16609640f*a); 		// 10^(a/20)
+			dgain_[k] 	= (a - gain_[k])*(1.f/CMP_BLOCK);
+		}
+	}
+	count_--;
+
+	y 		= 0;
+	for (k = 0; k < MBC_BANDS; k++)
+	{
+		gain_[k] 	+= dgain_[k];
+		y 			+= gain_[k]*x[k];
+	}
+
+	return (int32_t)y;
+}
+
+void GSP_Multiband::Printout(uint8_t out_list, int32_t chn_pos, char *printout)
+{
+    if (out_list == 0)
+    {
+        sprintf(printout, "->MBC (%ld): OFF(0)|ON(1) %d "
+	    "| Attack (ms): %-.1f "
+        "| Release (ms): %-.1f "
+	    "| Crossovers (Hz): Low %-.1f , High %-.1f "
+    	"| Thresholds (0-40)(dB): Low %-.1f , Medium %-.1f , High %-.1f\n",
+        chn_pos, state, attack_ms, release_ms, freq_low, freq_high,
+        threshold_db[0], threshold_db[1], threshold_db[2]);
+    }
+    if (out_list == 1)
+    {
+        sprintf(printout, "->MBC (%ld) %d %-.1f %-.1f %-.1f %-.1f %-.1f %-.1f %-.1f\n",
+        chn_pos, state, attack_ms, release_ms, freq_low, freq_high,
+        threshold_db[0], threshold_db[1], threshold_db[2]);
+    }
+
+	return;
+}
+
+void GSP_Multiband::GetParams(float fn[])
+{
+
+	fn[0]   = state;
+	fn[1]   = attack_ms;
+	fn[2]   = release_ms;
+	fn[3]   = freq_low;
+	fn[4]   = freq_high;
+	fn[5]   = threshold_db[0];
+	fn[6]   = threshold_db[1];
+	fn[7]   = threshold_db[2];
+
+	return;
+}
+
+void GSP_Multiband::SetParams(float fn[])
+{
+
+	Switch(fn[0]);
+	SetAttackMilliSeconds(fn[1]);
+	SetReleaseMilliSeconds(fn[2]);
+	SetFrequencies(fn[3], fn[4]);
+	SetThresholdDB(0, fn[5]);
+	SetThresholdDB(1, fn[6]);
+	SetThresholdDB(2, fn[7]);
+
+	return;
+}
+
+int8_t GSP_Multiband::SetParam(uint8_t idx, float value)
+{
+	/*
+    To change a single smoothable parameter (see smooth_params) at the
+	sampling rate, for parameter ramps.
+		idx
+			parameter index, as in GetParams and SetParams
+		value
+			new value
+	Returns 0, or -1 if the parameter isn't smoothable.
+	*/
+
+	if (((smooth_params >> idx) & 1) == 0) return -1;
+
+	SetThresholdDB(idx - 5, value);
+
+	return 0;
+}
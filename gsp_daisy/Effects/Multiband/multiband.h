@@ -0,0 +1,48 @@
+#pragma once
+#ifndef GSP_MULTIBAND
+#define GSP_MULTIBAND
+
+#include "../guitar_dsp.h"
+#include "crossover.h"
+
+#define MBC_BANDS 		3 		// low, medium and high
+#define MBC_RATIO 		4.f 	// compression ratio of all bands
+#define MBC_KNEE 		6.f 	// soft knee width (dB)
+
+class GSP_Multiband
+{
+	public:
+		GSP_Multiband() {}
+		~GSP_Multiband() {}
+
+		void 		Init(uint32_t sampling_rate);
+		void 		SetAttackMilliSeconds(float atk_ms);
+		void 		SetReleaseMilliSeconds(float rel_ms);
+		void 		SetFrequencies(float f_low, float f_high);
+		void 		SetThresholdDB(uint8_t band, float thrsd);
+		void 		Switch(uint8_t mode);
+		int32_t 	Process(int32_t sampl);
+		void		Printout(uint8_t out_list, int32_t chn_pos, char *printout);
+		void 		GetParams(float param[]);
+		void 		SetParams(float param[]);
+		int8_t 		SetParam(uint8_t idx, float value);
+
+		uint32_t 	sample_rate;	// sampling rate
+		float     	attack_ms, release_ms;
+		float 		freq_low, freq_high; 		// crossover frequencies
+		float 		threshold_db[MBC_BANDS]; 	// thresholds (positive)
+		uint8_t 	state;
+		uint8_t 	number_params = 8;
+		uint8_t 	smooth_params = (1 << 5) | (1 << 6) | (1 << 7); 	// parameters with ramps (bit mask)
+
+	private:
+
+		GSP_Crossover 	xlow_, xhigh_;
+		float   	alfa_atk_, alfa_rel_;
+		float 		makeup_[MBC_BANDS]; 	// gain at 0 dBFS (dB)
+		float 		env_[MBC_BANDS]; 		// peak detectors
+		float 		gain_[MBC_BANDS], dgain_[MBC_BANDS];
+		uint32_t 	count_; 				// samples to the next gain computation
+};
+
+#endif 	// GSP_MULTIBAND 	Multiband Compressor
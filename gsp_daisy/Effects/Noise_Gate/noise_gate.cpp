@@ -14,11 +14,25 @@ void GSP_NoiseGate::Init(uint32_t sampling_rate)
 	*/
 
 	sample_rate 	= sampling_rate;
+	env_.Init(sample_rate);
+	thr_on_ 		= 0;
+	hysteresis_db 	= 0;
+	open 			= 0;
+	hold_count_ 	= 0;
+	g_ 				= 0;
+	g_open_ 		= 1000./(NGT_OPEN_MS*sample_rate);
+	g_close_ 		= 1000./(NGT_CLOSE_MS*sample_rate);
+	hpf_x1_ 		= 0;
+	hpf_y1_ 		= 0;
+	level_ 			= NULL;
 	
 	SetAttackMilliSeconds(10.);
 	SetReleaseMilliSeconds(1000.);
 	SetGain(1.);
-	SetThreshold(0.1);
+	SetThreshold(0.01);
+	SetHysteresisDB(6.);
+	SetHoldMilliSeconds(50.);
+	SetKeyFilter(0);
 	Switch(GSP_OFF);
 	
 	return;
@@ -40,14 +54,15 @@ void GSP_NoiseGate::SetAttackSamples(uint32_t atk_spl)
 void GSP_NoiseGate::SetAttackMilliSeconds(float atk_ms)
 {
 	/*
-    To set the attack of the NoiseGate effect (response time).
+    To set the attack of the NoiseGate effect (response time of the key
+	level detector).
 		atk_ms
 			attack in milliseconds, (1000/sample_rate to 2000).
 			
 	*/
 
-	attack_ms   = fmaxf(fminf(atk_ms, 2000), 1000/sample_rate);
-	alfa_atk_ 	= expf(-1./attack_ms/sample_rate*1000.);
+	attack_ms   = fmaxf(fminf(atk_ms, 2000), 1000./sample_rate);
+	env_.SetTimes(attack_ms, env_.release_ms);
 
 	return;
 }
@@ -55,7 +70,7 @@ void GSP_NoiseGate::SetAttackMilliSeconds(float atk_ms)
 void GSP_NoiseGate::SetReleaseSamples(uint32_t rel_spl)
 {
 	/*
-	Set the Compressor release time (sustain time).
+	Set the NoiseGate release time (sustain time).
 		rel_spl
 			release in samples: 1 to 2*sample_rate. 
 	*/
@@ -68,14 +83,14 @@ void GSP_NoiseGate::SetReleaseSamples(uint32_t rel_spl)
 void GSP_NoiseGate::SetReleaseMilliSeconds(float rel_ms)
 {
 	/*
-    To set the Compressor release time  (sustain time).
+    To set the NoiseGate release time (decay of the key level detector).
 		rel_ms
 			release time in milliseconds, (1000/sample_rate to 2000).
 			
 	*/
 
-	release_ms  = fmaxf(fminf(rel_ms, 2000), 1000/sample_rate);
-	alfa_rel_ 	= expf(-1./release_ms/sample_rate*1000.);
+	release_ms  = fmaxf(fminf(rel_ms, 2000), 1000./sample_rate);
+	env_.SetTimes(env_.attack_ms, release_ms);
 
 	return;
 }
@@ -96,18 +111,84 @@ void 	GSP_NoiseGate::SetGain(float gn)
 void  GSP_NoiseGate::SetThreshold(float thrsd)
 {
 	/*
-	Set the NoiseGate threshold. The NoiseGate drives the output
-    to ground (0) whenever the input level became below the threshold. 
-    If threshold is zero then the NoiseGate bypass the input. If
-    threshold is close to 1 then the output will always be zero.
+	Set the NoiseGate threshold. The gate opens when the key level rises
+	above the threshold, and closes when it falls below the threshold 
+	minus the hysteresis (after the hold time). If threshold is zero then
+	the NoiseGate bypass the input. If threshold is close to 1 then the
+	output will always be zero.
 		thrsd
-			threshold gain: 0 to 1.
+			threshold (fraction of full scale): 0 to 1.
 	*/
 
 	threshold	= fmaxf(fminf(thrsd, 1.), 0.);
-	
-	y1_			= 0.;
-	yL_ 		= 0.;
+	thr_on_ 	= threshold*ADC_HALFRES;
+	thr_off_ 	= thr_on_*powf(10, -hysteresis_db/20);
+
+	return;
+}
+
+void GSP_NoiseGate::SetHysteresisDB(float hyst)
+{
+	/*
+	Set the NoiseGate hysteresis: the close threshold is below the open
+	one, so decaying notes don't chatter around the threshold.
+		hyst
+			hysteresis in dB: 0 to 20.
+	*/
+
+	hysteresis_db 	= fmaxf(fminf(hyst, 20), 0);
+	thr_off_ 		= thr_on_*powf(10, -hysteresis_db/20);
+
+	return;
+}
+
+void GSP_NoiseGate::SetHoldMilliSeconds(float hold)
+{
+	/*
+	Set the NoiseGate hold time: the gate stays open while the key level
+	is below the close threshold for less than the hold time.
+		hold
+			hold time in milliseconds: 0 to 2000.
+	*/
+
+	hold_ms 	= fmaxf(fminf(hold, 2000), 0);
+	hold_ 		= hold_ms*sample_rate/1000.;
+
+	return;
+}
+
+void GSP_NoiseGate::SetKeyFilter(float freq)
+{
+	/*
+	Set the high pass filter of the key (1st order), so low notes or hum
+	don't hold the gate open.
+		freq
+			cutoff frequency in Hz: 0 (off) or 20 to 2000.
+	*/
+
+	float 	rc;
+
+	key_hpf 	= freq < 20 ? 0 : fminf(freq, 2000);
+	if (key_hpf == 0) return;
+
+	rc 			= 1./(GDSP_2PI*key_hpf);
+	hpf_a_ 		= rc/(rc + 1./sample_rate);
+
+	return;
+}
+
+void GSP_NoiseGate::SetLevel(const float *level)
+{
+	/*
+	To open the gate with a detector of the Level Detector instead of the
+	own one (attack, release and key filter), so several effects can share
+	it. The shared envelope is updated once per block.
+		level
+			pointer to the envelope (0 to ADC_HALFRES), or NULL for the
+			own detector
+	*/
+
+	level_ 		= level;
 
 	return;
 }
@@ -136,28 +217,55 @@ int32_t GSP_NoiseGate::Process(int32_t sampl)
 		NoiseGate.Process
 			Processed output
 	*/
- 
-	static float 	xL, yt;
-    static int32_t  sout;
 
-    if (sampl >= 0) xL 		= sampl;
-    else xL 	= -sampl;
- 
-    yt 		= alfa_rel_*(y1_ - xL) + xL; // release level detector
-
-    if (xL > yt) y1_ 		= xL;
-    else y1_ 	= yt;
-
-    yL_ 	= alfa_atk_*(yL_ - y1_) + y1_; // attack level detector
-
-    level_ 	= yL_;
-    
-    if (level_ < 0) level_ 		= 0;
-    if (level_ >= ADC_HALFRES) level_ 	= ADC_HALFRES;
-    if (level_ > threshold) sout    = (int32_t)(gain*(float)sampl);
-    else sout   = 0;
+	return Process(sampl, sampl);
+}
 
-    return sout;
+int32_t GSP_NoiseGate::Process(int32_t sampl, int32_t key)
+{
+	/*
+    To compute the NoiseGate effect with a side-chain: the gate opens with
+	the level of the key signal. The gate gain ramps up in NGT_OPEN_MS and
+	down in NGT_CLOSE_MS.
+		sampl:
+			Input sample
+		key:
+			Key (side-chain) sample
+		NoiseGate.Process
+			Processed output
+	*/
+ 
+	float 	x, lvl;
+
+	if (level_ != NULL) lvl 	= *level_;
+	else
+	{
+		if (key_hpf > 0)
+		{
+			x 		= key;
+			hpf_y1_ = hpf_a_*(hpf_y1_ + x - hpf_x1_);
+			hpf_x1_ = x;
+			key 	= hpf_y1_;
+		}
+
+		lvl 	= env_.Process(key);
+	}
+
+	if (lvl > thr_on_)
+	{
+		open 		= 1;
+		hold_count_ = hold_;
+	}
+	else if (open && lvl < thr_off_)
+	{
+		if (hold_count_ > 0) hold_count_--;
+		else open 	= 0;
+	}
+
+	if (open) g_ 	= fminf(g_ + g_open_, 1.f);
+	else g_ 	= fmaxf(g_ - g_close_, 0.f);
+
+    return (int32_t)(gain*g_*(float)sampl);
 }
 
 void GSP_NoiseGate::Printout(uint8_t out_list, int32_t chn_pos, char *printout)
@@ -169,15 +277,18 @@ void GSP_NoiseGate::Printout(uint8_t out_list, int32_t chn_pos, char *printout)
 	    "| Attack (20-2000)(ms): %-.1f "
         "| Release (20-2000)(ms): %-.1f "
 	    "| Gain (0.1-1): %-.3f "
-    	"| Threshold (0-1): %-.3f\n", 
+    	"| Threshold (0-1): %-.3f "
+    	"| Hysteresis (dB): %-.1f "
+    	"| Hold (ms): %-.1f "
+    	"| Key HPF (Hz): %-.1f\n", 
         chn_pos, state, attack_ms, release_ms, 
-        gain, threshold);
+        gain, threshold, hysteresis_db, hold_ms, key_hpf);
     }
     if (out_list == 1)
     {
-        sprintf(printout, "->NGT (%ld) %d %-.1f  %-.1f %-.3f %-.3f\n", 
+        sprintf(printout, "->NGT (%ld) %d %-.1f  %-.1f %-.3f %-.3f %-.1f %-.1f %-.1f\n", 
         chn_pos, state, attack_ms, release_ms, 
-        gain, threshold);
+        gain, threshold, hysteresis_db, hold_ms, key_hpf);
     }
 	
 	return;
@@ -191,6 +302,9 @@ void GSP_NoiseGate::GetParams(float fn[])
 	fn[2]   = release_ms;
 	fn[3]   = gain;
 	fn[4]   = threshold;
+	fn[5]   = hysteresis_db;
+	fn[6]   = hold_ms;
+	fn[7]   = key_hpf;
 	
 	return;
 }
@@ -202,7 +316,29 @@ void GSP_NoiseGate::SetParams(float fn[])
 	SetAttackMilliSeconds(fn[1]);
 	SetReleaseMilliSeconds(fn[2]);
 	SetGain(fn[3]);
+	SetHysteresisDB(fn[5]);
 	SetThreshold(fn[4]);
+	SetHoldMilliSeconds(fn[6]);
+	SetKeyFilter(fn[7]);
 
 	return;
 }
+
+int8_t GSP_NoiseGate::SetParam(uint8_t idx, float value)
+{
+	/*
+    To change a single smoothable parameter (see smooth_params) at the 
+	sampling rate, for parameter ramps.
+		idx
+			parameter index, as in GetParams and SetParams
+		value
+			new value
+	Returns 0, or -1 if the parameter isn't smoothable.
+	*/
+
+	if (((smooth_params >> idx) & 1) == 0) return -1;
+
+	SetGain(value);
+
+	return 0;
+}
@@ -4,6 +4,9 @@
 
 #include "../guitar_dsp.h"
 
+#define NGT_OPEN_MS 	0.5 	// gain ramp to open
+#define NGT_CLOSE_MS 	10. 	// gain ramp to close
+
 class GSP_NoiseGate
 {
 	public:
@@ -17,24 +20,38 @@ class GSP_NoiseGate
 		void 		SetReleaseMilliSeconds(float rel_ms);
 		void 		SetGain(float gain);
 		void 		SetThreshold(float thrsd);
+		void 		SetHysteresisDB(float hyst);
+		void 		SetHoldMilliSeconds(float hold);
+		void 		SetKeyFilter(float freq);
+		void 		SetLevel(const float *level);
 		void 		Switch(uint8_t mode);
 		int32_t 	Process(int32_t sampl);
+		int32_t 	Process(int32_t sampl, int32_t key);
 		void		Printout(uint8_t out_list, int32_t chn_pos, char *printout);
 		void 		GetParams(float param[]);
 		void 		SetParams(float param[]);
+		int8_t 		SetParam(uint8_t idx, float value);
 
 		uint32_t 	sample_rate;	// sampling rate
 		float	    gain;
 		float   	threshold;
 		float     	attack_ms, release_ms;
-		uint8_t 	number_params = 5;
+		float 		hysteresis_db; 	// close threshold below the open one
+		float 		hold_ms; 		// open time after the level falls
+		float 		key_hpf; 		// key high pass cutoff (Hz, 0 is off)
+		uint8_t 	open; 			// gate open (1) or closed (0)
+		uint8_t 	number_params = 8;
+		uint8_t 	smooth_params = (1 << 3); 	// parameters with ramps (bit mask)
 		uint8_t 	state;
 
 	private:
 	
-		float   	y1_, yL_;
-        float       level_;
-		float   	alfa_atk_, alfa_rel_;
+		GSP_Envelope 	env_; 		// key level
+		const float *level_; 		// shared detector (or NULL)
+		float 		thr_on_, thr_off_; 	// open and close thresholds (ADC units)
+		uint32_t 	hold_, hold_count_;
+		float 		g_, g_open_, g_close_; 	// gain ramp and its steps
+		float 		hpf_a_, hpf_x1_, hpf_y1_; 	// key filter
 };
 
 #endif 	// GSP_NOISEGATE 	Noise_Gate
@@ -5,6 +5,8 @@
 
 //**#include "DaisyDuino.h"
 
+float 	GSP_Octave::sin_[512];
+
 // *****************************************************************************
 
 void GSP_Octave::Init(uint32_t sampling_rate, int16_t *ptr_buffer, uint32_t buffer_size)
@@ -27,13 +29,19 @@ void GSP_Octave::Init(uint32_t sampling_rate, int16_t *ptr_buffer, uint32_t buff
   
 	gain 		= 1.;
 	mixer 		= 0.5;
+	sub1 		= 1.;
+	sub2 		= 0.5;
+	load 		= 0;
 	
-	for (int i = 0; i < 512; i++)
+	if (sin_[256] == 0)
 	{
-		sin_[i] 	= sin(float(i)/512*GDSP_PI);
+		for (int i = 0; i < 512; i++)
+		{
+			sin_[i] 	= sin(float(i)/512*GDSP_PI);
+		}
 	}
 
-	ComputeParameters();
+	SetEngine(OCT_SPLICE);
 	Switch(GSP_OFF);
 	
 	return;
@@ -69,6 +77,83 @@ void GSP_Octave::SetMixer(float mix)
 	return;
 }
 
+void GSP_Octave::SetEngine(uint8_t oct_engine)
+{
+	/*
+    To select the octave algorithm.
+		oct_engine
+			OCT_SPLICE: one octave up, by splicing the buffer read at double
+			speed. Low CPU, but single notes only.
+			OCT_POLY: one and two octaves down of each band of a complex 
+			filter bank (OCT_BANDS bands from OCT_LOW_HZ to OCT_HIGH_HZ), so 
+			chords are shifted note by note. Heavy: about 110 cycles per band
+			and sample (some 25% of the processor at 48 kHz).
+			OCT_LITE: OCT_POLY with OCT_LITE_BANDS wider bands, for chains
+			with little headroom. Chords with close notes are rougher.
+	*/
+
+	uint32_t 	b, j;
+	float 		q, f, r, w, h, sum;
+
+	engine 	= oct_engine < OCT_ENGINES ? oct_engine : OCT_SPLICE;
+	bands_ 	= engine == OCT_LITE ? OCT_LITE_BANDS : OCT_BANDS;
+
+	// log spaced bands, two complex one-pole stages crossing at about -3 dB
+	q 		= powf(OCT_HIGH_HZ/OCT_LOW_HZ, 1./bands_);
+	for (b = 0; b < bands_; b++)
+	{
+		f 		= OCT_LOW_HZ*powf(q, b + 0.5);
+		r 		= expf(-GDSP_PI*f*(q - 1)/sample_rate);
+		pr_[b] 	= r*cosf(GDSP_2PI*f/sample_rate);
+		pi_[b] 	= r*sinf(GDSP_2PI*f/sample_rate);
+		gk_[b] 	= 1 - r;
+		ar_[b] 	= 0;
+		ai_[b] 	= 0;
+		br_[b] 	= 0;
+		bi_[b] 	= 0;
+		hr_[b] 	= 1;
+		hi_[b] 	= 0;
+		gr_[b] 	= 1;
+		gi_[b] 	= 0;
+	}
+
+	// a tone falls in two or three overlapping bands, whose octaves add 
+	// about in power: normalize by the mean power gain of the bank, on a 
+	// band spacing in the middle of the range
+	sum 	= 0;
+	for (j = 0; j < 8; j++)
+	{
+		w 	= GDSP_2PI*OCT_LOW_HZ*powf(q, bands_/2 + j/8.)/sample_rate;
+		for (b = 0; b < bands_; b++)
+		{
+			r 		= 1 - gk_[b];
+			f 		= w - atan2f(pi_[b], pr_[b]);
+			h 		= gk_[b]*gk_[b]/(1 - 2*r*cosf(f) + r*r);
+			sum 	+= h*h;
+		}
+	}
+	norm_ 	= 2/sqrtf(sum/8);
+	ComputeParameters();
+
+	return;
+}
+
+void GSP_Octave::SetLevels(float sub_1, float sub_2)
+{
+	/*
+    To set the levels of the polyphonic engines.
+		sub_1
+			level of one octave down (0 to 1)
+		sub_2
+			level of two octaves down (0 to 1)
+	*/
+
+	sub1 	= fmaxf(fminf(sub_1, 1), 0);
+	sub2 	= fmaxf(fminf(sub_2, 1), 0);
+
+	return;
+}
+
 void GSP_Octave::Switch(uint8_t mode)
 {
 	/*
@@ -132,9 +217,11 @@ int32_t GSP_Octave::Process(int32_t sampl, uint32_t buffer_pointer)
 			Processed output
 	*/
  
-    static int32_t  sout;
-    static uint32_t pt1, pt2;
-	static float 	alf1, alf2;
+    int32_t  sout;
+    uint32_t pt1, pt2;
+	float 	alf1, alf2;
+
+	if (engine != OCT_SPLICE) return (int32_t)(outsg_*sampl + outef_*ProcessPoly(sampl));
 
 	if (i_ < ns_)
 	{
@@ -204,6 +291,68 @@ int32_t GSP_Octave::Process(int32_t sampl, uint32_t buffer_pointer)
     return (int32_t)(outsg_*sampl + outef_*sout);
 }
 
+float GSP_Octave::ProcessPoly(float x)
+{
+	/*
+    To compute the octaves down of the polyphonic engines. Each band is the
+	analytic signal z of a complex band-pass filter. The unit vector h 
+	follows the half phase of z: h is moved to the middle of itself and 
+	z.conj(h) (which is h advanced by the phase step of z), so h*h stays on
+	z/|z| without phase unwrapping. The unit vector g follows the half 
+	phase of h in the same way. The band output is |z| times the real part
+	of h (one octave down) and of g (two octaves down).
+		x
+			Input sample
+		ProcessPoly
+			Octaves down
+	*/
+
+	uint32_t 	b;
+	float 		ar, ai, br, bi, mag, vr, vi, n, out;
+
+	out 	= 0;
+	for (b = 0; b < bands_; b++)
+	{
+		ar 		= pr_[b]*ar_[b] - pi_[b]*ai_[b] + gk_[b]*x;
+		ai 		= pr_[b]*ai_[b] + pi_[b]*ar_[b];
+		br 		= pr_[b]*br_[b] - pi_[b]*bi_[b] + gk_[b]*ar;
+		bi 		= pr_[b]*bi_[b] + pi_[b]*br_[b] + gk_[b]*ai;
+		ar_[b] 	= ar;
+		ai_[b] 	= ai;
+		br_[b] 	= br;
+		bi_[b] 	= bi;
+
+		mag 	= sqrtf(br*br + bi*bi);
+		if (mag < 1.) continue; 	// silent band keeps its phase
+
+		vr 		= mag*hr_[b] + br*hr_[b] + bi*hi_[b];
+		vi 		= mag*hi_[b] + bi*hr_[b] - br*hi_[b];
+		n 		= vr*vr + vi*vi;
+		if (n == 0) continue;
+		n 		= 1/sqrtf(n);
+		hr_[b] 	= vr*n;
+		hi_[b] 	= vi*n;
+
+		if (sub2 > 0)
+		{
+			vr 		= gr_[b] + hr_[b]*gr_[b] + hi_[b]*gi_[b];
+			vi 		= gi_[b] + hi_[b]*gr_[b] - hr_[b]*gi_[b];
+			n 		= vr*vr + vi*vi;
+			if (n > 0)
+			{
+				n 		= 1/sqrtf(n);
+				gr_[b] 	= vr*n;
+				gi_[b] 	= vi*n;
+			}
+		}
+
+		out 	+= mag*(sub1*hr_[b] + sub2*gr_[b]);
+	}
+
+	// the band keeps half of a real sine: 2|z| is its amplitude
+	return norm_*out;
+}
+
 void GSP_Octave::Printout(uint8_t out_list, int32_t chn_pos, char *printout)
 {
 
@@ -212,16 +361,20 @@ void GSP_Octave::Printout(uint8_t out_list, int32_t chn_pos, char *printout)
         sprintf(printout, 
         "->OCT (%ld): OFF(0)|ON(1) %d "
         "| Mixer (0-1): %-.3f "
-        "| Gain (0-1): %-.3f\n", 
+        "| Gain (0-1): %-.3f "
+        "| Engine: Splice(0)|Poly(1)|Lite(2) %d "
+        "| Sub 1 (0-1): %-.3f "
+        "| Sub 2 (0-1): %-.3f "
+        "| Load (%%): %-.1f\n", 
         chn_pos, state, mixer, 
-        gain);
+        gain, engine, sub1, sub2, load);
     }
     if (out_list == 1)
     {
         sprintf(printout, 
-        "->OCT (%ld) %d %-.3f %-.3f\n", 
+        "->OCT (%ld) %d %-.3f %-.3f %d %-.3f %-.3f %-.1f\n", 
         chn_pos, state, mixer, 
-        gain);
+        gain, engine, sub1, sub2, load);
     }
 	
 	return;
@@ -233,6 +386,9 @@ void GSP_Octave::GetParams(float fn[])
 	fn[0]   = state;
 	fn[1]   = mixer;
 	fn[2]   = gain;
+	fn[3]   = engine;
+	fn[4]   = sub1;
+	fn[5]   = sub2;
 	
 	return;
 }
@@ -243,7 +399,34 @@ void GSP_Octave::SetParams(float fn[])
 	Switch(fn[0]);
 	SetMixer(fn[1]);
 	SetGain(fn[2]);
+	if ((uint8_t)(fn[3] + 0.5) != engine) SetEngine((uint8_t)(fn[3] + 0.5));
+	SetLevels(fn[4], fn[5]);
 
 	return;
 }
 
+int8_t GSP_Octave::SetParam(uint8_t idx, float value)
+{
+	/*
+    To change a single smoothable parameter (see smooth_params) at the 
+	sampling rate, for parameter ramps. The octave
+	windows aren't restarted.
+		idx
+			parameter index, as in GetParams and SetParams
+		value
+			new value
+	Returns 0, or -1 if the parameter isn't smoothable.
+	*/
+
+	if (((smooth_params >> idx) & 1) == 0) return -1;
+
+	if (idx == 4) sub1 	= fmaxf(fminf(value, 1), 0);
+	if (idx == 5) sub2 	= fmaxf(fminf(value, 1), 0);
+	if (idx == 1) mixer 	= fmaxf(fminf(value, 1), 0);
+	if (idx == 2) gain 	= fmaxf(value, 0.1);
+	outef_ 		= mixer*gain;
+	outsg_ 		= (1 - mixer)*gain;
+
+	return 0;
+}
+
@@ -4,6 +4,19 @@
 
 #include "../guitar_dsp.h"
 
+#define OCT_BANDS 		24 		// bands of the polyphonic engine
+#define OCT_LITE_BANDS 	12 		// bands of the lite engine
+#define OCT_LOW_HZ 		60.f 	// band range
+#define OCT_HIGH_HZ 	1600.f
+
+enum oct_engines
+{
+	OCT_SPLICE 		= 0, 		// one octave up, time domain splices (monophonic)
+	OCT_POLY 		= 1, 		// octaves down, sub-band (polyphonic)
+	OCT_LITE 		= 2, 		// OCT_POLY with half the bands (low CPU)
+	OCT_ENGINES,
+};
+
 class GSP_Octave
 {
 	public:
@@ -14,18 +27,25 @@ class GSP_Octave
 		void 		SetShift(float shift);
 		void 		SetGain(float out_gain);
 		void 		SetMixer(float mix);
+		void 		SetEngine(uint8_t oct_engine);
+		void 		SetLevels(float sub_1, float sub_2);
 		void 		Switch(uint8_t mode);
 		void  		ComputeParameters();
 		int32_t 	Process(int32_t sampl, uint32_t buffer_pointer);
 		void		Printout(uint8_t out_list, int32_t chn_pos, char *printout);
 		void 		GetParams(float param[]);
 		void 		SetParams(float param[]);
+		int8_t 		SetParam(uint8_t idx, float value);
 
 		uint32_t 	sample_rate;	// sampling rate
 		float		gain;
 		float 		mixer;
+		uint8_t 	engine; 		// see enum oct_engines
+		float 		sub1, sub2; 	// levels of one and two octaves down
+		float 		load; 			// processing time in the last second (%), set by the caller
 		uint8_t 	state;
-		uint8_t 	number_params = 3;
+		uint8_t 	number_params = 6;
+		uint8_t 	smooth_params = (1 << 1) | (1 << 2) | (1 << 4) | (1 << 5); 	// parameters with ramps (bit mask)
 
 	private:
 	
@@ -34,9 +54,21 @@ class GSP_Octave
 		uint32_t  	k1_, k2_, k1_0_, k2_0_;
 		int32_t   	di_, i_, ns_;
 		float     	outef_, outsg_;
-		float 		sin_[512];
 		float 		sfac_;
 
+		static float 	sin_[512]; 	// window, shared by the copies (scene switch)
+
+		// polyphonic engine
+		float 		ProcessPoly(float x);
+		uint32_t 	bands_;
+		float 		pr_[OCT_BANDS], pi_[OCT_BANDS]; 	// band poles
+		float 		gk_[OCT_BANDS]; 					// band input gains
+		float 		norm_; 			// output gain of the band overlap
+		float 		ar_[OCT_BANDS], ai_[OCT_BANDS]; 	// first stage
+		float 		br_[OCT_BANDS], bi_[OCT_BANDS]; 	// second stage (band signal)
+		float 		hr_[OCT_BANDS], hi_[OCT_BANDS]; 	// half phase (unit)
+		float 		gr_[OCT_BANDS], gi_[OCT_BANDS]; 	// quarter phase (unit)
+
 };
 
 #endif 	// GSP_OCTAVE 	Octave
@@ -269,3 +269,24 @@ void GSP_Overdrive::SetParams(float param[])
 
 	return;
 }
+
+int8_t GSP_Overdrive::SetParam(uint8_t idx, float value)
+{
+	/*
+    To change a single smoothable parameter (see smooth_params) at the 
+	sampling rate, for parameter ramps.
+		idx
+			parameter index, as in GetParams and SetParams
+		value
+			new value
+	Returns 0, or -1 if the parameter isn't smoothable.
+	*/
+
+	if (((smooth_params >> idx) & 1) == 0) return -1;
+
+	if (idx == 1) SetSustain(value);
+	else if (idx == 3) SetMixer(value);
+	else SetGain(value);
+
+	return 0;
+}
@@ -20,6 +20,7 @@ class GSP_Overdrive
 		void		Printout(uint8_t out_list, int32_t chn_pos, char *printout);
 		void 		GetParams(float param[]);
 		void 		SetParams(float param[]);
+		int8_t 		SetParam(uint8_t idx, float value);
 
 		uint32_t 	sample_rate;	// sampling rate
 		float     	sustain;
@@ -27,6 +28,7 @@ class GSP_Overdrive
 		float 		mixer;
 		uint8_t 	state;
 		uint8_t 	number_params = 5;
+		uint8_t 	smooth_params = (1 << 1) | (1 << 3) | (1 << 4); 	// parameters with ramps (bit mask)
 		GSP_Tone 	tone;
 
 	private:
@@ -108,8 +108,8 @@ int32_t GSP_Phaser::Process(int32_t sampl)
 			Processed output
 	*/
  
-	static float rr, aa, bb, b;
-	static int32_t u0, u1, u2, u3, u4, u5, u6, u7, u8, u9, u10, s0;
+	float rr, aa, bb, b;
+	int32_t u0, u1, u2, u3, u4, u5, u6, u7, u8, u9, u10, s0;
   
 	rr    	= am_*lfo.GetValue() + bm_;
 
@@ -197,4 +197,25 @@ void GSP_Phaser::SetParams(float fn[])
 	return;
 }
 
+int8_t GSP_Phaser::SetParam(uint8_t idx, float value)
+{
+	/*
+    To change a single smoothable parameter (see smooth_params) at the 
+	sampling rate, for parameter ramps.
+		idx
+			parameter index, as in GetParams and SetParams
+		value
+			new value
+	Returns 0, or -1 if the parameter isn't smoothable.
+	*/
+
+	if (((smooth_params >> idx) & 1) == 0) return -1;
+
+	if (idx == 1) SetDepth(value);
+	else if (idx == 2) SetLevel(value);
+	else SetGain(value);
+
+	return 0;
+}
+
 
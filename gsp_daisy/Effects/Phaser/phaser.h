@@ -20,6 +20,7 @@ class GSP_Phaser
 		void		Printout(uint8_t out_list, int32_t chn_pos, char *printout);
 		void 		GetParams(float param[]);
 		void 		SetParams(float param[]);
+		int8_t 		SetParam(uint8_t idx, float value);
 
 		uint32_t 	sample_rate;	// sampling rate
 		uint8_t   	state;
@@ -28,6 +29,7 @@ class GSP_Phaser
 		float     	gain;
 		float 		mixer;
 		uint8_t 	number_params = 7;
+		uint8_t 	smooth_params = (1 << 1) | (1 << 2) | (1 << 6); 	// parameters with ramps (bit mask)
 		LowFreqOsc  lfo;
 
 	private:
@@ -0,0 +1,329 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "guitar_dsp.h"
+#include "pitch_detector.h"
+
+static const char 	*note_names[12] = {"C", "C#", "D", "D#", "E", "F",
+						"F#", "G", "G#", "A", "A#", "B"};
+
+// *****************************************************************************
+
+void GSP_PitchDetect::Init(uint32_t sampling_rate)
+{
+	/*
+    Initiate the pitch detector (tuner and LFO source). It runs only while
+	the tuner is on or some LFO is routed to it.
+		sampling_rate
+			ADC sampling rate (Hz)
+	*/
+
+	state 		= GSP_OFF;
+	mute 		= GSP_OFF;
+	route 		= 0;
+	target_ 	= 0;
+	cv_ 		= 0;
+	cv 			= 0;
+
+	SetThreshold(0.15);
+	SetSampleRate(sampling_rate);
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_PitchDetect::SetSampleRate(uint32_t sampling_rate)
+{
+	/*
+    To set the sampling rate and restart the analysis. The input is low-pass
+	filtered and decimated to about PTD_RATE.
+		sampling_rate
+			ADC sampling rate (Hz)
+	*/
+
+	sample_rate 	= sampling_rate;
+	decimation_ 	= (sample_rate + PTD_RATE/2)/PTD_RATE;
+	if (decimation_ < 1) decimation_ 	= 1;
+	rate_ 			= (float)sample_rate/decimation_;
+
+	lag_min_ 	= (uint32_t)(rate_/PTD_MAX_HZ);
+	lag_max_ 	= (uint32_t)(rate_/PTD_MIN_HZ + 1);
+	if (lag_min_ < 2) lag_min_ 	= 2;
+	if (lag_max_ > PTD_MAX_LAG - 1) lag_max_ 	= PTD_MAX_LAG - 1;
+
+	// two poles at 1 kHz: fundamental and low harmonics only
+	lpk_ 	= 1. - expf(-GDSP_2PI*1000./sample_rate);
+	alfa_ 	= 1. - expf(-1000./20./sample_rate); 	// 20 ms CV smoothing
+
+	memset(ring_, 0, sizeof(ring_));
+	lp1_ 		= 0;
+	lp2_ 		= 0;
+	count_ 		= 0;
+	write_ 		= 0;
+	hop_ 		= 0;
+	start_ 		= 0;
+	lag_ 		= 0;
+	energy_ 	= 0;
+	frequency 	= 0;
+	confidence 	= 0;
+	note 		= 0;
+	cents 		= 0;
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_PitchDetect::SetThreshold(float thr)
+{
+	/*
+    To set the threshold of the normalized difference function. A period is
+	accepted at its first dip below the threshold.
+		thr
+			threshold (0.05 to 0.5), 0.15 is a good start
+	*/
+
+	threshold 	= fmaxf(fminf(thr, 0.5), 0.05);
+
+	return;
+}
+
+// *****************************************************************************
+
+int32_t GSP_PitchDetect::Route(int32_t effect, uint8_t on)
+{
+	/*
+    To drive the LFO_EXTERNAL profile of an effect by the detected pitch
+	(phaser, wahwah, chorus, vibrato, tremolo and volume).
+		effect
+			effect number (see enum gsp_effects)
+		on
+			1 to route, 0 to remove
+	Returns 0 if succeeded or -1 if the effect has no LFO.
+	*/
+
+	if (effect != GSP_PHR && effect != GSP_WAH && effect != GSP_CHS
+		&& effect != GSP_VBT && effect != GSP_TML && effect != GSP_VOL
+		&& effect != GSP_PHR2 && effect != GSP_WAH2) return -1;
+
+	if (on) route 	|= 1UL << effect;
+	else route 		&= ~(1UL << effect);
+
+	return 0;
+}
+
+// *****************************************************************************
+
+uint8_t GSP_PitchDetect::Routed(int32_t effect)
+{
+	/*
+    Returns 1 if the effect is driven by the detected pitch.
+	*/
+
+	return (route >> effect) & 1;
+}
+
+// *****************************************************************************
+
+void GSP_PitchDetect::Process(int32_t sampl)
+{
+	/*
+    To feed a sample of the guitar input. Shall be called once per sample.
+	The analysis (YIN) runs on the decimated signal and is spread over the
+	samples: a lag of the difference function (PTD_WINDOW products) is
+	computed for each decimated sample, and a new frame starts every
+	PTD_HOP decimated samples. At 48 kHz this costs 2 products per sample
+	on the filter, plus 21 on average on the difference function.
+		sampl
+			input sample
+	*/
+
+	if (state == GSP_OFF && route == 0) return;
+
+	cv_ 	+= alfa_*(target_ - cv_);
+	cv 		= (uint32_t)cv_;
+
+	lp1_ 	+= lpk_*(sampl - lp1_);
+	lp2_ 	+= lpk_*(lp1_ - lp2_);
+	count_++;
+	if (count_ < decimation_) return;
+	count_ 	= 0;
+
+	ring_[write_] 	= lp2_;
+	write_ 	= (write_ + 1) & (PTD_RING - 1);
+
+	if (lag_ > 0) Step();
+
+	hop_++;
+	if (hop_ >= PTD_HOP && lag_ == 0)
+	{
+		// analyse the last PTD_WINDOW + lag_max_ samples
+		hop_ 	= 0;
+		start_ 	= (write_ - PTD_WINDOW - lag_max_) & (PTD_RING - 1);
+		lag_ 	= 1;
+	}
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_PitchDetect::Step()
+{
+	/*
+    To compute one lag of the difference function of the current frame,
+	or to estimate the pitch after the last lag.
+	*/
+
+	uint32_t 	j, a, b;
+	float 		d, sum;
+
+	if (lag_ > lag_max_)
+	{
+		Estimate();
+		lag_ 	= 0;
+		return;
+	}
+
+	sum 	= 0;
+	a 		= start_;
+	b 		= (start_ + lag_) & (PTD_RING - 1);
+	if (lag_ == 1) energy_ 	= 0;
+	for (j = 0; j < PTD_WINDOW; j++)
+	{
+		d 		= ring_[a] - ring_[b];
+		sum 	+= d*d;
+		if (lag_ == 1) energy_ 	+= ring_[a]*ring_[a];
+		a 		= (a + 1) & (PTD_RING - 1);
+		b 		= (b + 1) & (PTD_RING - 1);
+	}
+	diff_[lag_] 	= sum;
+	lag_++;
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_PitchDetect::Estimate()
+{
+	/*
+    To find the period in the cumulative mean normalized difference
+	function: the first dip below the threshold, refined by parabolic
+	interpolation on the dip of its longest multiple within the frame,
+	which divides the error by the multiple (high notes). Without dip 
+	(noise, chords) or with a weak signal, the frequency is 0 and the CV 
+	keeps the last pitch.
+	*/
+
+	uint32_t 	tau, best, k;
+	float 		run, cmnd, prev, next, best_val, shift, period, semi;
+
+	run 		= 0;
+	best 		= 0;
+	best_val 	= 1e9;
+	for (tau = 1; tau <= lag_max_; tau++)
+	{
+		run 		+= diff_[tau];
+		diff_[tau] 	= run > 0 ? diff_[tau]*tau/run : 1.;
+		if (tau < lag_min_ + 1) continue;
+		// diff_[tau - 1] is a local minimum below the threshold
+		if (diff_[tau - 1] < threshold && diff_[tau - 1] <= diff_[tau]
+			&& diff_[tau - 1] <= diff_[tau - 2])
+		{
+			best 		= tau - 1;
+			best_val 	= diff_[best];
+			break;
+		}
+	}
+
+	if (best == 0 || energy_ < (float)PTD_WINDOW*PTD_SILENCE*PTD_SILENCE)
+	{
+		frequency 	= 0;
+		confidence 	= 0;
+		return;
+	}
+
+	// normalize the rest of the function for the multiples
+	for (tau = best + 2; tau <= lag_max_; tau++)
+	{
+		run 		+= diff_[tau];
+		diff_[tau] 	= run > 0 ? diff_[tau]*tau/run : 1.;
+	}
+
+	prev 	= diff_[best - 1];
+	cmnd 	= diff_[best];
+	next 	= diff_[best + 1];
+	shift 	= prev + next - 2*cmnd;
+	shift 	= shift > 0 ? 0.5*(prev - next)/shift : 0;
+	period 	= best + shift;
+
+	k 		= (uint32_t)((lag_max_ - 1)/period);
+	if (k > 1)
+	{
+		tau 	= (uint32_t)(k*period + 0.5);
+		if (diff_[tau - 1] < diff_[tau]) tau--;
+		else if (diff_[tau + 1] < diff_[tau]) tau++;
+		if (tau < lag_max_)
+		{
+			prev 	= diff_[tau - 1];
+			cmnd 	= diff_[tau];
+			next 	= diff_[tau + 1];
+			shift 	= prev + next - 2*cmnd;
+			shift 	= shift > 0 ? 0.5*(prev - next)/shift : 0;
+			period 	= (tau + shift)/k;
+		}
+	}
+
+	frequency 	= rate_/period;
+	confidence 	= 1. - best_val;
+	semi 		= 12.*log2f(frequency/440.) + 69.;
+	note 		= (int32_t)floorf(semi + 0.5);
+	cents 		= 100.*(semi - note);
+
+	// log pitch scaled to the LFFG range
+	target_ 	= (ADC_RES - 1)*log2f(frequency/PTD_MIN_HZ)/log2f(PTD_MAX_HZ/PTD_MIN_HZ);
+	if (target_ > ADC_RES - 1) target_ 	= ADC_RES - 1;
+	if (target_ < 0) target_ 	= 0;
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_PitchDetect::Printout(uint8_t out_list, GSP_SignalChain *chain, char *printout)
+{
+	int32_t 	i;
+	char 		pname[8], nname[8];
+
+	if (frequency > 0) sprintf(nname, "%s%ld", note_names[note % 12], note/12 - 1);
+	else strcpy(nname, "--");
+
+    if (out_list == 0)
+    {
+        sprintf(printout,
+        "->TUN: OFF(0)|ON(1) %d | Mute: OFF(0)|ON(1) %d "
+        "| Threshold (0.05-0.5): %-.2f | Note: %s | Frequency (Hz): %-.1f "
+        "| Cents: %+-.1f | Confidence: %-.2f | Routes:",
+        state, mute, threshold, nname, frequency, cents, confidence);
+    }
+    if (out_list == 1)
+    {
+        sprintf(printout,
+        "->TUN %d %d %-.2f %s %-.1f %+-.1f %-.2f",
+        state, mute, threshold, nname, frequency, cents, confidence);
+    }
+
+	for (i = 0; i < MAX_EFFECT_NUMBER; i++)
+	{
+		if (Routed(i) == 0) continue;
+		chain->Name(i, pname);
+		strcat(printout, " ");
+		strcat(printout, pname);
+	}
+	strcat(printout, "\n");
+
+	return;
+}
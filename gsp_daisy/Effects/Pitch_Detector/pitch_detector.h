@@ -0,0 +1,58 @@
+#ifndef GSP_PITCH_DETECTOR_H
+#define GSP_PITCH_DETECTOR_H
+
+#include <stdint.h>
+#include "gsp_chain.h"
+
+#define PTD_RATE 		8000 	// decimated sampling rate (Hz, nominal)
+#define PTD_WINDOW 		128 	// difference function window (decimated samples)
+#define PTD_MAX_LAG 	160 	// longest period (decimated samples)
+#define PTD_HOP 		160 	// decimated samples between estimates
+#define PTD_RING 		512 	// decimated input ring (power of 2)
+#define PTD_MIN_HZ 		60.f 	// lowest detected pitch (drop tunings)
+#define PTD_MAX_HZ 		1500.f 	// highest detected pitch
+#define PTD_SILENCE 	100 	// RMS below which there is no pitch (-50 dBFS)
+
+class GSP_PitchDetect
+{
+	public:
+		GSP_PitchDetect() {}
+		~GSP_PitchDetect() {}
+
+		void 		Init(uint32_t sampling_rate);
+		void 		SetSampleRate(uint32_t sampling_rate);
+		void 		SetThreshold(float thr);
+		int32_t 	Route(int32_t effect, uint8_t on);
+		uint8_t 	Routed(int32_t effect);
+		void 		Process(int32_t sampl);
+		void		Printout(uint8_t out_list, GSP_SignalChain *chain, char *printout);
+
+		uint32_t 	sample_rate;	// sampling rate
+		uint8_t 	state; 			// tuner on (1) or off (0)
+		uint8_t 	mute; 			// silences the output while tuning
+		float 		threshold; 		// YIN threshold (lower is stricter)
+		uint32_t 	route; 			// LFOs driven by the pitch (bit mask)
+		float 		frequency; 		// detected pitch (Hz), 0 if none
+		float 		confidence; 	// 0 to 1
+		int32_t 	note; 			// MIDI note number
+		float 		cents; 			// deviation from the note (-50 to 50)
+		uint32_t 	cv; 			// log pitch (0 to 65535), updated every sample
+
+	private:
+		void 		Step();
+		void 		Estimate();
+
+		uint32_t 	decimation_, count_;
+		float 		rate_; 			// decimated sampling rate (Hz)
+		float 		lp1_, lp2_, lpk_; 	// anti-alias lowpass
+		float 		ring_[PTD_RING];
+		uint32_t 	write_, hop_;
+		uint32_t 	start_; 		// first sample of the frame being analysed
+		uint32_t 	lag_; 			// next lag to compute (0: idle)
+		uint32_t 	lag_min_, lag_max_;
+		float 		diff_[PTD_MAX_LAG + 1]; 	// difference function
+		float 		energy_;
+		float 		target_, cv_, alfa_; 	// smoothed CV
+};
+
+#endif 	// GSP_PITCH_DETECTOR_H
@@ -3,6 +3,24 @@
 
 #include "pitch_shifter.h"
 
+// scale degrees (semitones from the key) of the harmonizer modes
+static const int8_t 	sft_scales[2][7] = {{0, 2, 4, 5, 7, 9, 11}, 	// major
+							{0, 2, 3, 5, 7, 8, 10}}; 					// natural minor
+
+static int32_t ScaleShift(const int8_t *scale, int32_t degree, int32_t steps)
+{
+	/*
+    Returns the semitones from a scale degree (0 to 6) to the degree a 
+	number of steps (-7 to 7) away, crossing octaves.
+	*/
+
+	int32_t 	s;
+
+	s 	= degree + steps + 14;
+
+	return scale[s % 7] + 12*(s/7 - 2) - scale[degree];
+}
+
 // *****************************************************************************
 
 void GSP_PitchShifter::Init(uint32_t sampling_rate, int16_t *ptr_buffer, uint32_t buffer_size)
@@ -25,7 +43,36 @@ void GSP_PitchShifter::Init(uint32_t sampling_rate, int16_t *ptr_buffer, uint32_
   
 	gain 		= 1.;
 	mixer 		= 0.5;
+	mode 		= SFT_SYNC;
+	key 		= 0;
+	interval 	= 2;
 	SetShift(5.);
+
+	// splices of about 30 ms, crossfaded in 5 ms, periods from 70 to 1300 Hz
+	window_ 	= 0.030*sample_rate;
+	fade_len_ 	= 0.005*sample_rate;
+	fade_inv_ 	= 1./fade_len_;
+	pmin_ 		= (float)sample_rate/1300.;
+	pmax_ 		= (float)sample_rate/70.;
+	lpk_ 		= 1 - expf(-2*GDSP_PI*700.*SFT_DECIMATION/sample_rate);
+	period_ 	= 0;
+	lp_ 		= 0;
+	lp_old_ 	= 0;
+	zc_frac_ 	= 0;
+	env_ 		= 0;
+	dec_acc_ 	= 0;
+	dec_count_ 	= 0;
+	zc_count_ 	= 0;
+	zc_state_ 	= 0;
+
+	// harmonizer: the ratio glides to a new note in 10 ms
+	glide_ 		= 1 - expf(-1000./10./sample_rate);
+	note_ 		= 0;
+	harmony_ 	= 0;
+	target_ 	= 1;
+	ratio_ 		= 1;
+	top_ 		= 1;
+
 	ComputeParameters();
 	Switch(GSP_OFF);
 	
@@ -37,10 +84,12 @@ void GSP_PitchShifter::SetShift(float shift)
 	/*
     To set the input gain of PitchShifter effect
 		shift
-			tone shift (up) in semitones (0 to 12)
+			tone shift in semitones: 0 to 12 (up) in SFT_CLASSIC mode,
+			-24 to 24 in SFT_SYNC mode (not used by the harmonizer)
 	*/
 
-	pshift  = fmaxf(fminf(shift, 12.), 0.);
+	if (mode == SFT_CLASSIC) pshift  = fmaxf(fminf(shift, 12.), 0.);
+	else pshift  = fmaxf(fminf(shift, 24.), -24.);
 
 	return;
 }
@@ -75,6 +124,61 @@ void GSP_PitchShifter::SetMixer(float mix)
 	return;
 }
 
+void GSP_PitchShifter::SetMode(uint8_t sft_mode)
+{
+	/*
+    To select the shift algorithm. The shift is clipped to the range of 
+	the new mode.
+		sft_mode
+			SFT_CLASSIC: two read heads with fixed windows, shift up only
+			SFT_SYNC: read heads spliced at multiples of the estimated 
+			period of the input, so the splices are in phase
+			SFT_MAJOR, SFT_MINOR: harmonizer on the SFT_SYNC engine, the
+			shift follows the input note (see SetHarmony)
+	*/
+
+	mode 	= sft_mode < SFT_MODES ? sft_mode : (uint8_t)SFT_SYNC;
+	SetShift(pshift);
+	ComputeParameters();
+
+	return;
+}
+
+void GSP_PitchShifter::SetHarmony(float key_note, float scale_steps)
+{
+	/*
+    To set the harmonizer (SFT_MAJOR and SFT_MINOR modes). The shift 
+	follows the input note, so that the harmony stays in the scale: in C
+	major, a third (2 steps) shifts C by 4 semitones (E) and D by 3 (F).
+	Notes out of the scale are shifted as the scale note below them.
+		key_note
+			key of the scale: 0 (C) to 11 (B)
+		scale_steps
+			interval in scale steps: -7 to 7 (2: third, 4: fifth, 7: octave,
+			negative below the input)
+	*/
+
+	int32_t 	d, shift;
+
+	key 		= (uint8_t)fmaxf(fminf(key_note, 11), 0);
+	interval 	= (int8_t)fmaxf(fminf(scale_steps, 7), -7);
+
+	// the faster read head needs room for the largest shift of the interval
+	shift 	= 0;
+	for (d = 0; d < 7; d++)
+	{
+		if (ScaleShift(sft_scales[0], d, interval) > shift) shift 	= ScaleShift(sft_scales[0], d, interval);
+		if (ScaleShift(sft_scales[1], d, interval) > shift) shift 	= ScaleShift(sft_scales[1], d, interval);
+	}
+	top_ 		= powf(2, shift/12.);
+
+	note_ 		= 0; 		// the next period estimate recomputes the shift
+	Harmonize();
+	ComputeParameters();
+
+	return;
+}
+
 void GSP_PitchShifter::Switch(uint8_t mode)
 {
 	/*
@@ -102,7 +206,7 @@ void  GSP_PitchShifter::ComputeParameters()
 	outef_ 		= mixer*gain;
 	outsg_ 		= (1 - mixer)*gain;
   
-	p   		= powf(2, pshift/12); // frequency ratio
+	p   		= powf(2, fmaxf(fminf(pshift, 12), 0)/12); // frequency ratio
 
 	me 			= 4000;
 	ne 			= 357;
@@ -121,6 +225,17 @@ void  GSP_PitchShifter::ComputeParameters()
 	d_ 			= d1_;
 	ns_ 		= (float)ne/p;
 
+	// pitch-synchronous engine: the head running faster than the input 
+	// (p > 1) needs room for the crossfade before reaching the input
+	p 			= mode >= SFT_MAJOR ? target_ : powf(2, pshift/12);
+	ratio_ 		= p;
+	step_ 		= 1 - p;
+	if (mode >= SFT_MAJOR) p 	= top_;
+	dmin_ 		= p > 1 ? fade_len_*(p - 1) + 2 : 2;
+	span_ 		= window_;
+	dly_ 		= p > 1 ? dmin_ + window_ : dmin_;
+	fade_ 		= 0;
+
 	return;
 }
  
@@ -136,9 +251,20 @@ int32_t GSP_PitchShifter::Process(int32_t sampl, uint32_t buffer_pointer)
 			Processed output
 	*/
  
-    static int32_t    sout;
-    static uint32_t   pt1, pt2;
-    static float      alfa;
+    int32_t    sout;
+    uint32_t   pt1, pt2;
+    float      alfa;
+
+	if (mode != SFT_CLASSIC)
+	{
+		EstimatePeriod(sampl);
+		if (mode >= SFT_MAJOR)
+		{
+			ratio_ 	+= glide_*(target_ - ratio_);
+			step_ 	= 1 - ratio_;
+		}
+		return (int32_t)(outsg_*sampl + outef_*ProcessSync(buffer_pointer));
+	}
   
     if (i_ < ns_)
     {
@@ -188,6 +314,155 @@ int32_t GSP_PitchShifter::Process(int32_t sampl, uint32_t buffer_pointer)
     return (int32_t)(outsg_*sampl + outef_*sout);
 }
 
+void GSP_PitchShifter::EstimatePeriod(int32_t sampl)
+{
+	/*
+    To estimate the period of the input, once every SFT_DECIMATION samples:
+	the decimated signal is low passed (700 Hz) to keep the fundamental, 
+	and the time between positive going zero crossings (with hysteresis at 
+	30% of the signal level) is averaged. The crossings are interpolated
+	between the decimated samples. The estimate is kept through silence 
+	and unvoiced parts. The harmonizer picks its note at each estimate.
+		sampl:
+			Input sample
+	*/
+
+	float 	x, t, a, thr;
+
+	dec_acc_ 	+= sampl;
+	dec_count_++;
+	if (dec_count_ < SFT_DECIMATION) return;
+
+	x 			= (float)dec_acc_/SFT_DECIMATION;
+	dec_acc_ 	= 0;
+	dec_count_ 	= 0;
+
+	lp_old_ 	= lp_;
+	lp_ 		+= lpk_*(x - lp_);
+	env_ 		+= 0.01*(fabsf(lp_) - env_);
+	if (zc_count_*SFT_DECIMATION < pmax_) zc_count_++;
+
+	thr 		= 0.3*env_;
+	if (zc_state_ <= 0 && lp_ > thr)
+	{
+		// positive going crossing, a (0 to 1) decimated samples ago
+		a 			= lp_ > lp_old_ ? fminf((lp_ - thr)/(lp_ - lp_old_), 1) : 0;
+		t 			= (zc_count_ - a + zc_frac_)*SFT_DECIMATION;
+		if (zc_state_ < 0 && t >= pmin_ && t < pmax_)
+		{
+			if (period_ == 0) period_ 	= t;
+			else period_ 	+= 0.25*(t - period_);
+			if (mode >= SFT_MAJOR) Harmonize();
+		}
+		zc_state_ 	= 1;
+		zc_count_ 	= 0;
+		zc_frac_ 	= a;
+	}
+	else if (zc_state_ > 0 && lp_ < -thr) zc_state_ 	= -1;
+
+	return;
+}
+
+void GSP_PitchShifter::Harmonize()
+{
+	/*
+    To compute the shift of the harmonizer for the estimated input note.
+	The note changes only when the pitch is 0.7 semitones away from it 
+	(bends and vibrato don't flip the harmony). Runs once per input period.
+	*/
+
+	const int8_t 	*scale;
+	float 			semi;
+	int32_t 		pc, d;
+
+	if (period_ == 0) return;
+
+	semi 	= 12*log2f(sample_rate/(440*period_)) + 69;
+	if (note_ != 0 && fabsf(semi - note_) < 0.7) return;
+	note_ 	= (int32_t)floorf(semi + 0.5);
+
+	// degree of the note in the scale (or of the scale note below it)
+	scale 	= sft_scales[mode == SFT_MINOR ? 1 : 0];
+	pc 		= ((note_ - key) % 12 + 12) % 12;
+	for (d = 6; scale[d] > pc; d--);
+
+	harmony_ 	= ScaleShift(scale, d, interval);
+	target_ 	= powf(2, harmony_/12);
+
+	return;
+}
+
+float GSP_PitchShifter::Read(uint32_t buffer_pointer, float delay)
+{
+	/*
+    To read the buffer at a fractional delay (linear interpolation).
+	*/
+
+	uint32_t 	d, p0, p1;
+	float 		frac;
+
+	d 		= (uint32_t)delay;
+	frac 	= delay - d;
+	if (buffer_pointer >= d) p0 	= buffer_pointer - d;
+	else p0 	= buffer_size_ - d + buffer_pointer;
+	if (p0 > 0) p1 	= p0 - 1;
+	else p1 	= buffer_size_ - 1;
+
+	return ptr_buffer_[p0] + frac*(ptr_buffer_[p1] - ptr_buffer_[p0]);
+}
+
+int32_t GSP_PitchShifter::ProcessSync(uint32_t buffer_pointer)
+{
+	/*
+    To compute the shifted signal of the pitch-synchronous engine. A read 
+	head moves through the buffer at the shift ratio. When it runs out of
+	room, a second head starts one splice length away, and the heads are 
+	crossfaded. The splice length is the multiple of the estimated period
+	closest to 30 ms, so both heads read the same point of the waveform 
+	cycle and the crossfade doesn't beat (warble). Without a period 
+	estimate the splice is 30 ms.
+	Cost per sample: one interpolated read (two during a 5 ms crossfade),
+	plus one step of the period estimate every SFT_DECIMATION samples.
+		buffer_pointer
+			buffer pointer (must be updated by user, once per sample)
+		ProcessSync
+			Shifted sample
+	*/
+
+	float 	out, w;
+
+	out 	= Read(buffer_pointer, dly_);
+	dly_ 	+= step_;
+
+	if (fade_ > 0)
+	{
+		// crossfade from the old head (dly_) to the new one (dly_b_)
+		w 		= fade_*fade_inv_;
+		out 	= w*out + (1 - w)*Read(buffer_pointer, dly_b_);
+		dly_b_ 	+= step_;
+		fade_--;
+		if (fade_ == 0) dly_ 	= dly_b_;
+	}
+	else
+	{
+		if (period_ > 0) span_ 	= period_*fmaxf(roundf(window_/period_), 1);
+		else span_ 	= window_;
+
+		if (step_ < 0 && dly_ < dmin_)
+		{
+			dly_b_ 	= dly_ + span_;
+			fade_ 	= fade_len_;
+		}
+		if (step_ > 0 && dly_ > dmin_ + span_)
+		{
+			dly_b_ 	= dly_ - span_;
+			fade_ 	= fade_len_;
+		}
+	}
+
+	return out;
+}
+
 void GSP_PitchShifter::Printout(uint8_t out_list, int32_t chn_pos, char *printout)
 {
 
@@ -195,18 +470,21 @@ void GSP_PitchShifter::Printout(uint8_t out_list, int32_t chn_pos, char *printou
     {
         sprintf(printout, 
         "->SFT (%ld): OFF(0)|ON(1) %d "
-        "| Shift (up) (0-12): %-.3f "
+        "| Shift (-24-24): %-.3f "
         "| Mixer (0-1): %-.3f "
-        "| Gain (0-1): %-.3f\n", 
+        "| Gain (0-1): %-.3f "
+        "| Mode: Classic(0)|Synchronous(1)|Major(2)|Minor(3) %d "
+        "| Key (0-11): %d "
+        "| Interval (-7-7): %d\n", 
         chn_pos, state, pshift, mixer, 
-        gain);
+        gain, mode, key, interval);
     }
     if (out_list == 1)
     {
         sprintf(printout, 
-        "->SFT (%ld) %d %-.3f %-.3f  %-.3f\n", 
+        "->SFT (%ld) %d %-.3f %-.3f  %-.3f %d %d %d\n", 
         chn_pos, state, pshift, mixer, 
-        gain);
+        gain, mode, key, interval);
     }
 	
 	return;
@@ -219,6 +497,9 @@ void GSP_PitchShifter::GetParams(float fn[])
 	fn[1]   = pshift;
 	fn[2]   = mixer;
 	fn[3]   = gain;
+	fn[4]   = mode;
+	fn[5]   = key;
+	fn[6]   = interval;
 	
 	return;
 }
@@ -227,6 +508,8 @@ void GSP_PitchShifter::SetParams(float fn[])
 {
 
 	Switch(fn[0]);
+	mode 	= (uint8_t)fminf(fmaxf(fn[4] + 0.5, 0), SFT_MODES - 1);
+	SetHarmony(fn[5], fn[6]);
 	SetShift(fn[1]);
 	SetMixer(fn[2]);
 	SetGain(fn[3]);
@@ -234,4 +517,27 @@ void GSP_PitchShifter::SetParams(float fn[])
 	return;
 }
 
+int8_t GSP_PitchShifter::SetParam(uint8_t idx, float value)
+{
+	/*
+    To change a single smoothable parameter (see smooth_params) at the 
+	sampling rate, for parameter ramps. The shift
+	windows aren't restarted.
+		idx
+			parameter index, as in GetParams and SetParams
+		value
+			new value
+	Returns 0, or -1 if the parameter isn't smoothable.
+	*/
+
+	if (((smooth_params >> idx) & 1) == 0) return -1;
+
+	if (idx == 2) mixer 	= fmaxf(fminf(value, 1), 0);
+	else gain 	= fmaxf(value, 0.1);
+	outef_ 		= mixer*gain;
+	outsg_ 		= (1 - mixer)*gain;
+
+	return 0;
+}
+
 
@@ -4,6 +4,17 @@
 
 #include "../guitar_dsp.h"
 
+#define SFT_DECIMATION 	4 		// period estimate at sample_rate/4
+
+enum sft_modes
+{
+	SFT_CLASSIC 	= 0, 		// fixed windows, up to 12 semitones (low CPU)
+	SFT_SYNC 		= 1, 		// pitch-synchronous splices, -24 to 24 semitones
+	SFT_MAJOR 		= 2, 		// harmonizer, interval in a major scale
+	SFT_MINOR 		= 3, 		// harmonizer, interval in a natural minor scale
+	SFT_MODES,
+};
+
 class GSP_PitchShifter
 {
 	public:
@@ -14,19 +25,26 @@ class GSP_PitchShifter
 		void 		SetShift(float shift);
 		void 		SetGain(float out_gain);
 		void 		SetMixer(float mix);
+		void 		SetMode(uint8_t sft_mode);
+		void 		SetHarmony(float key_note, float scale_steps);
 		void 		Switch(uint8_t mode);
 		void  		ComputeParameters();
 		int32_t 	Process(int32_t sampl, uint32_t buffer_pointer);
 		void		Printout(uint8_t out_list, int32_t chn_pos, char *printout);
 		void 		GetParams(float param[]);
 		void 		SetParams(float param[]);
+		int8_t 		SetParam(uint8_t idx, float value);
 
 		uint32_t 	sample_rate;	// sampling rate
 		float		gain;
 		float 		pshift;
 		float 		mixer;
+		uint8_t 	mode; 			// see enum sft_modes
+		uint8_t 	key; 			// harmonizer key (0 = C to 11 = B)
+		int8_t 		interval; 		// harmonizer interval (scale steps)
 		uint8_t 	state;
-		uint8_t 	number_params = 4;
+		uint8_t 	number_params = 7;
+		uint8_t 	smooth_params = (1 << 2) | (1 << 3); 	// parameters with ramps (bit mask)
 
 	private:
 	
@@ -36,6 +54,31 @@ class GSP_PitchShifter
 		int32_t   	dk_, di_, i_, d1_, d2_, d3_, d_, ns_;
 		float     	outef_, outsg_;
 
+		// pitch-synchronous engine
+		int32_t 	ProcessSync(uint32_t buffer_pointer);
+		void 		EstimatePeriod(int32_t sampl);
+		float 		Read(uint32_t buffer_pointer, float delay);
+		float 		step_; 			// delay change per sample (1 - ratio)
+		float 		dly_, dly_b_; 	// delays of the read heads (samples)
+		float 		dmin_; 			// minimum delay
+		float 		window_; 		// target splice length (samples)
+		float 		span_; 			// current splice length (period multiple)
+		uint32_t 	fade_, fade_len_;
+		float 		fade_inv_;
+		int32_t 	dec_acc_;
+		uint32_t 	dec_count_, zc_count_;
+		int8_t 		zc_state_;
+		float 		lp_, lpk_, env_; 	// decimated low pass and its level
+		float 		lp_old_, zc_frac_; 	// zero crossing interpolation
+		float 		period_; 		// estimated period (samples, 0 if none)
+		float 		pmin_, pmax_; 	// valid periods (samples)
+
+		// harmonizer
+		void 		Harmonize();
+		int32_t 	note_; 			// input note (MIDI number)
+		float 		harmony_; 		// shift of the current note (semitones)
+		float 		ratio_, target_, glide_; 	// smoothed frequency ratio
+		float 		top_; 			// largest ratio of the interval
 };
 
 #endif 	// GSP_PSHIFTER 	Pitch Shifter
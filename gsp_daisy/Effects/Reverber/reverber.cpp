@@ -27,9 +27,12 @@ void GSP_Reverber::Init(uint32_t sampling_rate, int16_t *ptr_buffer, uint32_t bu
 	ptr_buffer_1 	= ptr_buffer + buffer_size_;
 	ptr_buffer_2 	= ptr_buffer + 2*buffer_size_;
 	ptr_buffer_3 	= ptr_buffer + 3*buffer_size_;
+	spillover 		= 0;
+	tail 			= 0;
 	
 	SetReverberTimeMS(1000.);
 	SetGain(1.);
+	SetSpread(0.5);
 	Switch(GSP_OFF);
 	ComputeParameters();
 	
@@ -68,11 +71,20 @@ void GSP_Reverber::SetGain(float output_gain)
 void GSP_Reverber::Switch(uint8_t mode)
 {
 	/*
-    To switch the effect on and off.
+    To switch the effect on and off. With spillover, the reverber tail keeps
+	ringing after the effect is switched off (see Tail).
 		mode
 			Condition switch: ON or OFF
 	*/
 
+	if (mode == GSP_OFF && state == GSP_ON && spillover)
+	{
+		tail_peak_ 	= 0;
+		tail_count_ = 0;
+		tail 		= 1;
+	}
+	if (mode != GSP_OFF) tail 	= 0;
+
 	state 		= GSP_ON;
 	if (mode == GSP_OFF) state = GSP_OFF;
 
@@ -143,6 +155,8 @@ void GSP_Reverber::ComputeParameters()
     rim1_3_ 	= 0;  // rim1
 
     ynm1_ 		= 0;
+    yd_ 		= 0;
+    ydm1_ 		= 0;
     n_ 			= 0;
 
     // Y: A   = 1/2*[1 1 1 1; 1 -1 1 -1; 1 1 -1 -1; 1 -1 -1 1];
@@ -165,13 +179,13 @@ int32_t GSP_Reverber::Process(int32_t sampl)
 			Processed output
    */
 
-    static uint32_t nMi;
-    static int32_t  w_0, w_1, w_2, w_3;
-    static int32_t  awp01, awp23, awd01, awd23;
-    static int32_t  aw_0, aw_1, aw_2, aw_3;
-    static int32_t  ri_0, ri_1, ri_2, ri_3;
-    static float    yn;
-    static int32_t  sout;
+    uint32_t nMi;
+    int32_t  w_0, w_1, w_2, w_3;
+    int32_t  awp01, awp23, awd01, awd23;
+    int32_t  aw_0, aw_1, aw_2, aw_3;
+    int32_t  ri_0, ri_1, ri_2, ri_3;
+    float    yn;
+    int32_t  sout;
 
 	// Get the delay lines
     if (n_ < Mi_0_)  nMi   = n_ - Mi_0_ + buffer_size_;
@@ -233,6 +247,7 @@ int32_t GSP_Reverber::Process(int32_t sampl)
 
 	// Combine outputs
 	yn 			= w_0 + w_1 + w_2 + w_3;
+	yd_ 		= w_0 - w_1 + w_2 - w_3; 	// decorrelated taps for the side
 	
 	// Apply tonal corrector
 //    sout 		= gain*0.25*((float)conf_*yn - (float)bb_*ynm1_)*bbinv_;
@@ -248,6 +263,76 @@ int32_t GSP_Reverber::Process(int32_t sampl)
     return sout;
 }
 
+int32_t GSP_Reverber::Tail(int32_t sampl)
+{
+    /*
+    To compute the Reverber tail, after the effect is switched off with
+	spillover. The delay lines run with no input. The tail stops (tail = 0)
+	when its peak stays below GSP_TAIL_LEVEL along the longest delay line.
+		sampl:
+			Input sample (by-passed)
+		Tail
+			Input sample plus tail
+   */
+
+    int32_t 	sout;
+
+	sout 	= Process(0);
+
+	if (sout > tail_peak_) tail_peak_ 	= sout;
+	if (-sout > tail_peak_) tail_peak_ 	= -sout;
+	tail_count_++;
+	if (tail_count_ >= Mi_0_)
+	{
+		if (tail_peak_ < GSP_TAIL_LEVEL) tail 	= 0;
+		tail_peak_ 	= 0;
+		tail_count_ = 0;
+	}
+
+	sout 	+= sampl;
+	if (sout > ADC_MAXVAL)	sout = ADC_MAXVAL;
+	if (sout < ADC_MINVAL)	sout = ADC_MINVAL;
+
+    return sout;
+}
+
+void GSP_Reverber::SetSpread(float width)
+{
+	/*
+    To set the stereo width of the Reverber effect.
+		width
+			0 (mono reverber) to 1 (the side is as loud as the mid)
+	*/
+
+	spread 		= fmaxf(fminf(width, 1.), 0.);
+
+	return;
+}
+
+void GSP_Reverber::ProcessStereo(int32_t *mid, int32_t *side)
+{
+    /*
+    To compute the Reverber effect on a stereo signal, in mid/side form. The
+	mid is the regular (mono) output, the side comes from the same delay 
+	lines with alternate signs, uncorrelated with the mid. The input side
+	is not reverberated.
+		mid, side:
+			Input and processed mid (L+R)/2 and side (L-R)/2 samples
+   */
+
+    int32_t 	sout;
+
+	*mid 	= Process(*mid);
+
+    sout 	= spread*gain*((float)conf_*yd_ - (float)bb_*ydm1_)*bbinv_;
+	if (sout > ADC_MAXVAL)	sout = ADC_MAXVAL;
+	if (sout < ADC_MINVAL)	sout = ADC_MINVAL;
+	ydm1_ 	= yd_;
+	*side 	= sout;
+
+	return;
+}
+
 void GSP_Reverber::Printout(uint8_t out_list, int32_t chn_pos, char *printout)
 {
 
@@ -256,16 +341,17 @@ void GSP_Reverber::Printout(uint8_t out_list, int32_t chn_pos, char *printout)
         sprintf(printout, 
         "->RVB (%ld): OFF(0)|ON(1) %d "
         "| Reverber Time (0-20000)(ms): %-.1f "
-        "| Gain (0-1): %-.3f\n", 
+        "| Gain (0-1): %-.3f "
+        "| Spillover (0-1): %d\n", 
         chn_pos, state, reverber_time,
-        gain);
+        gain, spillover);
     }
     if (out_list == 1)
     {
         sprintf(printout, 
-        "->RVB (%ld) %d %-.1f %-.3f\n", 
+        "->RVB (%ld) %d %-.1f %-.3f %d\n", 
         chn_pos, state, reverber_time,
-        gain);
+        gain, spillover);
     }
 	
 	return;
@@ -277,6 +363,7 @@ void GSP_Reverber::GetParams(float fn[])
 	fn[0]   = state;
 	fn[1]   = reverber_time;
 	fn[2]   = gain;
+	fn[3]   = spillover;
 	
 	return;
 }
@@ -284,9 +371,11 @@ void GSP_Reverber::GetParams(float fn[])
 void GSP_Reverber::SetParams(float fn[])
 {
 
+	spillover 	= (fn[3] > 0.5);
 	Switch(fn[0]);
-	SetReverberTimeMS(fn[1]);
-	SetGain(fn[2]);
+	// the buffers are cleared only if the reverber changes, to keep the tail
+	if (fn[1] != reverber_time) SetReverberTimeMS(fn[1]);
+	if (fn[2] != gain) SetGain(fn[2]);
 
 	return;
 }
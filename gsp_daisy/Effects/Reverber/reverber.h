@@ -16,6 +16,9 @@ class GSP_Reverber
 		void 		Switch(uint8_t mode);
 		void 		ComputeParameters();
 		int32_t 	Process(int32_t sampl);
+		int32_t 	Tail(int32_t sampl);
+		void 		SetSpread(float width);
+		void 		ProcessStereo(int32_t *mid, int32_t *side);
 		void		Printout(uint8_t out_list, int32_t chn_pos, char *printout);
 		void 		GetParams(float param[]);
 		void 		SetParams(float param[]);
@@ -24,11 +27,15 @@ class GSP_Reverber
 		uint8_t   	state;
 		float  		reverber_time;    
 		float     	gain;
-		uint8_t 	number_params = 3;
+		uint8_t 	spillover; 		// tail rings after switched off
+		uint8_t 	tail; 			// tail ringing
+		float 		spread; 		// stereo width (0 to 1)
+		uint8_t 	number_params = 4;
 
 	private:
 		int32_t   	rim1_0_, rim1_1_, rim1_2_, rim1_3_;
 		int32_t   	ynm1_;
+		int32_t   	yd_, ydm1_; 	// decorrelated (side) output
 		uint32_t  	n_;
 		int32_t   	bb_;
 		int32_t   	pip_0_, pip_1_, pip_2_, pip_3_;
@@ -42,6 +49,8 @@ class GSP_Reverber
 		int16_t 	*ptr_buffer_0, *ptr_buffer_1, *ptr_buffer_2, *ptr_buffer_3;
 		uint32_t 	buffer_size_;
 		uint32_t 	delay_pointer_;
+		int32_t 	tail_peak_;
+		uint32_t 	tail_count_;
 };
 
 #endif 	// GPS_REVERBER 	Reverber
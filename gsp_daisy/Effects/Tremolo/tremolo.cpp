@@ -17,6 +17,7 @@ void GSP_Tremolo::Init(uint32_t sampling_rate)
 	
 	lfo.Init(sample_rate);
 	SetGain(1.);
+	SetSpread(0.);
 	Switch(GSP_OFF);
 
 	return;
@@ -64,6 +65,40 @@ int32_t GSP_Tremolo::Process(int32_t sampl)
 	return ((int32_t)(sampl * gain * lfo.GetValue())) >> 16;
 }
 
+void GSP_Tremolo::SetSpread(float spread_deg)
+{
+	/*
+    To set the stereo spread of the Tremolo effect. With 180 degrees the
+	signal pans from left to right (auto-pan).
+		spread_deg
+			phase offset of the right channel LFO (0 to 180 degrees)
+	*/
+
+	spread 		= fmaxf(fminf(spread_deg, 180), 0);
+	offset_ 	= spread*512./360.;
+
+	return;
+}
+
+void GSP_Tremolo::ProcessStereo(int32_t *mid, int32_t *side)
+{
+	/*
+    To compute the Tremolo effect on a stereo signal, in mid/side form.
+		mid, side:
+			Input and processed mid (L+R)/2 and side (L-R)/2 samples
+	*/
+
+	int32_t 	left, right;
+
+	left 	= ((int32_t)((*mid + *side) * gain * lfo.GetValue())) >> 16;
+	right 	= ((int32_t)((*mid - *side) * gain * lfo.GetOffsetValue(offset_))) >> 16;
+
+	*mid 	= (left + right)/2;
+	*side 	= (left - right)/2;
+
+	return;
+}
+
 void GSP_Tremolo::Printout(uint8_t out_list, int32_t chn_pos, char *printout)
 {
 
@@ -115,3 +150,22 @@ void GSP_Tremolo::SetParams(float fn[])
 	return;
 }
 
+int8_t GSP_Tremolo::SetParam(uint8_t idx, float value)
+{
+	/*
+    To change a single smoothable parameter (see smooth_params) at the 
+	sampling rate, for parameter ramps.
+		idx
+			parameter index, as in GetParams and SetParams
+		value
+			new value
+	Returns 0, or -1 if the parameter isn't smoothable.
+	*/
+
+	if (((smooth_params >> idx) & 1) == 0) return -1;
+
+	SetGain(value);
+
+	return 0;
+}
+
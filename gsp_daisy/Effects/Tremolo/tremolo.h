@@ -15,17 +15,23 @@ class GSP_Tremolo
 		void 		Switch(uint8_t mode);
 		void 		SetGain(float output_gain);
 		int32_t 	Process(int32_t sampl);
+		void 		SetSpread(float spread_deg);
+		void 		ProcessStereo(int32_t *mid, int32_t *side);
 		void		Printout(uint8_t out_list, int32_t chn_pos, char *printout);
 		void 		GetParams(float param[]);
 		void 		SetParams(float param[]);
+		int8_t 		SetParam(uint8_t idx, float value);
 		
 		uint32_t 	sample_rate;	// sampling rate
 		uint8_t   	state;
 		float     	gain;
+		float 		spread; 		// right channel LFO phase offset (degrees)
 		uint8_t 	number_params = 5;
+		uint8_t 	smooth_params = (1 << 4); 	// parameters with ramps (bit mask)
 		LowFreqOsc  lfo;
 
 	private:
+		float 		offset_; 		// spread in LFO table steps
 
 };
 
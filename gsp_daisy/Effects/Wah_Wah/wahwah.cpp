@@ -93,7 +93,7 @@ int32_t GSP_WahWah::Process(int32_t sampl)
 			Processed output
 	*/
  
-    static float e0, s0, c, aa0, aa1, aa2;
+    float e0, s0, c, aa0, aa1, aa2;
     
     e0 		= sampl;
     c 		= c0_ + lfo.GetValue()*c1_;
@@ -158,5 +158,24 @@ void GSP_WahWah::SetParams(float fn[])
 	return;
 }
 
+int8_t GSP_WahWah::SetParam(uint8_t idx, float value)
+{
+	/*
+    To change a single smoothable parameter (see smooth_params) at the 
+	sampling rate, for parameter ramps.
+		idx
+			parameter index, as in GetParams and SetParams
+		value
+			new value
+	Returns 0, or -1 if the parameter isn't smoothable.
+	*/
+
+	if (((smooth_params >> idx) & 1) == 0) return -1;
+
+	SetGain(value);
+
+	return 0;
+}
+
 
 
@@ -18,11 +18,13 @@ class GSP_WahWah
 		void		Printout(uint8_t out_list, int32_t chn_pos, char *printout);
 		void 		GetParams(float param[]);
 		void 		SetParams(float param[]);
+		int8_t 		SetParam(uint8_t idx, float value);
 
 		uint32_t 	sample_rate;	// sampling rate
 		float		gain;
 		uint8_t 	state;
 		uint8_t 	number_params = 5;
+		uint8_t 	smooth_params = (1 << 4); 	// parameters with ramps (bit mask)
 		LowFreqOsc  lfo;
 
 	private:
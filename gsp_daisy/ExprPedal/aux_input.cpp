@@ -0,0 +1,196 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "guitar_dsp.h"
+#include "aux_input.h"
+
+// *****************************************************************************
+
+void GSP_AuxInput::Init(uint32_t sampling_rate)
+{
+	/*
+    Initiate the second input (right channel of the ADC).
+		sampling_rate
+			ADC sampling rate (Hz)
+	*/
+
+	sample_rate 	= sampling_rate;
+	route 			= 0;
+	key 			= 0;
+	acc_ 			= 0;
+	count_ 			= 0;
+	target_ 		= 0;
+	cv_ 			= 0;
+	cv 				= 0;
+
+	SetDecimation(16);
+	SetSmoothing(10.);
+	SetMode(AUX_OFF);
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_AuxInput::SetMode(uint8_t aux_mode)
+{
+	/*
+    To set how the second input is used.
+		aux_mode
+			AUX_OFF, AUX_SIDECHAIN (key signal of the routed compressor and 
+			noise gate) or AUX_CV (control voltage of the routed LFOs)
+	*/
+
+	if (aux_mode >= AUX_MODES) aux_mode 	= AUX_OFF;
+	mode 	= aux_mode;
+	key 	= 0;
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_AuxInput::SetDecimation(uint32_t dec)
+{
+	/*
+    To set the number of input samples averaged in each CV update.
+		dec
+			decimation factor (1 to AUX_MAX_DECIMATION)
+	*/
+
+	if (dec < 1) dec 	= 1;
+	if (dec > AUX_MAX_DECIMATION) dec 	= AUX_MAX_DECIMATION;
+	decimation 	= dec;
+	acc_ 		= 0;
+	count_ 		= 0;
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_AuxInput::SetSmoothing(float smt_ms)
+{
+	/*
+    To set the time constant of the CV smoothing filter, which also 
+	interpolates the decimated values at the sampling rate.
+		smt_ms
+			time constant in milliseconds (1 to 200)
+	*/
+
+	smoothing_ms 	= fmaxf(fminf(smt_ms, 200.), 1.);
+	alfa_ 			= 1. - expf(-1000./smoothing_ms/sample_rate);
+
+	return;
+}
+
+// *****************************************************************************
+
+int32_t GSP_AuxInput::Route(int32_t effect, uint8_t on)
+{
+	/*
+    To drive an effect by the second input. Compressor and noise gate use it
+	as key signal (side-chain mode); phaser, wahwah, chorus, vibrato, 
+	tremolo and volume use it in their LFO_EXTERNAL profile (CV mode).
+		effect
+			effect number (see enum gsp_effects)
+		on
+			1 to route, 0 to remove
+	Returns 0 if succeeded or -1 if the effect can't be driven.
+	*/
+
+	if (effect != GSP_CMP && effect != GSP_NGT && effect != GSP_PHR 
+		&& effect != GSP_WAH && effect != GSP_CHS && effect != GSP_VBT 
+		&& effect != GSP_TML && effect != GSP_VOL && effect != GSP_CMP2
+		&& effect != GSP_PHR2 && effect != GSP_WAH2) return -1;
+
+	if (on) route 	|= 1UL << effect;
+	else route 		&= ~(1UL << effect);
+
+	return 0;
+}
+
+// *****************************************************************************
+
+uint8_t GSP_AuxInput::Routed(int32_t effect)
+{
+	/*
+    Returns 1 if the effect is driven by the second input.
+	*/
+
+	return (route >> effect) & 1;
+}
+
+// *****************************************************************************
+
+void GSP_AuxInput::Process(float input)
+{
+	/*
+    To process a sample of the second input. Shall be called once per 
+	sample, before the chain.
+		input
+			second input sample (-1 to 1)
+	*/
+
+	switch (mode)
+	{
+		case AUX_SIDECHAIN:
+			key 	= ADC_HALFRES*input;
+			break;
+		case AUX_CV:
+			acc_ 	+= input;
+			count_++;
+			if (count_ >= decimation)
+			{
+				// mean of the decimation window, scaled to 0 - 65535
+				target_ 	= (acc_/decimation + 1.)*ADC_HALFRES;
+				if (target_ > ADC_RES - 1) target_ 	= ADC_RES - 1;
+				if (target_ < 0) target_ 	= 0;
+				acc_ 	= 0;
+				count_ 	= 0;
+			}
+			cv_ 	+= alfa_*(target_ - cv_);
+			cv 		= (uint32_t)cv_;
+			break;
+		default:
+			break;
+	}
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_AuxInput::Printout(uint8_t out_list, GSP_SignalChain *chain, char *printout)
+{
+	int32_t 	i;
+	char 		pname[8];
+
+    if (out_list == 0)
+    {
+        sprintf(printout, 
+        "->AUX: Off(0)|Side-chain(1)|CV(2) %d "
+        "| Decimation (1-64): %lu "
+        "| Smoothing (1-200)(ms): %-.1f "
+        "| CV (%%): %-.1f | Routes:", 
+        mode, decimation, smoothing_ms, cv*100./ADC_RES);
+    }
+    if (out_list == 1)
+    {
+        sprintf(printout, 
+        "->AUX %d %lu %-.1f %-.1f", 
+        mode, decimation, smoothing_ms, cv*100./ADC_RES);
+    }
+
+	for (i = 0; i < MAX_EFFECT_NUMBER; i++)
+	{
+		if (Routed(i) == 0) continue;
+		chain->Name(i, pname);
+		strcat(printout, " ");
+		strcat(printout, pname);
+	}
+	strcat(printout, "\n");
+
+	return;
+}
@@ -0,0 +1,47 @@
+#ifndef GSP_AUX_INPUT_H
+#define GSP_AUX_INPUT_H
+
+#include <stdint.h>
+#include "gsp_chain.h"
+
+#define AUX_MAX_DECIMATION 	64
+
+enum aux_modes
+{
+	AUX_OFF 		= 0, 		// second input not used
+	AUX_SIDECHAIN 	= 1, 		// key signal for compressor and noise gate
+	AUX_CV 			= 2, 		// control voltage for LFO_EXTERNAL profiles
+	AUX_MODES,
+};
+
+class GSP_AuxInput
+{
+	public:
+		GSP_AuxInput() {}
+		~GSP_AuxInput() {}
+
+		void 		Init(uint32_t sampling_rate);
+		void 		SetMode(uint8_t aux_mode);
+		void 		SetDecimation(uint32_t dec);
+		void 		SetSmoothing(float smt_ms);
+		int32_t 	Route(int32_t effect, uint8_t on);
+		uint8_t 	Routed(int32_t effect);
+		void 		Process(float input);
+		void		Printout(uint8_t out_list, GSP_SignalChain *chain, char *printout);
+
+		uint32_t 	sample_rate;	// sampling rate
+		uint8_t 	mode;
+		uint32_t 	decimation; 	// CV samples averaged per update
+		float 		smoothing_ms; 	// CV smoothing time constant
+		uint32_t 	route; 			// effects driven by the input (bit mask)
+		int32_t 	key; 			// side-chain sample
+		uint32_t 	cv; 			// control voltage (0 to 65535), updated every sample
+
+	private:
+		float 		acc_; 			// decimation accumulator
+		uint32_t 	count_;
+		float 		target_, cv_; 	// decimated and smoothed CV
+		float 		alfa_;
+};
+
+#endif 	// GSP_AUX_INPUT_H
@@ -6,13 +6,28 @@
 
 // Guitar Sound Processing
 // ****************************************************************************
+#include <ctype.h>
+
 #include "daisy_seed.h"
 #include "guitar_dsp.h"
+#include "uart_tx.h"
+#include "baud_link.h"
+#include "presets.h"
+#include "crossfade.h"
+#include "aux_input.h"
+#include "xrun_monitor.h"
+#include "effect_profile.h"
+#include "ramps.h"
+#include "pitch_detector.h"
 
 using namespace daisy;
 
 #define   BUFFER_SIZE   262144  
 #define   REV_BUFSIZE   8192
+#define   LPR_SIZE      4194304         // looper: 87 s at 48 kHz
+#define   UART_TX_SIZE  2048
+#define   UART_WAIT_MS  250             // replies wait for room (2 KB drain at 115200 bd)
+#define   AUDIO_MAX_BLOCK   64
 
 // ****************************************************************************
 static    DaisySeed   hw;
@@ -23,6 +38,13 @@ static    DaisySeed   hw;
 // Delay and Echo memory
 int16_t     DSY_SDRAM_BSS adc_buffer[BUFFER_SIZE];   // chorus, delay
 int16_t     DSY_SDRAM_BSS rvb_buffer[REV_BUFSIZE];   // reverber
+int16_t     DSY_SDRAM_BSS stereo_buffer[BUFFER_SIZE];  // ping-pong delay, right line
+int16_t     DSY_SDRAM_BSS dfb_tail[BUFFER_SIZE];    // feedback delay, spillover line
+int16_t     DSY_SDRAM_BSS efb_tail[BUFFER_SIZE];    // feedback echo, spillover line
+float       DSY_SDRAM_BSS dff_comb[BUFFER_SIZE];    // feedforward delay, comb line
+float       DSY_SDRAM_BSS eff_comb[BUFFER_SIZE];    // feedforward echo, comb line
+int16_t     DSY_SDRAM_BSS lpr_loop[LPR_SIZE];       // looper, older layers
+int16_t     DSY_SDRAM_BSS lpr_layer[LPR_SIZE];      // looper, last layer
 uint32_t    buffer_pointer;
 
 //  Time control
@@ -30,12 +52,17 @@ float       delt_ms = 0.f, delt_time = 1000.f, time_ms = 0;
 uint32_t    tick, tick_0;
 float       duty;
 uint32_t    t0, tend = 0;
+uint32_t    oct_ticks = 0;      // octave processing time (cycle report)
+uint32_t    oct_timed = 0;      // block size while the octave isn't timed yet
+uint8_t     prf_timed = 0;      // effects timed (first sample of the block)
 
 int32_t     smp_max = 0, smp_min = 0;
 
 //  Audio
 size_t      num_channels;
 uint32_t    samplerate;
+uint32_t    blocksize;
+uint8_t     srt_report = 0, srt_source;     // duty report after an audio change
 
 // Output flags
 volatile uint8_t  poutFlag = 0, verbose_flag = 0;
@@ -61,6 +88,11 @@ uint8_t             uart_cs, uart_comm = 0;
 uint8_t             *u_st;
 uint8_t             uart_com[4] = {123, 10, 13, 0}; // {'{', '\r', '\n', '\0'}} 
 
+// UART transmit queue, drained by DMA
+uint8_t             DMA_BUFFER_MEM_SECTION uart_tx_buffer[UART_TX_SIZE];
+GSP_UartTx          uart_tx;
+GSP_BaudLink        baud_link;
+
 // Potentiometers
 char                nb_pot = 0;
 uint8_t             send_pot_data;
@@ -69,6 +101,14 @@ uint32_t            pot_effect, pot_fr = 0;
 uint8_t             pot_start[]     = "}S\n";
 uint8_t             pot_clear[]     = "}C\n";
 
+// Binary protocol
+uint8_t             bin_announce[]  = "}B1\n";    // binary protocol version 1 available
+uint8_t             bin_reply[4];
+uint32_t            bin_rx_ms = 0;                // time of the last byte of a binary frame
+
+// Presets, applied while the chain is held in by-pass
+volatile uint8_t    preset_hold = 0;
+
 //uint8_t             u_presult[64], icon;
 //char                presult[64];
 
@@ -81,27 +121,106 @@ union     TwoBytes
   };
 } pot;
 
-// Effects:
-GSP_Compressor    cps;
-GSP_Overdrive     ovd;
-GSP_Phaser        phr;
-GSP_WahWah        wah;
-GSP_Detune        dtn;
-GSP_PitchShifter  sft;
-GSP_Octave        oct;
-GSP_Equalizer     eqz;
+// Effects with a single instance (spillover, shared delay lines)
 GSP_Reverber      rvb;
 GSP_DelayFB       dfb(DELAY_FB), efb(ECHO_FB);
 GSP_DelayFF       dff(DELAY_FF), eff(ECHO_FF);
-GSP_Chorus        chs(CHORUS);
-GSP_Chorus        vbt(VIBRATO);
-GSP_Tremolo       tml, vol;
-GSP_Limiter       lmt;
-GSP_NoiseGate     ngt;
+GSP_Looper        lpr;
 
 GSP_SignalChain   chain;
 GSP_Pots          expot;
 LowFreqOsc        lffg;
+GSP_BinaryProtocol  binp;
+GSP_Presets         presets;
+GSP_AuxInput        aux;                // second input: side-chain or CV
+GSP_XrunMonitor     xrun;               // audio callback deadline
+GSP_EffectProfile   prf;                // cycles of each effect
+GSP_Ramps           ramps;              // parameter ramps
+GSP_PitchDetect     tun;                // tuner and pitch CV
+GSP_LevelDetector   lvd;                // shared envelope detectors
+
+// Effect instances used to process a chain
+struct GSP_Rack
+{
+    GSP_Compressor      *cps;
+    GSP_Overdrive       *ovd;
+    GSP_Phaser          *phr;
+    GSP_WahWah          *wah;
+    GSP_Detune          *dtn;
+    GSP_PitchShifter    *sft;
+    GSP_Octave          *oct;
+    GSP_Equalizer       *eqz;
+    GSP_Reverber        *rvb;
+    GSP_DelayFB         *dfb, *efb;
+    GSP_DelayFF         *dff, *eff;
+    GSP_Chorus          *chs, *vbt;
+    GSP_Tremolo         *tml, *vol;
+    GSP_Limiter         *lmt;
+    GSP_NoiseGate       *ngt;
+    GSP_Looper          *lpr;
+    GSP_Multiband       *mbc;
+    GSP_Compressor      *cps2;
+    GSP_Overdrive       *ovd2;
+    GSP_Phaser          *phr2;
+    GSP_WahWah          *wah2;
+    GSP_Equalizer       *eqz2;
+};
+
+// Scene switch: two instances of the other effects, in two racks. The live
+// rack runs the chain; at the start of a switch it's copied to the other 
+// one, and the racks are swapped: the current instances keep running the 
+// old scene, the copies take the new one. Delays, reverber and looper have 
+// a single instance (spillover).
+GSP_Compressor    cps_a, cps_b;
+GSP_Overdrive     ovd_a, ovd_b;
+GSP_Phaser        phr_a, phr_b;
+GSP_WahWah        wah_a, wah_b;
+GSP_Detune        dtn_a, dtn_b;
+GSP_PitchShifter  sft_a, sft_b;
+GSP_Octave        oct_a, oct_b;
+GSP_Equalizer     eqz_a, eqz_b;
+GSP_Chorus        chs_a(CHORUS), chs_b(CHORUS);
+GSP_Chorus        vbt_a(VIBRATO), vbt_b(VIBRATO);
+GSP_Tremolo       tml_a, tml_b, vol_a, vol_b;
+GSP_Limiter       lmt_a, lmt_b;
+GSP_NoiseGate     ngt_a, ngt_b;
+GSP_Multiband     mbc_a, mbc_b;
+
+// Second instances (cmp#2, ovd#2, phr#2, wah#2 and eqz#2)
+GSP_Compressor    cps2_a, cps2_b;
+GSP_Overdrive     ovd2_a, ovd2_b;
+GSP_Phaser        phr2_a, phr2_b;
+GSP_WahWah        wah2_a, wah2_b;
+GSP_Equalizer     eqz2_a, eqz2_b;
+
+GSP_Rack          rack_a    = {&cps_a, &ovd_a, &phr_a, &wah_a, &dtn_a, &sft_a, &oct_a, 
+                    &eqz_a, &rvb, &dfb, &efb, &dff, &eff, &chs_a, &vbt_a, &tml_a, &vol_a, 
+                    &lmt_a, &ngt_a, &lpr, &mbc_a, &cps2_a, &ovd2_a, &phr2_a, &wah2_a, &eqz2_a};
+GSP_Rack          rack_b    = {&cps_b, &ovd_b, &phr_b, &wah_b, &dtn_b, &sft_b, &oct_b, 
+                    &eqz_b, &rvb, &dfb, &efb, &dff, &eff, &chs_b, &vbt_b, &tml_b, &vol_b, 
+                    &lmt_b, &ngt_b, &lpr, &mbc_b, &cps2_b, &ovd2_b, &phr2_b, &wah2_b, &eqz2_b};
+GSP_Rack          *live_rack    = &rack_a;  // running the chain
+GSP_Rack          *old_rack     = &rack_b;  // old scene during a switch, else spare
+
+// Live instances, as used by the commands (see RackSelect)
+GSP_Compressor    *cps = &cps_a, *cps2 = &cps2_a;
+GSP_Overdrive     *ovd = &ovd_a, *ovd2 = &ovd2_a;
+GSP_Phaser        *phr = &phr_a, *phr2 = &phr2_a;
+GSP_WahWah        *wah = &wah_a, *wah2 = &wah2_a;
+GSP_Detune        *dtn = &dtn_a;
+GSP_PitchShifter  *sft = &sft_a;
+GSP_Octave        *oct = &oct_a;
+GSP_Equalizer     *eqz = &eqz_a, *eqz2 = &eqz2_a;
+GSP_Chorus        *chs = &chs_a, *vbt = &vbt_a;
+GSP_Tremolo       *tml = &tml_a, *vol = &vol_a;
+GSP_Limiter       *lmt = &lmt_a;
+GSP_NoiseGate     *ngt = &ngt_a;
+GSP_Multiband     *mbc = &mbc_a;
+
+GSP_Crossfade     xfd;
+GSP_Snapshot      scene_next;
+uint8_t           xfd_source;
+char              xfd_pout[128];
 
 // ****************************************************************************
 // Prototypes
@@ -113,114 +232,427 @@ int32_t CommandDecoder(char ct[], int32_t *chn_chg,
         int32_t *chn_code, float fl[], int32_t *fl_nb);
 int8_t  PotDecoder(GSP_SignalChain *chain_, char ct[],  
         int32_t* effect_number, int32_t* pot_number);
+int8_t  TapDecoder(GSP_SignalChain *chain_, int32_t* effect_number, int32_t* detector);
 void    ChangeEffectParams(float fl[], float fn[], int32_t nb);
 void    SendPotStruct(GSP_Pots *pots_);
+int32_t EffectParams(int32_t effect, float fn[], uint8_t set);
+int32_t EffectSpread(int32_t effect, float *spread, uint8_t set);
+int8_t  EffectParam(int32_t effect, uint8_t idx, float value);
+uint8_t EffectSmooth(int32_t effect);
+void    InstancePrintout(int32_t effect, int32_t chn_pos, char *printout);
+void    AuxSources();
+void    LevelSources();
+void    EffectsInit();
+int8_t  AudioConfig(uint32_t rate, uint32_t block);
+void    AudioPrintout(uint8_t out_list, char *printout);
+int8_t  BinaryUpdate();
+void    PresetCapture(GSP_Snapshot *snapshot);
+void    PresetApply(GSP_Snapshot *snapshot);
+int8_t  SceneSwitch(GSP_Snapshot *snapshot, uint8_t source);
+void    SceneFinish();
+int8_t  ChainEdit(int32_t effect, int32_t ceff, int32_t pos, uint8_t source);
 
 // ****************************************************************************
 // Code
 
+static int32_t ProcessEffect(int32_t effect, int32_t sampl, GSP_Rack *r, uint32_t bp)
+{
+    /*
+    To process a sample through an effect.
+    effect
+        Effect number (see enum gsp_effects)
+    sampl
+        Input sample
+    r
+        Effect instances (live rack or the old scene rack)
+    bp
+        Current position in adc_buffer
+    */
+
+    uint32_t    t;
+
+    switch (effect)
+    {
+        case GSP_CMP:
+            if (r->cps->state == GSP_ON) 
+            {
+                if (aux.mode == AUX_SIDECHAIN && aux.Routed(GSP_CMP)) 
+                    sampl   = r->cps->Process(sampl, aux.key);
+                else sampl  = r->cps->Process(sampl);
+            }
+            break;
+        case GSP_OVD:
+            if (r->ovd->state == GSP_ON) sampl  = r->ovd->Process(sampl);
+            break;
+        case GSP_PHR:
+            if (r->phr->state == GSP_ON) sampl  = r->phr->Process(sampl);
+            break;
+        case GSP_OCT:
+            if (r->oct->state == GSP_ON) 
+            {
+                // the polyphonic engines are heavy: their load is reported,
+                // from one timed sample per block of the live chain
+                if (oct_timed && r == live_rack && r->oct->engine != OCT_SPLICE)
+                {
+                    t           = System::GetTick();
+                    sampl       = r->oct->Process(sampl, bp);
+                    oct_ticks   += oct_timed*(System::GetTick() - t);
+                    oct_timed   = 0;
+                }
+                else sampl  = r->oct->Process(sampl, bp);
+            }
+            break;
+        case GSP_SFT:
+            if (r->sft->state == GSP_ON) sampl  = r->sft->Process(sampl, bp);
+            break;
+        case GSP_DTN:
+            if (r->dtn->state == GSP_ON) sampl  = r->dtn->Process(sampl, bp);
+            break;
+        case GSP_WAH:
+            if (r->wah->state == GSP_ON) sampl  = r->wah->Process(sampl);
+            break;
+        case GSP_EQZ:
+            if (r->eqz->state == GSP_ON) sampl  = r->eqz->Process(sampl);
+            break;
+        case GSP_CHS:
+            if (r->chs->state == GSP_ON) sampl  = r->chs->Process(sampl, bp);
+            break;
+        case GSP_VBT:
+            if (r->vbt->state == GSP_ON) sampl  = r->vbt->Process(sampl, bp);
+            break;
+        case GSP_RVB:
+            if (r->rvb->state == GSP_ON) sampl  = r->rvb->Process(sampl);
+            else if (r->rvb->tail) sampl    = r->rvb->Tail(sampl);
+            break;
+        case GSP_DFB:
+            if (r->dfb->state == GSP_ON) 
+            {
+                sampl  = r->dfb->Process(sampl, bp);
+                adc_buffer[bp] = sampl;
+            }
+            else if (r->dfb->tail) sampl    = r->dfb->Tail(sampl, bp);
+            break;
+        case GSP_EFB:
+            if (r->efb->state == GSP_ON) 
+            {
+                sampl  = r->efb->Process(sampl, bp);
+                adc_buffer[bp] = sampl;
+            }
+            else if (r->efb->tail) sampl    = r->efb->Tail(sampl, bp);
+            break;
+        case GSP_DFF:
+            if (r->dff->state == GSP_ON) sampl  = r->dff->Process(sampl, bp);
+            else if (r->dff->tail) sampl    = r->dff->Tail(sampl, bp);
+            break;
+        case GSP_EFF:
+            if (r->eff->state == GSP_ON) sampl  = r->eff->Process(sampl, bp);
+            else if (r->eff->tail) sampl    = r->eff->Tail(sampl, bp);
+            break;
+        case GSP_TML:
+            if (r->tml->state == GSP_ON) sampl  = r->tml->Process(sampl);
+            break;
+        case GSP_LIM:
+            if (r->lmt->state == GSP_ON) sampl  = r->lmt->Process(sampl);
+            break;
+        case GSP_VOL:
+            if (r->vol->state == GSP_ON) sampl  = r->vol->Process(sampl);
+            break;
+        case GSP_NGT:
+            if (r->ngt->state == GSP_ON) 
+            {
+                if (aux.mode == AUX_SIDECHAIN && aux.Routed(GSP_NGT)) 
+                    sampl   = r->ngt->Process(sampl, aux.key);
+                else sampl  = r->ngt->Process(sampl);
+            }
+            break;
+        case GSP_LPR:
+            if (r->lpr->state == GSP_ON) sampl  = r->lpr->Process(sampl);
+            break;
+        case GSP_MBC:
+            if (r->mbc->state == GSP_ON) sampl  = r->mbc->Process(sampl);
+            break;
+        case GSP_CMP2:
+            if (r->cps2->state == GSP_ON) 
+            {
+                if (aux.mode == AUX_SIDECHAIN && aux.Routed(GSP_CMP2)) 
+                    sampl   = r->cps2->Process(sampl, aux.key);
+                else sampl  = r->cps2->Process(sampl);
+            }
+            break;
+        case GSP_OVD2:
+            if (r->ovd2->state == GSP_ON) sampl     = r->ovd2->Process(sampl);
+            break;
+        case GSP_PHR2:
+            if (r->phr2->state == GSP_ON) sampl     = r->phr2->Process(sampl);
+            break;
+        case GSP_WAH2:
+            if (r->wah2->state == GSP_ON) sampl     = r->wah2->Process(sampl);
+            break;
+        case GSP_EQZ2:
+            if (r->eqz2->state == GSP_ON) sampl     = r->eqz2->Process(sampl);
+            break;
+        default:
+            break;
+    }
+
+    return sampl;
+}
+
+// ****************************************************************************
+
+static int32_t ProcessStereoEffect(int32_t effect, int32_t sampl, int32_t *side, 
+        GSP_Rack *r, uint32_t bp)
+{
+    /*
+    To process a stereo sample, in mid/side form, through an effect. The
+    effects without a stereo version process the mid and leave the side 
+    unchanged. The tails are mono.
+    effect
+        Effect number (see enum gsp_effects)
+    sampl, side
+        Mid (L+R)/2 and side (L-R)/2 samples
+    r
+        Effect instances (live rack or the old scene rack)
+    bp
+        Current position in adc_buffer
+    Returns the processed mid.
+    */
+
+    switch (effect)
+    {
+        case GSP_CHS:
+            if (r->chs->state == GSP_ON) r->chs->ProcessStereo(&sampl, side, bp);
+            break;
+        case GSP_VBT:
+            if (r->vbt->state == GSP_ON) r->vbt->ProcessStereo(&sampl, side, bp);
+            break;
+        case GSP_RVB:
+            if (r->rvb->state == GSP_ON) r->rvb->ProcessStereo(&sampl, side);
+            else if (r->rvb->tail) sampl    = r->rvb->Tail(sampl);
+            break;
+        case GSP_DFB:
+            if (r->dfb->state == GSP_ON) r->dfb->ProcessStereo(&sampl, side, bp);
+            else if (r->dfb->tail) sampl    = r->dfb->Tail(sampl, bp);
+            break;
+        case GSP_EFB:
+            if (r->efb->state == GSP_ON) r->efb->ProcessStereo(&sampl, side, bp);
+            else if (r->efb->tail) sampl    = r->efb->Tail(sampl, bp);
+            break;
+        case GSP_DFF:
+            if (r->dff->state == GSP_ON) r->dff->ProcessStereo(&sampl, side, bp);
+            else if (r->dff->tail) sampl    = r->dff->Tail(sampl, bp);
+            break;
+        case GSP_EFF:
+            if (r->eff->state == GSP_ON) r->eff->ProcessStereo(&sampl, side, bp);
+            else if (r->eff->tail) sampl    = r->eff->Tail(sampl, bp);
+            break;
+        case GSP_TML:
+            if (r->tml->state == GSP_ON) r->tml->ProcessStereo(&sampl, side);
+            break;
+        case GSP_VOL:
+            if (r->vol->state == GSP_ON) r->vol->ProcessStereo(&sampl, side);
+            break;
+        default:
+            sampl   = ProcessEffect(effect, sampl, r, bp);
+            break;
+    }
+
+    return sampl;
+}
+
+// ****************************************************************************
+
+static int32_t ProcessChain(int32_t sampl, int32_t *side, const int32_t sgn_chain[], 
+        uint32_t number_effects, const int8_t branch[], const float branch_level[], 
+        int32_t stereo_split, GSP_Rack *r, uint32_t bp)
+{
+    /*
+    To process a sample through a chain of effects. A parallel section 
+    (consecutive effects in branches A or B) splits the signal in two, and
+    mixes both branches at its output. From the stereo split on, the 
+    signal is processed in mid/side form.
+    sampl, side
+        Input sample (mid) and side (0 for a mono input)
+    sgn_chain[], number_effects
+        Effect sequence and number of effects
+    branch[], branch_level[]
+        Branch of each effect and merge levels (see GSP_SignalChain)
+    stereo_split
+        First stereo position in chain (-1: mono)
+    r
+        Effect instances (live rack or the old scene rack)
+    bp
+        Current position in adc_buffer
+    Returns the processed mid; the side is updated. The outputs tapped by
+    the level detectors are captured in the live chain.
+    */
+
+    uint32_t    i, c, skip;
+    int32_t     effect, split[GSP_BRANCHES], side_split[GSP_BRANCHES];
+    uint8_t     timed;
+
+    // the single instances kept by a new scene are run by the old chain 
+    // only until the new one starts (see SceneSwitch)
+    skip    = r == old_rack && !xfd.hold ? xfd.shared : 0;
+
+    // the effects of the live chain are timed on the first sample of a
+    // block, with the processor cycle counter
+    timed   = prf_timed && r == live_rack;
+    c       = 0;
+
+    i   = 0;
+    while (i < number_effects)
+    {
+        effect  = sgn_chain[i];
+        if ((skip >> effect) & 1)
+        {
+            i++;
+            continue;
+        }
+        if (branch[effect] == GSP_MAIN)
+        {
+            if (timed) c    = DWT->CYCCNT;
+            if (stereo_split >= 0 && (int32_t)i >= stereo_split)
+                sampl   = ProcessStereoEffect(effect, sampl, side, r, bp);
+            else sampl  = ProcessEffect(effect, sampl, r, bp);
+            if (timed) prf.Add(effect, DWT->CYCCNT - c);
+            if (((lvd.taps >> (effect + 1)) & 1) && r == live_rack) 
+                lvd.Capture(effect, sampl);
+            i++;
+            continue;
+        }
+
+        // parallel section
+        split[GSP_BRANCH_A]     = sampl;
+        split[GSP_BRANCH_B]     = sampl;
+        side_split[GSP_BRANCH_A]    = *side;
+        side_split[GSP_BRANCH_B]    = *side;
+        while (i < number_effects && branch[sgn_chain[i]] != GSP_MAIN)
+        {
+            effect  = sgn_chain[i];
+            if ((skip >> effect) & 1)
+            {
+                i++;
+                continue;
+            }
+            if (timed) c    = DWT->CYCCNT;
+            if (stereo_split >= 0 && (int32_t)i >= stereo_split)
+                split[branch[effect]]   = ProcessStereoEffect(effect, split[branch[effect]], 
+                        &side_split[branch[effect]], r, bp);
+            else split[branch[effect]]  = ProcessEffect(effect, split[branch[effect]], r, bp);
+            if (timed) prf.Add(effect, DWT->CYCCNT - c);
+            if (((lvd.taps >> (effect + 1)) & 1) && r == live_rack) 
+                lvd.Capture(effect, split[branch[effect]]);
+            i++;
+        }
+        sampl   = branch_level[GSP_BRANCH_A]*split[GSP_BRANCH_A] 
+                + branch_level[GSP_BRANCH_B]*split[GSP_BRANCH_B];
+        *side   = branch_level[GSP_BRANCH_A]*side_split[GSP_BRANCH_A] 
+                + branch_level[GSP_BRANCH_B]*side_split[GSP_BRANCH_B];
+    }
+
+    return sampl;
+}
+
+// ****************************************************************************
+
 static void GuitardspCB(AudioHandle::InterleavingInputBuffer  in,
         AudioHandle::InterleavingOutputBuffer out,
         size_t size)
 {
-    static int32_t  sampl;
-//    static int32_t  level;
-    static uint32_t i;
-    static float    outspl;
+    static int32_t  sampl, old_sampl, side, old_side, left, right;
+    static uint32_t i, k, number_effects;
+    static uint8_t  tune_mute;
     
     t0        = System::GetTick();
-    sampl     = ADC_HALFRES*in[0];
-//    level     = in[1];
+    xrun.Start(t0);
 
-    if (sampl > smp_max) smp_max = sampl;
-    if (sampl < smp_min) smp_min = sampl;
+    // a preset being recalled by-passes the whole chain
+    // the tuner in mute mode by-passes the chain and silences the output
+    tune_mute       = tun.state && tun.mute;
+    number_effects  = preset_hold || tune_mute ? 0 : chain.number_effects;
 
-    adc_buffer[buffer_pointer]  = sampl;
+    oct_timed       = size;
+    prf_timed       = prf.state;
 
-    i   = LevelDetectorProcess(sampl);  // level detector for LFO
-    
-    for (i = 0; i < chain.number_effects; i++)
+    // an instant scene switch cuts to the new chain between two blocks
+    if (xfd.active) xfd.Cut();
+
+    // parameter ramps advance once per block
+    if (ramps.active)
     {
-        switch (chain.sgn_chain[i])
+        for (i = 0; i < RAMP_LANES; i++)
         {
-            case GSP_CMP:
-                if (cps.state == GSP_ON) sampl  = cps.Process(sampl);
-                break;
-            case GSP_OVD:
-                if (ovd.state == GSP_ON) sampl  = ovd.Process(sampl);
-                break;
-            case GSP_PHR:
-                if (phr.state == GSP_ON) sampl  = phr.Process(sampl);
-                break;
-            case GSP_OCT:
-                if (oct.state == GSP_ON) sampl  = oct.Process(sampl, buffer_pointer);
-                break;
-            case GSP_SFT:
-                if (sft.state == GSP_ON) sampl  = sft.Process(sampl, buffer_pointer);
-                break;
-            case GSP_DTN:
-                if (dtn.state == GSP_ON) sampl  = dtn.Process(sampl, buffer_pointer);
-                break;
-            case GSP_WAH:
-                if (wah.state == GSP_ON) sampl  = wah.Process(sampl);
-                break;
-            case GSP_EQZ:
-                if (eqz.state == GSP_ON) sampl  = eqz.Process(sampl);
-                break;
-            case GSP_CHS:
-                if (chs.state == GSP_ON) sampl  = chs.Process(sampl, buffer_pointer);
-                break;
-            case GSP_VBT:
-                if (vbt.state == GSP_ON) sampl  = vbt.Process(sampl, buffer_pointer);
-                break;
-            case GSP_RVB:
-                if (rvb.state == GSP_ON) sampl  = rvb.Process(sampl);
-                break;
-            case GSP_DFB:
-                if (dfb.state == GSP_ON) 
-                {
-                    sampl  = dfb.Process(sampl, buffer_pointer);
-                    adc_buffer[buffer_pointer] = sampl;
-                }
-                break;
-            case GSP_EFB:
-                if (efb.state == GSP_ON) 
-                {
-                    sampl  = efb.Process(sampl, buffer_pointer);
-                    adc_buffer[buffer_pointer] = sampl;
-                }
-                break;
-            case GSP_DFF:
-                if (dff.state == GSP_ON) sampl  = dff.Process(sampl, buffer_pointer);
-                break;
-            case GSP_EFF:
-                if (eff.state == GSP_ON) sampl  = eff.Process(sampl, buffer_pointer);
-                break;
-            case GSP_TML:
-                if (tml.state == GSP_ON) sampl  = tml.Process(sampl);
-                break;
-            case GSP_LIM:
-                if (lmt.state == GSP_ON) sampl  = lmt.Process(sampl);
-                break;
-            case GSP_VOL:
-                if (vol.state == GSP_ON) sampl  = vol.Process(sampl);
-                break;
-            case GSP_NGT:
-                if (ngt.state == GSP_ON) sampl  = ngt.Process(sampl);
-                break;
-            default:
-                break;
+            if ((ramps.active >> i) & 1) 
+                EffectParam(ramps.lane[i].effect, ramps.lane[i].param, ramps.Advance(i, size));
         }
     }
-    
-    outspl    = sampl*ADC_INVHRESF;
-    out[0]    = outspl;
-    out[1]    = outspl;
 
-    buffer_pointer++;
-    if (buffer_pointer == BUFFER_SIZE) buffer_pointer = 0;
+    // interleaved block: in[2*k] is the guitar, in[2*k + 1] the second input
+    for (k = 0; k < size; k++)
+    {
+        sampl     = ADC_HALFRES*in[2*k];
+        aux.Process(in[2*k + 1]);
+
+        if (sampl > smp_max) smp_max = sampl;
+        if (sampl < smp_min) smp_min = sampl;
+
+        adc_buffer[buffer_pointer]  = sampl;
+
+        if (lvd.taps & 1) lvd.Capture(LVD_INPUT, sampl);    // level detectors
+        tun.Process(sampl);                 // pitch detector for tuner and LFO
+
+        side    = 0;
+        if (xfd.active)
+        {
+            // scene switch: old scene fades out while the new one fades in
+            old_side    = 0;
+            old_sampl   = ProcessChain(sampl, &old_side, xfd.sgn_chain, xfd.number_effects, 
+                    xfd.branch, xfd.branch_level, xfd.stereo_split, old_rack, buffer_pointer);
+            if (xfd.hold) 
+            {
+                sampl   = old_sampl;
+                side    = old_side;
+            }
+            else
+            {
+                sampl   = ProcessChain(sampl, &side, chain.sgn_chain, number_effects, 
+                        chain.branch, chain.branch_level, chain.stereo_split, 
+                        live_rack, buffer_pointer);
+                xfd.Mix(old_sampl, old_side, &sampl, &side);
+            }
+        }
+        else sampl  = ProcessChain(sampl, &side, chain.sgn_chain, number_effects, 
+                chain.branch, chain.branch_level, chain.stereo_split, 
+                live_rack, buffer_pointer);
+        prf_timed   = 0;
+
+        // mid/side to left/right (side = 0 for a mono chain)
+        left    = sampl + side;
+        right   = sampl - side;
+        if (left > ADC_MAXVAL) left = ADC_MAXVAL;
+        if (left < ADC_MINVAL) left = ADC_MINVAL;
+        if (right > ADC_MAXVAL) right = ADC_MAXVAL;
+        if (right < ADC_MINVAL) right = ADC_MINVAL;
+        if (tune_mute)
+        {
+            left    = 0;
+            right   = 0;
+        }
+        out[2*k]        = left*ADC_INVHRESF;
+        out[2*k + 1]    = right*ADC_INVHRESF;
+
+        buffer_pointer++;
+        if (buffer_pointer == BUFFER_SIZE) buffer_pointer = 0;
+    }
+
+    // the level detectors in use run once per block, on the captured samples
+    if (lvd.active) lvd.Process();
     
-    tend  += System::GetTick() - t0;
+    t0    = System::GetTick() - t0;
+    tend  += t0;
+    xfd.Account(t0, size);
+    xrun.Stop(t0);
 
     return;
 }
@@ -250,11 +682,11 @@ int main(void)
     hw.Init(true);  // 480 Mhz
     // hw.Init(false);  // 400 Mhz
  
-    hw.SetAudioBlockSize(1);
+    hw.SetAudioSampleRate(SaiHandle::Config::SampleRate::SAI_48KHZ);
+    hw.SetAudioBlockSize(1);    // changed by the 'srt' command
 
     samplerate      = (uint32_t)(hw.AudioSampleRate() + 0.1f);
-    
-    //hw.SetAudioSampleRate(enum - verificar);
+    blocksize       = hw.AudioBlockSize();
 
     buffer_pointer  = 0;
 
@@ -268,7 +700,7 @@ int main(void)
     // ============================================================================
     // UART Serial
     // baudrates: 4800, 9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600
-    uart_config.baudrate        = 115200;
+    uart_config.baudrate        = BAUD_BASE_RATE;    // raised by the 'bdr' command
     uart_config.periph          = UartHandler::Config::Peripheral::USART_1;
     uart_config.pin_config.rx   = {DSY_GPIOB, 7};  // (USART_1 RX) Daisy pin 15
     uart_config.pin_config.tx   = {DSY_GPIOB, 6};  // (USART_1 TX) Daisy pin 14
@@ -278,6 +710,8 @@ int main(void)
     uart_config.wordlength      = UartHandler::Config::WordLength::BITS_8;
     uart.Init(uart_config);
     uart.DmaReceiveFifo();      // 2026
+    uart_tx.Init(&uart, uart_tx_buffer, UART_TX_SIZE);
+    baud_link.Init(&uart, &uart_config, &uart_tx);
     
     //System::Delay(5000);
 
@@ -285,27 +719,16 @@ int main(void)
     // GSP
     send_pot_data   = false;
     chain.New();
-    
-    LevelDetectorSetSamples(samplerate, 48, 48000);
-    cps.Init(samplerate);
-    ovd.Init(samplerate);
-    phr.Init(samplerate);
-    wah.Init(samplerate);
-    dtn.Init(samplerate, adc_buffer, BUFFER_SIZE);
-    sft.Init(samplerate, adc_buffer, BUFFER_SIZE);
-    oct.Init(samplerate, adc_buffer, BUFFER_SIZE);
-    chs.Init(samplerate, adc_buffer, BUFFER_SIZE);
-    vbt.Init(samplerate, adc_buffer, BUFFER_SIZE);
-    dfb.Init(samplerate, adc_buffer, BUFFER_SIZE);
-    efb.Init(samplerate, adc_buffer, BUFFER_SIZE);
-    dff.Init(samplerate, adc_buffer, BUFFER_SIZE);
-    eff.Init(samplerate, adc_buffer, BUFFER_SIZE);
-    eqz.Init(samplerate);
-    rvb.Init(samplerate, rvb_buffer, REV_BUFSIZE);
-    tml.Init(samplerate);
-    lmt.Init(samplerate);
-    vol.Init(samplerate);
-    ngt.Init(samplerate);
+    binp.Init();
+    presets.Init(&hw.qspi);
+    xfd.Init(samplerate, 200000000);
+    aux.Init(samplerate);
+    xrun.Init(samplerate, blocksize, 200000000);
+    prf.Init(samplerate, System::GetSysClkFreq());
+    ramps.Init(samplerate);
+    tun.Init(samplerate);
+    lvd.Init(samplerate);
+    EffectsInit();
     
     //dsy_audio_set_blocksize(DSY_AUDIO_INTERNAL, 1);   // Just one sample at each callback
     //DAISY.SetAudioBlockSize(1); // Just one sample per audio callback
@@ -314,6 +737,9 @@ int main(void)
     hw.StartAudio(GuitardspCB);
 
     u_st    = reinterpret_cast<uint8_t*>(const_cast<char*>(st));
+
+    // Announce the binary protocol to ESP32 (enabled by the 'bin' command)
+    uart_tx.Send(bin_announce, 4);
  
     while(1) 
     {
@@ -325,6 +751,48 @@ int main(void)
 
 void loop() 
 {
+    int8_t      decoded_bin;
+
+    // Restart the UART transmission, if needed
+    uart_tx.Poll();
+
+    // Baud rate negotiation and UART line errors
+    switch (baud_link.Service())
+    {
+        case BAUD_SWITCHED:
+            uart_comm   = 0;
+            break;
+        case BAUD_FALLBACK:
+            uart_comm   = 0;
+            sprintf(st, "->BDR: Fallback %lu\n", baud_link.baudrate);
+            uart_tx.Send(uart_com, 1, u_st, strlen(st));
+            break;
+    }
+
+    // Binary frame rejected or stalled: NAK it once the line is idle
+    if (uart_comm == 5 && !uart.ReadableFifo() 
+        && System::GetNow() - bin_rx_ms > BINP_IDLE_MS)
+    {
+        binp.Timeout();
+        uart_ready  = 0;
+        uart_comm   = 0;
+        uart_tx.SendWait(NULL, 0, bin_reply, binp.Reply(bin_reply, 0), UART_WAIT_MS);
+    }
+
+    // Scene switch finished: report the processor load of the transition
+    if (xfd.Done())
+    {
+        SceneFinish();
+        xfd.Printout(out_list, xfd_pout);
+        if (!muted && xfd.time_ms > 0 && xfd_source == 0) hw.Print(xfd_pout);
+        if (!muted && xfd.time_ms > 0 && xfd_source == 1) 
+        {
+            uart_tx.Send(uart_com, 1, reinterpret_cast<uint8_t*>(xfd_pout), strlen(xfd_pout));
+        }
+    }
+
+    // The level detectors run only for the effects using them
+    LevelSources();
 
     // ----------------------------------------------------------------------
     //          Print duty time
@@ -337,6 +805,31 @@ void loop()
 
         // Print duty time
         duty        = (float)tend/2.0e6;    // in percent of total time
+        oct->load    = (float)oct_ticks/2.0e6;
+        oct_ticks   = 0;
+
+        // persistent overrun: fall back to the safe preset
+        if (xrun.Second() && !xfd.active && presets.Slot(xrun.safe_preset) != NULL)
+        {
+            SceneSwitch(presets.Slot(xrun.safe_preset), inp_source);
+            sprintf(xfd_pout, "->XRN: Overrun, safe preset %ld recalled\n", xrun.safe_preset);
+            if (!muted && inp_source == 0) hw.Print(xfd_pout);
+            if (!muted && inp_source == 1) 
+            {
+                uart_tx.Send(uart_com, 1, reinterpret_cast<uint8_t*>(xfd_pout), strlen(xfd_pout));
+            }
+        }
+
+        // audio changed: report the duty of the first whole second
+        if (srt_report > 0 && --srt_report == 0)
+        {
+            AudioPrintout(out_list, xfd_pout);
+            if (!muted && srt_source == 0) hw.Print(xfd_pout);
+            if (!muted && srt_source == 1) 
+            {
+                uart_tx.Send(uart_com, 1, reinterpret_cast<uint8_t*>(xfd_pout), strlen(xfd_pout));
+            }
+        }
         if (poutFlag)
         {
             sprintf(st, "%f\r\n", duty);
@@ -345,8 +838,7 @@ void loop()
             {
                 //uart.PollTx(uart_com, 1);
                 //uart.PollTx(u_st, strlen(st));
-                uart.BlockingTransmit(uart_com, 1);
-                uart.BlockingTransmit(u_st, strlen(st));
+                uart_tx.Send(uart_com, 1, u_st, strlen(st));
             }
             // Print the maximum and minimum ADC sampled value
             //hw.PrintLine("Max %ld,  Min %ld", smp_max, smp_min);
@@ -369,7 +861,7 @@ void loop()
         // Send request for potentimeter data
         if (send_pot_data)
         {
-            uart.BlockingTransmit(pot_start, 3);
+            uart_tx.Send(pot_start, 3);
             System::Delay(1);
             ipot = 0;
             send_pot_data   = false;
@@ -398,10 +890,33 @@ void loop()
                 uart_comm   = 2; // pot command
                 uart_ready  = 1;
             }
+            if (uart_cs == BINP_STX && binp.enabled)
+            {
+                uart_comm   = 5; // binary frame
+                uart_ready  = 1;
+                bin_rx_ms   = System::GetNow();
+                binp.Start();
+            }
         }
         else
         {
             //hw.PrintLine("-> Received 1: %c %d", (char)uart_cs, uart_cs);
+            if (uart_comm == 5)
+            {
+                bin_rx_ms       = System::GetNow();
+                decoded_bin     = binp.Push(uart_cs);
+                if (decoded_bin > 0)
+                {
+                    // frame complete: apply the updates and acknowledge
+                    decoded_bin = BinaryUpdate();
+                    uart_ready  = 0;
+                    uart_comm   = 0;
+                    uart_tx.SendWait(NULL, 0, bin_reply, 
+                        binp.Reply(bin_reply, decoded_bin > 0), UART_WAIT_MS);
+                }
+                // rejected frame: its remaining bytes are dropped, not 
+                // scanned as text, until the line is idle (NAK below)
+            }
             if (uart_comm == 1)
             {
                 if (uart_cs == 10 || uart_cs == 13)
@@ -456,12 +971,15 @@ void loop()
                                 pot.low   = pot_data[pot_aux];
                                 pot.high  = pot_data[pot_aux + 1];
                                 pot_effect      = expot.effect_id[ipot];
-                                if (pot_effect == GSP_PHR)  phr.lfo.SetGain((uint32_t)pot.full);
-                                if (pot_effect == GSP_WAH)  wah.lfo.SetGain((uint32_t)pot.full);
-                                if (pot_effect == GSP_CHS)  chs.lfo.SetGain((uint32_t)pot.full);
-                                if (pot_effect == GSP_VBT)  vbt.lfo.SetGain((uint32_t)pot.full);
-                                if (pot_effect == GSP_TML)  tml.lfo.SetGain((uint32_t)pot.full);
-                                if (pot_effect == GSP_VOL)  vol.lfo.SetGain((uint32_t)pot.full);
+                                if (pot_effect < MAX_EFFECT_NUMBER) ramps.Cancel(pot_effect);
+                                if (pot_effect == GSP_PHR)  phr->lfo.SetGain((uint32_t)pot.full);
+                                if (pot_effect == GSP_WAH)  wah->lfo.SetGain((uint32_t)pot.full);
+                                if (pot_effect == GSP_CHS)  chs->lfo.SetGain((uint32_t)pot.full);
+                                if (pot_effect == GSP_VBT)  vbt->lfo.SetGain((uint32_t)pot.full);
+                                if (pot_effect == GSP_TML)  tml->lfo.SetGain((uint32_t)pot.full);
+                                if (pot_effect == GSP_VOL)  vol->lfo.SetGain((uint32_t)pot.full);
+                                if (pot_effect == GSP_PHR2) phr2->lfo.SetGain((uint32_t)pot.full);
+                                if (pot_effect == GSP_WAH2) wah2->lfo.SetGain((uint32_t)pot.full);
                                 //hw.Print(" eff: %ld  value: %d ", pot_effect, pot.full);
                             }
                             ipot  = 0;
@@ -504,15 +1022,14 @@ void _Setcommand(char ct[], uint8_t source)
     // source   Command source: 0=Daisy Seed USB, 1=ESP32 UART
     uint32_t    i;
     int8_t      chainf, decoded, gpot;
-    uint8_t     pot_com[24];
     int32_t     ceff, pos;
     int32_t     effect_n;
     int32_t     pot_id;
     char        cmd[8], pout[250], pname[32], phal, *stc;
     float       fn[8] = {0, 0, 0, 0, 0, 0, 0, 0}, fl[8] = {0, 0, 0, 0, 0, 0, 0, 0};
     int32_t     cdec, fl_nb;
-    uint8_t     *u_ct;
     uint8_t     *u_pout;
+    GSP_SignalChain     fresh;
 
     decoded     = 0;
     chainf      = 0;
@@ -521,7 +1038,6 @@ void _Setcommand(char ct[], uint8_t source)
     if (source == 1)
     {
         //https://stackoverflow.com/questions/51640225/how-to-cast-const-uint8-t-to-char
-        u_ct    = reinterpret_cast<uint8_t*>(const_cast<char*>(ct));
         u_pout  = reinterpret_cast<uint8_t*>(const_cast<char*>(pout));
     }
 
@@ -534,12 +1050,9 @@ void _Setcommand(char ct[], uint8_t source)
         }
         if (source == 1)
         {
-            pot_com[0]  = '<';
-            pot_com[1]  = '-';
-            uart.BlockingTransmit(uart_com, 1);
-            uart.BlockingTransmit(pot_com, 2);
-            uart.BlockingTransmit(u_ct, strlen(ct));
-            uart.BlockingTransmit(uart_com+1, 1);
+            // one message, so the echo is queued as a whole
+            snprintf(pout, sizeof(pout), "<-%s\n", ct);
+            uart_tx.SendWait(uart_com, 1, u_pout, strlen(pout), UART_WAIT_MS);
             System::Delay(1);
         }
         hw.PrintLine("---> %s", ct);
@@ -552,9 +1065,16 @@ void _Setcommand(char ct[], uint8_t source)
 
     if (stc != NULL)
     {
-        if (strcmp(cmd, "pot") != 0)
+        if (strcmp(cmd, "pot") != 0 && strcmp(cmd, "brn") != 0 
+            && strcmp(cmd, "spr") != 0 && strcmp(cmd, "axr") != 0 
+            && strcmp(cmd, "rmp") != 0 && strcmp(cmd, "tur") != 0
+            && strcmp(cmd, "lvt") != 0 && strcmp(cmd, "lvr") != 0)
         {
             cdec     = CommandDecoder(stc, &ceff, &pos, fl, &fl_nb);
+            // a step change stops the ramps of the effect, which would 
+            // overwrite it, and keeps the callback off the effect meanwhile
+            if (cdec >= 0 && fl_nb > 0 && (effect_n = chain.Number(cmd)) >= 0)
+                ramps.Cancel(effect_n);
             //if (ceff != 0) chainf = 1;    // this prints the chain when an effect change its position
         }
         else cdec   = 0;
@@ -566,24 +1086,55 @@ void _Setcommand(char ct[], uint8_t source)
 		//************************************* Level Detector
 		if (strcmp(cmd, "lvd") == 0)
 		{
-			LevelDetectorParameters(fn);
+			lvd.GetParams(fn);
             ChangeEffectParams(fl, fn, fl_nb);
-			LevelDetectorSetTimes(samplerate, fn[0], fn[1]);
-			LevelDetectorPrintout(out_list, pout);
+			lvd.SetParams(fn);
+			lvd.Printout(out_list, 0, &chain, pout);
             if (muted) decoded      = 2;
             else decoded    = 1;
 		}
+		if (strcmp(cmd, "lvc") == 0)
+		{
+            i   = fl_nb > 0 ? (uint32_t)fl[0] : 0;
+            if (i < LVD_DETECTORS)
+            {
+                if (fl_nb > 2) lvd.SetTimes(i, fl[1], fl[2]);
+                if (fl_nb > 3) lvd.SetMode(i, fl[3] > 0.5);
+                lvd.Printout(out_list, i, &chain, pout);
+            }
+            else sprintf(pout, "->LVD: Invalid detector\n");
+            decoded     = 1;
+		}
+		if (strcmp(cmd, "lvt") == 0)
+		{
+            if (TapDecoder(&chain, &effect_n, &pot_id) == 0 
+                && lvd.SetTap(pot_id, effect_n) == 0)
+                lvd.Printout(out_list, pot_id, &chain, pout);
+            else sprintf(pout, "->LVD: Invalid detector or tap\n");
+            decoded     = 1;
+		}
+		if (strcmp(cmd, "lvr") == 0)
+		{
+            if (PotDecoder(&chain, stc, &effect_n, &pot_id) == 0 
+                && lvd.Route(effect_n, pot_id) == 0)
+            {
+                LevelSources();
+                lvd.Printout(out_list, lvd.Routed(effect_n) < 0 ? 0 : lvd.Routed(effect_n), 
+                        &chain, pout);
+            }
+            else sprintf(pout, "->LVD: Invalid effect or detector\n");
+            decoded     = 1;
+		}
 
 		//************************************* Compressor
 		if (strcmp(cmd, "cmp") == 0)
 		{
-            if (ceff > 0) chain.Swap(GSP_CMP, pos);
-            if (ceff < 0) chain.Remove(GSP_CMP);
+            ChainEdit(GSP_CMP, ceff, pos, source);
             pos = chain.Locate(GSP_CMP);
-            cps.GetParams(fn);
+            cps->GetParams(fn);
             ChangeEffectParams(fl, fn, fl_nb);
-			cps.SetParams(fn);
-            cps.Printout(out_list, pos, pout);
+			cps->SetParams(fn);
+            cps->Printout(out_list, pos, pout);
             if (muted) decoded      = 2;
             else decoded    = 1;
 		}
@@ -591,13 +1142,12 @@ void _Setcommand(char ct[], uint8_t source)
 		//************************************* Overdrive
 		if (strcmp(cmd, "ovd") == 0)
 		{
-            if (ceff > 0) chain.Swap(GSP_OVD, pos);
-            if (ceff < 0) chain.Remove(GSP_OVD);
+            ChainEdit(GSP_OVD, ceff, pos, source);
             pos = chain.Locate(GSP_OVD);
-			ovd.GetParams(fn);
+			ovd->GetParams(fn);
             ChangeEffectParams(fl, fn, fl_nb);
-			ovd.SetParams(fn);
-			ovd.Printout(out_list, pos, pout);
+			ovd->SetParams(fn);
+			ovd->Printout(out_list, pos, pout);
             if (muted) decoded      = 2;
             else decoded    = 1;
 		}
@@ -605,13 +1155,12 @@ void _Setcommand(char ct[], uint8_t source)
 		//************************************* Phaser
 		if (strcmp(cmd, "phr") == 0)
 		{        
-            if (ceff > 0) chain.Swap(GSP_PHR, pos);
-            if (ceff < 0) chain.Remove(GSP_PHR);
+            ChainEdit(GSP_PHR, ceff, pos, source);
             pos = chain.Locate(GSP_PHR);
-			phr.GetParams(fn);
+			phr->GetParams(fn);
             ChangeEffectParams(fl, fn, fl_nb);
-			phr.SetParams(fn);
-			phr.Printout(out_list, pos, pout);
+			phr->SetParams(fn);
+			phr->Printout(out_list, pos, pout);
             if (muted) decoded      = 2;
             else decoded    = 1;
 		}
@@ -619,13 +1168,12 @@ void _Setcommand(char ct[], uint8_t source)
 		//************************************* Octave
 		if (strcmp(cmd, "oct") == 0)
 		{
-            if (ceff > 0) chain.Swap(GSP_OCT, pos);
-            if (ceff < 0) chain.Remove(GSP_OCT);
+            ChainEdit(GSP_OCT, ceff, pos, source);
             pos = chain.Locate(GSP_OCT);
-			oct.GetParams(fn);
+			oct->GetParams(fn);
             ChangeEffectParams(fl, fn, fl_nb);
-			oct.SetParams(fn);
-			oct.Printout(out_list, pos, pout);
+			oct->SetParams(fn);
+			oct->Printout(out_list, pos, pout);
             if (muted) decoded      = 2;
             else decoded    = 1;
 		}
@@ -633,13 +1181,12 @@ void _Setcommand(char ct[], uint8_t source)
 		//************************************* PShifter
 		if (strcmp(cmd, "sft") == 0)
 		{
-            if (ceff > 0) chain.Swap(GSP_SFT, pos);
-            if (ceff < 0) chain.Remove(GSP_SFT);
+            ChainEdit(GSP_SFT, ceff, pos, source);
             pos = chain.Locate(GSP_SFT);
-			sft.GetParams(fn);
+			sft->GetParams(fn);
             ChangeEffectParams(fl, fn, fl_nb);
-			sft.SetParams(fn);
-			sft.Printout(out_list, pos, pout);
+			sft->SetParams(fn);
+			sft->Printout(out_list, pos, pout);
             if (muted) decoded      = 2;
             else decoded    = 1;
 		}
@@ -647,13 +1194,12 @@ void _Setcommand(char ct[], uint8_t source)
 		//************************************* Detune
 		if (strcmp(cmd, "dtn") == 0)
 		{
-            if (ceff > 0) chain.Swap(GSP_DTN, pos);
-            if (ceff < 0) chain.Remove(GSP_DTN);
+            ChainEdit(GSP_DTN, ceff, pos, source);
             pos = chain.Locate(GSP_DTN);
-			dtn.GetParams(fn);
+			dtn->GetParams(fn);
             ChangeEffectParams(fl, fn, fl_nb);
-			dtn.SetParams(fn);
-			dtn.Printout(out_list, pos, pout);
+			dtn->SetParams(fn);
+			dtn->Printout(out_list, pos, pout);
             if (muted) decoded      = 2;
             else decoded    = 1;
 		}
@@ -661,13 +1207,12 @@ void _Setcommand(char ct[], uint8_t source)
 		//************************************* WahWah
 		if (strcmp(cmd, "wah") == 0)
 		{
-            if (ceff > 0) chain.Swap(GSP_WAH, pos);
-            if (ceff < 0) chain.Remove(GSP_WAH);
+            ChainEdit(GSP_WAH, ceff, pos, source);
             pos = chain.Locate(GSP_WAH);
-			wah.GetParams(fn);
+			wah->GetParams(fn);
             ChangeEffectParams(fl, fn, fl_nb);
-			wah.SetParams(fn);
-			wah.Printout(out_list, pos, pout);
+			wah->SetParams(fn);
+			wah->Printout(out_list, pos, pout);
             if (muted) decoded      = 2;
             else decoded    = 1;
 		}
@@ -675,13 +1220,12 @@ void _Setcommand(char ct[], uint8_t source)
 		//************************************* Equalizer
 		if (strcmp(cmd, "eqz") == 0)
 		{
-            if (ceff > 0) chain.Swap(GSP_EQZ, pos);
-            if (ceff < 0) chain.Remove(GSP_EQZ);
+            ChainEdit(GSP_EQZ, ceff, pos, source);
             pos = chain.Locate(GSP_EQZ);
-			eqz.GetParams(fn);
+			eqz->GetParams(fn);
             ChangeEffectParams(fl, fn, fl_nb);
-			eqz.SetParams(fn);
-			eqz.Printout(out_list, pos, pout);
+			eqz->SetParams(fn);
+			eqz->Printout(out_list, pos, pout);
             if (muted) decoded      = 2;
             else decoded    = 1;
 		}
@@ -689,13 +1233,12 @@ void _Setcommand(char ct[], uint8_t source)
 		//************************************* Chorus
 		if (strcmp(cmd, "chs") == 0)
 		{
-            if (ceff > 0) chain.Swap(GSP_CHS, pos);
-            if (ceff < 0) chain.Remove(GSP_CHS);
+            ChainEdit(GSP_CHS, ceff, pos, source);
             pos = chain.Locate(GSP_CHS);
-			chs.GetParams(fn);
+			chs->GetParams(fn);
             ChangeEffectParams(fl, fn, fl_nb);
-			chs.SetParams(fn);
-			chs.Printout(out_list, pos, pout);
+			chs->SetParams(fn);
+			chs->Printout(out_list, pos, pout);
             if (muted) decoded      = 2;
             else decoded    = 1;
 		}
@@ -703,21 +1246,19 @@ void _Setcommand(char ct[], uint8_t source)
 		//************************************* Vibrato
 		if (strcmp(cmd, "vbt") == 0)
 		{
-            if (ceff > 0) chain.Swap(GSP_VBT, pos);
-            if (ceff < 0) chain.Remove(GSP_VBT);
+            ChainEdit(GSP_VBT, ceff, pos, source);
             pos = chain.Locate(GSP_VBT);
-			vbt.GetParams(fn);
+			vbt->GetParams(fn);
             ChangeEffectParams(fl, fn, fl_nb);
-			vbt.SetParams(fn);
-			vbt.Printout(out_list, pos, pout);
+			vbt->SetParams(fn);
+			vbt->Printout(out_list, pos, pout);
             if (muted) decoded      = 2;
             else decoded    = 1;
 		}
 		//************************************* Reverber
 		if (strcmp(cmd, "rvb") == 0)
 		{
-            if (ceff > 0) chain.Swap(GSP_RVB, pos);
-            if (ceff < 0) chain.Remove(GSP_RVB);
+            ChainEdit(GSP_RVB, ceff, pos, source);
             pos = chain.Locate(GSP_RVB);
 			rvb.GetParams(fn);
             ChangeEffectParams(fl, fn, fl_nb);
@@ -729,8 +1270,7 @@ void _Setcommand(char ct[], uint8_t source)
 		//************************************* Delay_FB
 		if (strcmp(cmd, "dfb") == 0)
 		{
-            if (ceff > 0) chain.Swap(GSP_DFB, pos);
-            if (ceff < 0) chain.Remove(GSP_DFB);
+            ChainEdit(GSP_DFB, ceff, pos, source);
             pos = chain.Locate(GSP_DFB);
 			dfb.GetParams(fn);
             ChangeEffectParams(fl, fn, fl_nb);
@@ -742,8 +1282,7 @@ void _Setcommand(char ct[], uint8_t source)
 		//************************************* Echo_FB
 		if (strcmp(cmd, "efb") == 0)
 		{
-            if (ceff > 0) chain.Swap(GSP_EFB, pos);
-            if (ceff < 0) chain.Remove(GSP_EFB);
+            ChainEdit(GSP_EFB, ceff, pos, source);
             pos = chain.Locate(GSP_EFB);
 			efb.GetParams(fn);
             ChangeEffectParams(fl, fn, fl_nb);
@@ -755,8 +1294,7 @@ void _Setcommand(char ct[], uint8_t source)
 		//************************************* Delay_FF
 		if (strcmp(cmd, "dff") == 0)
 		{
-            if (ceff > 0) chain.Swap(GSP_DFF, pos);
-            if (ceff < 0) chain.Remove(GSP_DFF);
+            ChainEdit(GSP_DFF, ceff, pos, source);
             pos = chain.Locate(GSP_DFF);
 			dff.GetParams(fn);
             ChangeEffectParams(fl, fn, fl_nb);
@@ -768,8 +1306,7 @@ void _Setcommand(char ct[], uint8_t source)
 		//************************************* Echo_FF
 		if (strcmp(cmd, "eff") == 0)
 		{
-            if (ceff > 0) chain.Swap(GSP_EFF, pos);
-            if (ceff < 0) chain.Remove(GSP_EFF);
+            ChainEdit(GSP_EFF, ceff, pos, source);
             pos = chain.Locate(GSP_EFF);
 			eff.GetParams(fn);
             ChangeEffectParams(fl, fn, fl_nb);
@@ -781,39 +1318,36 @@ void _Setcommand(char ct[], uint8_t source)
 		//************************************* Tremolo
 		if (strcmp(cmd, "tml") == 0)
 		{
-            if (ceff > 0) chain.Swap(GSP_TML, pos);
-            if (ceff < 0) chain.Remove(GSP_TML);
+            ChainEdit(GSP_TML, ceff, pos, source);
             pos = chain.Locate(GSP_TML);
-			tml.GetParams(fn);
+			tml->GetParams(fn);
             ChangeEffectParams(fl, fn, fl_nb);
-			tml.SetParams(fn);
-			tml.Printout(out_list, pos, pout);
+			tml->SetParams(fn);
+			tml->Printout(out_list, pos, pout);
             if (muted) decoded      = 2;
             else decoded    = 1;
 		}
 		//************************************* Limiter
 		if (strcmp(cmd, "lim") == 0)
 		{
-            if (ceff > 0) chain.Swap(GSP_LIM, pos);
-            if (ceff < 0) chain.Remove(GSP_LIM);
+            ChainEdit(GSP_LIM, ceff, pos, source);
             pos = chain.Locate(GSP_LIM);
-			lmt.GetParams(fn);
+			lmt->GetParams(fn);
             ChangeEffectParams(fl, fn, fl_nb);
-			lmt.SetParams(fn);
-			lmt.Printout(out_list, pos, pout);
+			lmt->SetParams(fn);
+			lmt->Printout(out_list, pos, pout);
             if (muted) decoded      = 2;
             else decoded    = 1;
 		}
 		//************************************* Volume
 		if (strcmp(cmd, "vol") == 0)
 		{
-            if (ceff > 0) chain.Swap(GSP_VOL, pos);
-            if (ceff < 0) chain.Remove(GSP_VOL);
+            ChainEdit(GSP_VOL, ceff, pos, source);
             pos = chain.Locate(GSP_VOL);
-			vol.GetParams(fn);
+			vol->GetParams(fn);
             ChangeEffectParams(fl, fn, fl_nb);
-			vol.SetParams(fn);
-			vol.Printout(out_list, pos, pout);
+			vol->SetParams(fn);
+			vol->Printout(out_list, pos, pout);
             pout[2]   = 'V';
             pout[3]   = 'O';
             pout[4]   = 'L';
@@ -823,16 +1357,65 @@ void _Setcommand(char ct[], uint8_t source)
 		//************************************* Noise Gate
 		if (strcmp(cmd, "ngt") == 0)
 		{
-            if (ceff > 0) chain.Swap(GSP_NGT, pos);
-            if (ceff < 0) chain.Remove(GSP_NGT);
+            ChainEdit(GSP_NGT, ceff, pos, source);
             pos = chain.Locate(GSP_NGT);
-			ngt.GetParams(fn);
+			ngt->GetParams(fn);
+            ChangeEffectParams(fl, fn, fl_nb);
+			ngt->SetParams(fn);
+			ngt->Printout(out_list, pos, pout);
+            if (muted) decoded      = 2;
+            else decoded    = 1;
+		}
+		//************************************* Looper
+		if (strcmp(cmd, "lpr") == 0)
+		{
+            ChainEdit(GSP_LPR, ceff, pos, source);
+            pos = chain.Locate(GSP_LPR);
+			lpr.GetParams(fn);
+            ChangeEffectParams(fl, fn, fl_nb);
+			lpr.SetParams(fn);
+			lpr.Printout(out_list, pos, pout);
+            if (muted) decoded      = 2;
+            else decoded    = 1;
+		}
+		if (strcmp(cmd, "lpc") == 0)
+		{
+            if (fl_nb > 0 && lpr.Control((uint8_t)fl[0]) < 0)
+                sprintf(pout, "->LPC: Invalid action\n");
+            else lpr.Printout(out_list, chain.Locate(GSP_LPR), pout);
+            decoded     = 1;
+		}
+		//************************************* Multiband Compressor
+		if (strcmp(cmd, "mbc") == 0)
+		{
+            ChainEdit(GSP_MBC, ceff, pos, source);
+            pos = chain.Locate(GSP_MBC);
+			mbc->GetParams(fn);
+            ChangeEffectParams(fl, fn, fl_nb);
+			mbc->SetParams(fn);
+			mbc->Printout(out_list, pos, pout);
+            if (muted) decoded      = 2;
+            else decoded    = 1;
+		}
+		//************************************* Second instances: cmp#2, ovd#2, ...
+		effect_n    = strchr(cmd, '#') != NULL ? chain.Number(cmd) : -1;
+		if (effect_n >= 0)
+		{
+            ChainEdit(effect_n, ceff, pos, source);
+            pos = chain.Locate(effect_n);
+            EffectParams(effect_n, fn, 0);
             ChangeEffectParams(fl, fn, fl_nb);
-			ngt.SetParams(fn);
-			ngt.Printout(out_list, pos, pout);
+            EffectParams(effect_n, fn, 1);
+            InstancePrintout(effect_n, pos, pout);
             if (muted) decoded      = 2;
             else decoded    = 1;
 		}
+		else if (strchr(cmd, '#') != NULL)
+		{
+            // the effects with delay lines have a single instance (see Chain.md)
+            sprintf(pout, "->%s: No such instance (cmp, ovd, phr, wah and eqz have #2)\n", cmd);
+            decoded     = 1;
+		}
 
 		// ************************************* External potentiometer
 		if (strcmp(cmd, "pot") == 0)
@@ -863,8 +1446,7 @@ void _Setcommand(char ct[], uint8_t source)
                             if (source == 0) hw.PrintLine(pout);
                             if (source == 1) 
                             {
-                                uart.BlockingTransmit(uart_com, 1);
-                                uart.BlockingTransmit(u_pout, strlen(pout));
+                                uart_tx.SendWait(uart_com, 1, u_pout, strlen(pout), UART_WAIT_MS);
                             }
                             decoded = 2; // no error
                             gpot    = 0; // no pot printing
@@ -920,8 +1502,7 @@ void _Setcommand(char ct[], uint8_t source)
                     if (source == 0) hw.PrintLine(pout);
                     if (source == 1) 
                     {
-                        uart.BlockingTransmit(uart_com, 1);
-                        uart.BlockingTransmit(u_pout, strlen(pout));
+                        uart_tx.SendWait(uart_com, 1, u_pout, strlen(pout), UART_WAIT_MS);
                     }
                 }
                 else
@@ -934,8 +1515,7 @@ void _Setcommand(char ct[], uint8_t source)
                         if (source == 0) hw.PrintLine(pout);
                         if (source == 1) 
                         {
-                            uart.BlockingTransmit(uart_com, 1);
-                            uart.BlockingTransmit(u_pout, strlen(pout));
+                            uart_tx.SendWait(uart_com, 1, u_pout, strlen(pout), UART_WAIT_MS);
                         }
                     }
                 }
@@ -951,14 +1531,50 @@ void _Setcommand(char ct[], uint8_t source)
 		//*********************************************** Clear - Chain
 		if (strcmp(cmd, "clr") == 0)
 		{
-			chain.Clear();
-			chainf    = 1;
+            if (xfd.time_ms > 0)
+            {
+                PresetCapture(&scene_next);
+                scene_next.number_effects   = 0;
+                for (i = 0; i < MAX_EFFECT_NUMBER; i++) scene_next.branch[i]  = GSP_MAIN;
+                if (SceneSwitch(&scene_next, source) < 0) 
+                {
+                    sprintf(pout, "->XFD: Scene switch in progress\n");
+                    decoded     = 1;
+                }
+                else chainf     = 1;
+            }
+			else
+            {
+                chain.Clear();
+                chainf    = 1;
+            }
 		}
 		//*********************************************** New - Chain
 		if (strcmp(cmd, "new") == 0)
 		{
-            chain.New();
-			chainf    = 1;
+            if (xfd.time_ms > 0)
+            {
+                PresetCapture(&scene_next);
+                fresh.New();
+                for (i = 0; i < MAX_EFFECT_NUMBER; i++) 
+                {
+                    scene_next.sgn_chain[i]     = fresh.sgn_chain[i];
+                    scene_next.branch[i]        = GSP_MAIN;
+                }
+                scene_next.number_effects   = fresh.number_effects;
+                scene_next.stereo_split     = -1;
+                if (SceneSwitch(&scene_next, source) < 0) 
+                {
+                    sprintf(pout, "->XFD: Scene switch in progress\n");
+                    decoded     = 1;
+                }
+                else chainf     = 1;
+            }
+            else
+            {
+                chain.New();
+                chainf    = 1;
+            }
 		}
 		//*********************************************** Command ID - Chain
 		if (strcmp(cmd, "cid") == 0)
@@ -967,16 +1583,14 @@ void _Setcommand(char ct[], uint8_t source)
             if (source == 0) hw.Print(pout);
             if (source == 1) 
             {
-                uart.BlockingTransmit(uart_com, 1);
-                uart.BlockingTransmit(u_pout, strlen(pout));
+                uart_tx.SendWait(uart_com, 1, u_pout, strlen(pout), UART_WAIT_MS);
             }
 
             chain.Effect_Name(-1, pout);
             if (source == 0) hw.Print(pout);
             if (source == 1) 
             {
-                uart.BlockingTransmit(uart_com, 1);
-                uart.BlockingTransmit(u_pout, strlen(pout));
+                uart_tx.SendWait(uart_com, 1, u_pout, strlen(pout), UART_WAIT_MS);
             }
 
             for (i = 1; i < chain.max_effect_number; i++)
@@ -985,8 +1599,7 @@ void _Setcommand(char ct[], uint8_t source)
                 if (source == 0) hw.Print(pout);
                 if (source == 1) 
                 {
-                    uart.BlockingTransmit(uart_com, 1);
-                    uart.BlockingTransmit(u_pout, strlen(pout));
+                    uart_tx.SendWait(uart_com, 1, u_pout, strlen(pout), UART_WAIT_MS);
                 }
             }
             decoded     = 2;
@@ -998,8 +1611,7 @@ void _Setcommand(char ct[], uint8_t source)
             if (source == 0) hw.Print(pout);
             if (source == 1) 
             {
-                uart.BlockingTransmit(uart_com, 1);
-                uart.BlockingTransmit(u_pout, strlen(pout));
+                uart_tx.SendWait(uart_com, 1, u_pout, strlen(pout), UART_WAIT_MS);
             }
 
             for (i = 0; i < lffg.profiles_number; i++)
@@ -1008,8 +1620,7 @@ void _Setcommand(char ct[], uint8_t source)
                 if (source == 0) hw.Print(pout);
                 if (source == 1) 
                 {
-                    uart.BlockingTransmit(uart_com, 1);
-                    uart.BlockingTransmit(u_pout, strlen(pout));
+                    uart_tx.SendWait(uart_com, 1, u_pout, strlen(pout), UART_WAIT_MS);
                 }
             }
             decoded     = 2;
@@ -1051,75 +1662,321 @@ void _Setcommand(char ct[], uint8_t source)
             sprintf(pout, "->FMT: Mute (-1) | Complete (0) | Data only (1) %ld\n", i);
             decoded     = 1;
 		}
-        // #******************************************* Chain Printout
-		if (chainf == 1)
+		//*********************************************** Status
+		if (strcmp(cmd, "sts") == 0)
 		{
-			chain.Printout(out_list, pout);
-            decoded = 1;
+            uart_tx.Printout(out_list, pout);
+            decoded     = 1;
 		}
- 		// #*********************************************** Output
-		if (decoded == 1)
+		//*********************************************** Baud rate
+		if (strcmp(cmd, "bdr") == 0)
 		{
-            //hw.PrintLine(">> %d  %d", muted, out_list);
-            if (strlen(pout) > 120)
+            if (fl_nb > 0 && baud_link.Propose((uint32_t)fl[0]) < 0)
             {
-                phal = pout[120];
-                pout[120] = 0;
-                if (source == 0) hw.Print(pout);
-                if (source == 1) 
+                sprintf(pout, "->BDR: Invalid baud rate %ld\n", (int32_t)fl[0]);
+            }
+            else if (fl_nb > 0)
+            {
+                sprintf(pout, "->BDR: Switching to %lu\n", (uint32_t)fl[0]);
+            }
+            else baud_link.Printout(out_list, pout);
+            decoded     = 1;
+		}
+		if (strcmp(cmd, "bok") == 0)
+		{
+            if (baud_link.Confirm() == 0) 
+                sprintf(pout, "->BDR: Baud rate %lu\n", baud_link.baudrate);
+            else sprintf(pout, "->BDR: No baud rate change pending\n");
+            decoded     = 1;
+		}
+		//*********************************************** Branch - Chain
+		if (strcmp(cmd, "brn") == 0)
+		{
+            if (PotDecoder(&chain, stc, &effect_n, &pot_id) == 0 && effect_n >= 0 
+                && pot_id >= GSP_MAIN && pot_id < GSP_BRANCHES)
+            {
+                chain.Branch(effect_n, pot_id);
+                chainf  = 1;
+            }
+            else
+            {
+                sprintf(pout, "->BRN: Invalid effect or branch\n");
+                decoded     = 1;
+            }
+		}
+		//*********************************************** Merge - Chain
+		if (strcmp(cmd, "mrg") == 0)
+		{
+            if (fl_nb > 1) chain.Merge(fl[0], fl[1]);
+            if (out_list == 0) sprintf(pout, "->MRG: Branch A (0-1): %-.3f | Branch B (0-1): %-.3f\n", 
+                chain.branch_level[GSP_BRANCH_A], chain.branch_level[GSP_BRANCH_B]);
+            else sprintf(pout, "->MRG %-.3f %-.3f\n", 
+                chain.branch_level[GSP_BRANCH_A], chain.branch_level[GSP_BRANCH_B]);
+            decoded     = 1;
+		}
+		//*********************************************** Stereo - Chain
+		if (strcmp(cmd, "stp") == 0)
+		{
+            if (fl_nb > 0) chain.Stereo((int32_t)fl[0]);
+            chainf  = 1;
+		}
+		if (strcmp(cmd, "spr") == 0)
+		{
+            stc     = strtok(NULL, " ,;");
+            if (stc == NULL)
+            {
+                // list the stereo effects
+                sprintf(pout, out_list == 0 ? "->SPR: Spread" : "->SPR");
+                for (i = 0; i < MAX_EFFECT_NUMBER; i++)
                 {
-                    uart.BlockingTransmit(uart_com, 1);
-                    uart.BlockingTransmit(u_pout, strlen(pout));
+                    if (EffectSpread(i, &fn[0], 0) < 0) continue;
+                    chain.Name(i, pname);
+                    sprintf(pout + strlen(pout), out_list == 0 ? " | %s: %-.2f" : " %s %-.2f", 
+                        pname, fn[0]);
                 }
-                pout[120] = phal;
-                if (source == 0) hw.PrintLine(pout+120);
-                if (source == 1) uart.BlockingTransmit(u_pout+120, strlen(pout)-120);
+                strcat(pout, "\n");
             }
             else
             {
-                if (source == 0) hw.PrintLine(pout);
-                if (source == 1) 
+                effect_n    = chain.Number(stc);
+                stc     = strtok(NULL, " ,;");
+                if (stc != NULL) fn[0]  = strtof(stc, NULL);
+                if (stc == NULL || EffectSpread(effect_n, &fn[0], 1) < 0)
+                    sprintf(pout, "->SPR: Invalid effect or spread\n");
+                else 
                 {
-                    //hw.PrintLine("send echo: %s", pout);
-                    uart.BlockingTransmit(uart_com, 1);
-                    uart.BlockingTransmit(u_pout, strlen(pout));
-                    //hw.PrintLine("send echo 0: %s", pout);
+                    EffectSpread(effect_n, &fn[0], 0);
+                    chain.Name(effect_n, pname);
+                    sprintf(pout, "->SPR: %s %-.2f\n", pname, fn[0]);
                 }
             }
+            decoded     = 1;
 		}
-		//********************************************** Unknown command
-		if (decoded == 0)
+		//*********************************************** Parameter ramps
+		if (strcmp(cmd, "rmp") == 0)
 		{
-            if (source == 0) hw.PrintLine("-> ?");
-            if (source == 1) 
+            stc     = strtok(NULL, " ,;");
+            if (stc == NULL) ramps.Printout(out_list, &chain, pout);
+            else if ((effect_n = chain.Number(stc)) < 0)
             {
-                sprintf(pout, "-> ?\n");
-                uart.BlockingTransmit(uart_com, 1);
-                uart.BlockingTransmit(u_pout, strlen(pout));
+                // any other word (clr) stops all the ramps
+                ramps.Cancel(-1);
+                ramps.Printout(out_list, &chain, pout);
             }
-//>>>			Serial1.println("-> ?");
+            else
+            {
+                for (i = 0; i < 4; i++)
+                {
+                    stc     = strtok(NULL, " ,;");
+                    fl[i]   = stc == NULL ? (i == 3 ? RAMP_LINEAR : -1) : strtof(stc, NULL);
+                }
+                fl_nb   = EffectParams(effect_n, fn, 0);
+                pot_id  = fl[0];
+                if (fl[0] < 0 || pot_id >= fl_nb || fl[2] < 0 
+                    || ((EffectSmooth(effect_n) >> pot_id) & 1) == 0)
+                    sprintf(pout, "->RMP: Invalid effect, parameter or time\n");
+                else if (ramps.Schedule(effect_n, pot_id, fn[pot_id], fl[1], fl[2], 
+                    (uint8_t)fl[3]) < 0)
+                    sprintf(pout, "->RMP: No free ramp\n");
+                else ramps.Printout(out_list, &chain, pout);
+            }
+            decoded     = 1;
 		}
-	}
-	else
-    {
-        if (source == 0) hw.PrintLine("->Unknown");
-        if (source == 1) 
-        {
-            sprintf(pout, "->Unknown\n");
-            uart.BlockingTransmit(uart_com, 1);
-            uart.BlockingTransmit(u_pout, strlen(pout));
-        }
-//>>>   Serial1.println("-> ?");
-    }
-
-    //hw.PrintLine("send echo 1: %s", pout);
-
-    return;
-}
-
-// ****************************************************************************
-
-char *CommandName(char ct[], char cmd[])
+		//*********************************************** Sample rate and block size
+		if (strcmp(cmd, "srt") == 0)
+		{
+            if (fl_nb > 0)
+            {
+                if (AudioConfig((uint32_t)fl[0], fl_nb > 1 ? (uint32_t)fl[1] : blocksize) < 0)
+                    sprintf(pout, "->SRT: Invalid rate or block size, or scene switch in progress\n");
+                else
+                {
+                    // the duty is reported after a whole second
+                    srt_source  = source;
+                    srt_report  = 2;
+                    AudioPrintout(out_list, pout);
+                }
+            }
+            else AudioPrintout(out_list, pout);
+            decoded     = 1;
+		}
+		//*********************************************** Callback overruns
+		if (strcmp(cmd, "xrn") == 0)
+		{
+            if (fl_nb > 0) xrun.safe_preset     = fl[0] < 0 ? -1 : (int32_t)fl[0];
+            if (fl_nb > 1 && fl[1] > 0.5) xrun.Reset();
+            xrun.Printout(out_list, pout);
+            decoded     = 1;
+		}
+		if (strcmp(cmd, "prf") == 0)
+		{
+            if (fl_nb > 0 && fl[0] > 0.5)
+            {
+                // processor cycle counter (DWT), started for the effect timing
+                CoreDebug->DEMCR    |= CoreDebug_DEMCR_TRCENA_Msk;
+                DWT->LAR            = 0xC5ACCE55;
+                DWT->CTRL           |= DWT_CTRL_CYCCNTENA_Msk;
+            }
+            if (fl_nb > 0) prf.Switch(fl[0] > 0.5);
+            if (fl_nb > 1 && fl[1] > 0.5) prf.Reset();
+
+            prf.Printout(out_list, pout);
+            if (source == 0) hw.Print(pout);
+            if (source == 1) 
+            {
+                uart_tx.SendWait(uart_com, 1, u_pout, strlen(pout), UART_WAIT_MS);
+            }
+            for (i = 0; i < chain.number_effects; i++)
+            {
+                prf.Printout(out_list, chain.sgn_chain[i], i, &chain, pout);
+                if (source == 0) hw.Print(pout);
+                if (source == 1) 
+                {
+                    uart_tx.SendWait(uart_com, 1, u_pout, strlen(pout), UART_WAIT_MS);
+                }
+            }
+            decoded     = 2;
+		}
+		//*********************************************** Second input
+		if (strcmp(cmd, "aux") == 0)
+		{
+            if (fl_nb > 0) aux.SetMode((uint8_t)fl[0]);
+            if (fl_nb > 1) aux.SetDecimation((uint32_t)fl[1]);
+            if (fl_nb > 2) aux.SetSmoothing(fl[2]);
+            AuxSources();
+            aux.Printout(out_list, &chain, pout);
+            decoded     = 1;
+		}
+		if (strcmp(cmd, "axr") == 0)
+		{
+            if (PotDecoder(&chain, stc, &effect_n, &pot_id) == 0 
+                && aux.Route(effect_n, pot_id > 0) == 0)
+            {
+                AuxSources();
+                aux.Printout(out_list, &chain, pout);
+            }
+            else sprintf(pout, "->AUX: Invalid effect or route\n");
+            decoded     = 1;
+		}
+		//*********************************************** Tuner
+		if (strcmp(cmd, "tun") == 0)
+		{
+            if (fl_nb > 0) tun.state    = fl[0] > 0.5 ? GSP_ON : GSP_OFF;
+            if (fl_nb > 1) tun.mute     = fl[1] > 0.5 ? GSP_ON : GSP_OFF;
+            if (fl_nb > 2) tun.SetThreshold(fl[2]);
+            tun.Printout(out_list, &chain, pout);
+            decoded     = 1;
+		}
+		if (strcmp(cmd, "tur") == 0)
+		{
+            if (PotDecoder(&chain, stc, &effect_n, &pot_id) == 0 
+                && tun.Route(effect_n, pot_id > 0) == 0)
+            {
+                AuxSources();
+                tun.Printout(out_list, &chain, pout);
+            }
+            else sprintf(pout, "->TUN: Invalid effect or route\n");
+            decoded     = 1;
+		}
+		//*********************************************** Presets
+		if (strcmp(cmd, "sav") == 0)
+		{
+            i   = (uint32_t)fl[0];
+            PresetCapture(&presets.snapshot);
+            if (fl_nb < 1 || presets.Store(i, &presets.snapshot) < 0)
+                sprintf(pout, "->SAV: Invalid slot or flash error\n");
+            else sprintf(pout, "->SAV: Preset %lu saved\n", i);
+            decoded     = 1;
+		}
+		if (strcmp(cmd, "rcl") == 0)
+		{
+            if (fl_nb < 1) presets.Printout(out_list, pout);
+            else if (presets.Slot((uint32_t)fl[0]) == NULL)
+                sprintf(pout, "->RCL: Preset %ld is empty\n", (int32_t)fl[0]);
+            else if (SceneSwitch(presets.Slot((uint32_t)fl[0]), source) < 0)
+                sprintf(pout, "->XFD: Scene switch in progress\n");
+            else chainf     = 1;
+            if (chainf == 0) decoded     = 1;
+		}
+		//*********************************************** Scene switch
+		if (strcmp(cmd, "xfd") == 0)
+		{
+            if (fl_nb > 0) xfd.SetTime(fl[0]);
+            xfd.Printout(out_list, pout);
+            decoded     = 1;
+		}
+		//*********************************************** Binary protocol
+		if (strcmp(cmd, "bin") == 0)
+		{
+            if (fl_nb > 0) binp.enabled = (fl[0] > 0.5);
+            if (binp.enabled) 
+                sprintf(pout, "->BIN: Binary protocol on (v%d) | Frames: %lu | Errors: %lu\n", 
+                    BINP_VERSION, binp.frames_ok, binp.frames_error);
+            else sprintf(pout, "->BIN: Binary protocol off\n");
+            decoded     = 1;
+		}
+        // #******************************************* Chain Printout
+		if (chainf == 1)
+		{
+			chain.Printout(out_list, pout);
+            decoded = 1;
+		}
+ 		// #*********************************************** Output
+		if (decoded == 1)
+		{
+            //hw.PrintLine(">> %d  %d", muted, out_list);
+            if (strlen(pout) > 120)
+            {
+                // the USB print is split, the UART reply is a single message
+                if (source == 1) uart_tx.SendWait(uart_com, 1, u_pout, strlen(pout), UART_WAIT_MS);
+                phal = pout[120];
+                pout[120] = 0;
+                if (source == 0) hw.Print(pout);
+                pout[120] = phal;
+                if (source == 0) hw.PrintLine(pout+120);
+            }
+            else
+            {
+                if (source == 0) hw.PrintLine(pout);
+                if (source == 1) 
+                {
+                    //hw.PrintLine("send echo: %s", pout);
+                    uart_tx.SendWait(uart_com, 1, u_pout, strlen(pout), UART_WAIT_MS);
+                    //hw.PrintLine("send echo 0: %s", pout);
+                }
+            }
+		}
+		//********************************************** Unknown command
+		if (decoded == 0)
+		{
+            if (source == 0) hw.PrintLine("-> ?");
+            if (source == 1) 
+            {
+                sprintf(pout, "-> ?\n");
+                uart_tx.SendWait(uart_com, 1, u_pout, strlen(pout), UART_WAIT_MS);
+            }
+//>>>			Serial1.println("-> ?");
+		}
+	}
+	else
+    {
+        if (source == 0) hw.PrintLine("->Unknown");
+        if (source == 1) 
+        {
+            sprintf(pout, "->Unknown\n");
+            uart_tx.SendWait(uart_com, 1, u_pout, strlen(pout), UART_WAIT_MS);
+        }
+//>>>   Serial1.println("-> ?");
+    }
+
+    //hw.PrintLine("send echo 1: %s", pout);
+
+    return;
+}
+
+// ****************************************************************************
+
+char *CommandName(char ct[], char cmd[])
 {
     /*
     Command name. Returns 0 if succeeded or -1 if it fails.
@@ -1289,6 +2146,45 @@ int8_t PotDecoder(GSP_SignalChain *chain_, char ct[],
 
 // ****************************************************************************
 
+int8_t TapDecoder(GSP_SignalChain *chain_, int32_t* effect_number, int32_t* detector)
+{
+    /*
+    To decode the tap of a level detector, in the format 'eff' det, where 
+    'lvd' is the chain input
+    chain_:
+        Pointer to the signal chain effects
+    effect_number
+        Returning pointer to the tapped effect 'eff' (LVD_INPUT for 'lvd')
+    detector
+        Returning pointer to the detector number det
+    Returns 0 if successfully decoded, or -1 if failed.
+    */
+
+    char      *st, *clast, name[4];
+    uint8_t   i;
+
+	st  = strtok(NULL, " ,;");  // effect token
+	if (st == NULL) return -1;
+
+    *effect_number  = chain_->Number(st);
+    if (*effect_number < 0)
+    {
+        // unknown names are also numbered -1
+        for (i = 0; i < 3 && st[i] != 0; i++) name[i] = tolower(st[i]);
+        name[i]     = 0;
+        if (strcmp(name, "lvd") != 0) return -1;
+        *effect_number  = LVD_INPUT;
+    }
+
+	st    = strtok(NULL, " ,;"); // detector
+	if (st == NULL) return -1;
+	*detector   = (int32_t)strtod(st, &clast);
+
+	return 0;
+}
+
+// ****************************************************************************
+
 void    SendPotStruct(GSP_Pots *pots_)
 {
     // To send the A command through UART to ESP32
@@ -1297,7 +2193,7 @@ void    SendPotStruct(GSP_Pots *pots_)
 
     // sending A command to ESP32 ...
 
-    uart.PollTx(pot_clear, 3);
+    uart_tx.SendWait(NULL, 0, pot_clear, 3, UART_WAIT_MS);
     System::Delay(1);
    
     pot_com[0]  = '}';
@@ -1312,7 +2208,7 @@ void    SendPotStruct(GSP_Pots *pots_)
 		//SerialPot.write(chain.seq_to_pot_id[i]+48);
 	}
     pot_com[i+2] = '\n';
-    uart.BlockingTransmit(pot_com, i+3);
+    uart_tx.SendWait(NULL, 0, pot_com, i+3, UART_WAIT_MS);
     System::Delay(1);
     //hw.PrintLine("Sent pot A command to ESP");
     //hw.PrintLine("Command A to ESP: %s", pot_com);  // to be removed
@@ -1320,3 +2216,873 @@ void    SendPotStruct(GSP_Pots *pots_)
 
     return;
 }
+
+// ****************************************************************************
+
+int32_t EffectParams(int32_t effect, float fn[], uint8_t set)
+{
+    /*
+    To retrieve or to change all the parameters of an effect given by its
+    enumerator, in the same sequence as the Effect Command.
+    effect
+        Effect number (see enum gsp_effects), or -1 for the Level Detector
+    fn[]
+        Parameter array (at least 8 values)
+    set
+        0 to retrieve the parameters (GetParams), 1 to change them (SetParams)
+    Returns the number of parameters of the effect, or -1 if the effect is unknown.
+    */
+
+    switch (effect)
+    {
+        case -1:
+            if (set) lvd.SetParams(fn); else lvd.GetParams(fn);
+            return 2;
+        case GSP_CMP:
+            if (set) cps->SetParams(fn); else cps->GetParams(fn);
+            return cps->number_params;
+        case GSP_OVD:
+            if (set) ovd->SetParams(fn); else ovd->GetParams(fn);
+            return ovd->number_params;
+        case GSP_PHR:
+            if (set) phr->SetParams(fn); else phr->GetParams(fn);
+            return phr->number_params;
+        case GSP_OCT:
+            if (set) oct->SetParams(fn); else oct->GetParams(fn);
+            return oct->number_params;
+        case GSP_SFT:
+            if (set) sft->SetParams(fn); else sft->GetParams(fn);
+            return sft->number_params;
+        case GSP_DTN:
+            if (set) dtn->SetParams(fn); else dtn->GetParams(fn);
+            return dtn->number_params;
+        case GSP_WAH:
+            if (set) wah->SetParams(fn); else wah->GetParams(fn);
+            return wah->number_params;
+        case GSP_EQZ:
+            if (set) eqz->SetParams(fn); else eqz->GetParams(fn);
+            return eqz->number_params;
+        case GSP_CHS:
+            if (set) chs->SetParams(fn); else chs->GetParams(fn);
+            return chs->number_params;
+        case GSP_VBT:
+            if (set) vbt->SetParams(fn); else vbt->GetParams(fn);
+            return vbt->number_params;
+        case GSP_RVB:
+            if (set) rvb.SetParams(fn); else rvb.GetParams(fn);
+            return rvb.number_params;
+        case GSP_DFB:
+            if (set) dfb.SetParams(fn); else dfb.GetParams(fn);
+            return dfb.number_params;
+        case GSP_EFB:
+            if (set) efb.SetParams(fn); else efb.GetParams(fn);
+            return efb.number_params;
+        case GSP_DFF:
+            if (set) dff.SetParams(fn); else dff.GetParams(fn);
+            return dff.number_params;
+        case GSP_EFF:
+            if (set) eff.SetParams(fn); else eff.GetParams(fn);
+            return eff.number_params;
+        case GSP_TML:
+            if (set) tml->SetParams(fn); else tml->GetParams(fn);
+            return tml->number_params;
+        case GSP_VOL:
+            if (set) vol->SetParams(fn); else vol->GetParams(fn);
+            return vol->number_params;
+        case GSP_LIM:
+            if (set) lmt->SetParams(fn); else lmt->GetParams(fn);
+            return lmt->number_params;
+        case GSP_NGT:
+            if (set) ngt->SetParams(fn); else ngt->GetParams(fn);
+            return ngt->number_params;
+        case GSP_LPR:
+            if (set) lpr.SetParams(fn); else lpr.GetParams(fn);
+            return lpr.number_params;
+        case GSP_MBC:
+            if (set) mbc->SetParams(fn); else mbc->GetParams(fn);
+            return mbc->number_params;
+        case GSP_CMP2:
+            if (set) cps2->SetParams(fn); else cps2->GetParams(fn);
+            return cps2->number_params;
+        case GSP_OVD2:
+            if (set) ovd2->SetParams(fn); else ovd2->GetParams(fn);
+            return ovd2->number_params;
+        case GSP_PHR2:
+            if (set) phr2->SetParams(fn); else phr2->GetParams(fn);
+            return phr2->number_params;
+        case GSP_WAH2:
+            if (set) wah2->SetParams(fn); else wah2->GetParams(fn);
+            return wah2->number_params;
+        case GSP_EQZ2:
+            if (set) eqz2->SetParams(fn); else eqz2->GetParams(fn);
+            return eqz2->number_params;
+        default:
+            break;
+    }
+
+    return -1;
+}
+
+// ****************************************************************************
+
+int32_t EffectSpread(int32_t effect, float *spread, uint8_t set)
+{
+    /*
+    To retrieve or to change the stereo spread of an effect: LFO phase 
+    offset in degrees (chorus, vibrato, tremolo and volume), width (reverber)
+    or ping-pong (delays and echoes).
+    effect
+        Effect number (see enum gsp_effects)
+    spread
+        Spread value
+    set
+        0 to retrieve the spread, 1 to change it
+    Returns 0, or -1 if the effect has no stereo version.
+    */
+
+    switch (effect)
+    {
+        case GSP_CHS:
+            if (set) chs->SetSpread(*spread); else *spread = chs->spread;
+            return 0;
+        case GSP_VBT:
+            if (set) vbt->SetSpread(*spread); else *spread = vbt->spread;
+            return 0;
+        case GSP_RVB:
+            if (set) rvb.SetSpread(*spread); else *spread = rvb.spread;
+            return 0;
+        case GSP_DFB:
+            if (set) dfb.SetSpread(*spread); else *spread = dfb.spread;
+            return 0;
+        case GSP_EFB:
+            if (set) efb.SetSpread(*spread); else *spread = efb.spread;
+            return 0;
+        case GSP_DFF:
+            if (set) dff.SetSpread(*spread); else *spread = dff.spread;
+            return 0;
+        case GSP_EFF:
+            if (set) eff.SetSpread(*spread); else *spread = eff.spread;
+            return 0;
+        case GSP_TML:
+            if (set) tml->SetSpread(*spread); else *spread = tml->spread;
+            return 0;
+        case GSP_VOL:
+            if (set) vol->SetSpread(*spread); else *spread = vol->spread;
+            return 0;
+        default:
+            break;
+    }
+
+    return -1;
+}
+
+// ****************************************************************************
+
+int8_t EffectParam(int32_t effect, uint8_t idx, float value)
+{
+    /*
+    To change a single parameter of an effect at the sampling rate, without
+    resetting its state (parameter ramps). Only the parameters of the effect
+    smooth_params mask can be changed this way.
+    effect
+        Effect number (see enum gsp_effects)
+    idx
+        Parameter index, as in the Effect Command
+    value
+        New value
+    Returns 0, or -1 if the effect or the parameter can't be ramped.
+    */
+
+    switch (effect)
+    {
+        case GSP_CMP: return cps->SetParam(idx, value);
+        case GSP_OVD: return ovd->SetParam(idx, value);
+        case GSP_PHR: return phr->SetParam(idx, value);
+        case GSP_OCT: return oct->SetParam(idx, value);
+        case GSP_SFT: return sft->SetParam(idx, value);
+        case GSP_DTN: return dtn->SetParam(idx, value);
+        case GSP_WAH: return wah->SetParam(idx, value);
+        case GSP_EQZ: return eqz->SetParam(idx, value);
+        case GSP_CHS: return chs->SetParam(idx, value);
+        case GSP_VBT: return vbt->SetParam(idx, value);
+        case GSP_DFB: return dfb.SetParam(idx, value);
+        case GSP_EFB: return efb.SetParam(idx, value);
+        case GSP_DFF: return dff.SetParam(idx, value);
+        case GSP_EFF: return eff.SetParam(idx, value);
+        case GSP_TML: return tml->SetParam(idx, value);
+        case GSP_VOL: return vol->SetParam(idx, value);
+        case GSP_LIM: return lmt->SetParam(idx, value);
+        case GSP_NGT: return ngt->SetParam(idx, value);
+        case GSP_LPR: return lpr.SetParam(idx, value);
+        case GSP_MBC: return mbc->SetParam(idx, value);
+        case GSP_CMP2: return cps2->SetParam(idx, value);
+        case GSP_OVD2: return ovd2->SetParam(idx, value);
+        case GSP_PHR2: return phr2->SetParam(idx, value);
+        case GSP_WAH2: return wah2->SetParam(idx, value);
+        case GSP_EQZ2: return eqz2->SetParam(idx, value);
+        default:
+            break;
+    }
+
+    return -1;
+}
+
+// ****************************************************************************
+
+uint8_t EffectSmooth(int32_t effect)
+{
+    /*
+    To get the parameters of an effect that can be ramped, without 
+    changing them.
+    effect
+        Effect number (see enum gsp_effects)
+    Returns the smooth_params bit mask of the effect (bit = parameter 
+    index), or 0 if the effect has no ramps.
+    */
+
+    switch (effect)
+    {
+        case GSP_CMP: return cps->smooth_params;
+        case GSP_OVD: return ovd->smooth_params;
+        case GSP_PHR: return phr->smooth_params;
+        case GSP_OCT: return oct->smooth_params;
+        case GSP_SFT: return sft->smooth_params;
+        case GSP_DTN: return dtn->smooth_params;
+        case GSP_WAH: return wah->smooth_params;
+        case GSP_EQZ: return eqz->smooth_params;
+        case GSP_CHS: return chs->smooth_params;
+        case GSP_VBT: return vbt->smooth_params;
+        case GSP_DFB: return dfb.smooth_params;
+        case GSP_EFB: return efb.smooth_params;
+        case GSP_DFF: return dff.smooth_params;
+        case GSP_EFF: return eff.smooth_params;
+        case GSP_TML: return tml->smooth_params;
+        case GSP_VOL: return vol->smooth_params;
+        case GSP_LIM: return lmt->smooth_params;
+        case GSP_NGT: return ngt->smooth_params;
+        case GSP_LPR: return lpr.smooth_params;
+        case GSP_MBC: return mbc->smooth_params;
+        case GSP_CMP2: return cps2->smooth_params;
+        case GSP_OVD2: return ovd2->smooth_params;
+        case GSP_PHR2: return phr2->smooth_params;
+        case GSP_WAH2: return wah2->smooth_params;
+        case GSP_EQZ2: return eqz2->smooth_params;
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+// ****************************************************************************
+
+void InstancePrintout(int32_t effect, int32_t chn_pos, char *printout)
+{
+    /*
+    To print the parameters of a second instance, named like the first one
+    with "#2" (->OVD#2 (3): ...).
+    effect
+        Effect number (GSP_CMP2 to GSP_EQZ2)
+    chn_pos
+        Position in chain
+    */
+
+    switch (effect)
+    {
+        case GSP_CMP2: cps2->Printout(out_list, chn_pos, printout); break;
+        case GSP_OVD2: ovd2->Printout(out_list, chn_pos, printout); break;
+        case GSP_PHR2: phr2->Printout(out_list, chn_pos, printout); break;
+        case GSP_WAH2: wah2->Printout(out_list, chn_pos, printout); break;
+        case GSP_EQZ2: eqz2->Printout(out_list, chn_pos, printout); break;
+        default: 
+            printout[0]     = 0;
+            return;
+    }
+
+    // "->OVD (3)..." becomes "->OVD#2 (3)..."
+    memmove(printout + 7, printout + 5, strlen(printout + 5) + 1);
+    printout[5]     = '#';
+    printout[6]     = '2';
+
+    return;
+}
+
+// ****************************************************************************
+
+void EffectsInit()
+{
+    /*
+    To initiate all the effects with the current sampling rate (default
+    parameters).
+    */
+
+    cps->Init(samplerate);
+    ovd->Init(samplerate);
+    phr->Init(samplerate);
+    wah->Init(samplerate);
+    dtn->Init(samplerate, adc_buffer, BUFFER_SIZE);
+    sft->Init(samplerate, adc_buffer, BUFFER_SIZE);
+    oct->Init(samplerate, adc_buffer, BUFFER_SIZE);
+    chs->Init(samplerate, adc_buffer, BUFFER_SIZE);
+    vbt->Init(samplerate, adc_buffer, BUFFER_SIZE);
+    dfb.Init(samplerate, adc_buffer, BUFFER_SIZE);
+    efb.Init(samplerate, adc_buffer, BUFFER_SIZE);
+    dfb.SetStereoBuffer(stereo_buffer);
+    efb.SetStereoBuffer(stereo_buffer);
+    dfb.SetTailBuffer(dfb_tail);
+    efb.SetTailBuffer(efb_tail);
+    dff.Init(samplerate, adc_buffer, BUFFER_SIZE);
+    eff.Init(samplerate, adc_buffer, BUFFER_SIZE);
+    dff.SetCombBuffer(dff_comb);
+    eff.SetCombBuffer(eff_comb);
+    eqz->Init(samplerate);
+    rvb.Init(samplerate, rvb_buffer, REV_BUFSIZE);
+    tml->Init(samplerate);
+    lmt->Init(samplerate);
+    vol->Init(samplerate);
+    ngt->Init(samplerate);
+    lpr.Init(samplerate, lpr_loop, lpr_layer, LPR_SIZE);
+    mbc->Init(samplerate);
+    cps2->Init(samplerate);
+    ovd2->Init(samplerate);
+    phr2->Init(samplerate);
+    wah2->Init(samplerate);
+    eqz2->Init(samplerate);
+
+    return;
+}
+
+// ****************************************************************************
+
+int8_t AudioConfig(uint32_t rate, uint32_t block)
+{
+    /*
+    To change the sampling rate and the audio block size. The audio stops,
+    the effects are initiated with the new rate and get back their 
+    parameters (given in milliseconds or hertz, so they sound the same), 
+    and the audio restarts. Delay lines and reverber are cleared.
+    rate
+        Sampling rate: 32000, 48000 or 96000 Hz (or 32, 48 and 96)
+    block
+        Samples per audio callback (1 to AUDIO_MAX_BLOCK)
+    Returns 0, or -1 if the rate or the block size is invalid, or a scene
+    switch is in progress.
+    */
+
+    SaiHandle::Config::SampleRate   sai_rate;
+    float       xfd_time;
+    int32_t     safe;
+    uint8_t     timing;
+
+    if (rate < 1000) rate   *= 1000;
+    switch (rate)
+    {
+        case 32000: sai_rate = SaiHandle::Config::SampleRate::SAI_32KHZ; break;
+        case 48000: sai_rate = SaiHandle::Config::SampleRate::SAI_48KHZ; break;
+        case 96000: sai_rate = SaiHandle::Config::SampleRate::SAI_96KHZ; break;
+        default: return -1;
+    }
+    if (block < 1 || block > AUDIO_MAX_BLOCK) return -1;
+    if (xfd.active) return -1;
+
+    PresetCapture(&presets.snapshot);
+
+    hw.StopAudio();
+    hw.SetAudioSampleRate(sai_rate);
+    hw.SetAudioBlockSize(block);
+    samplerate      = (uint32_t)(hw.AudioSampleRate() + 0.1f);
+    blocksize       = hw.AudioBlockSize();
+
+    xfd_time        = xfd.time_ms;
+    xfd.Init(samplerate, 200000000);
+    xfd.SetTime(xfd_time);
+    aux.sample_rate = samplerate;
+    aux.SetSmoothing(aux.smoothing_ms);
+    safe    = xrun.safe_preset;
+    xrun.Init(samplerate, blocksize, 200000000);
+    xrun.safe_preset    = safe;
+    timing  = prf.state;
+    prf.Init(samplerate, System::GetSysClkFreq());
+    prf.Switch(timing);
+    ramps.Init(samplerate);
+    tun.SetSampleRate(samplerate);
+    lvd.SetSampleRate(samplerate);
+
+    EffectsInit();
+    PresetApply(&presets.snapshot);
+    AuxSources();
+
+    tend    = 0;
+    hw.StartAudio(GuitardspCB);
+
+    return 0;
+}
+
+// ****************************************************************************
+
+void AudioPrintout(uint8_t out_list, char *printout)
+{
+    /*
+    To print the sampling rate, the block size, the block period and the 
+    processor load (duty, in percent) measured in the last second.
+    */
+
+    if (out_list == 0)
+    {
+        sprintf(printout, "->SRT: Sample rate (Hz): %lu "
+        "| Block size (1-64): %lu | Block time (ms): %-.3f | Duty (%%): %-.1f\n", 
+        samplerate, blocksize, 1000.f*blocksize/samplerate, duty);
+    }
+    if (out_list == 1)
+    {
+        sprintf(printout, "->SRT %lu %lu %-.3f %-.1f\n", 
+        samplerate, blocksize, 1000.f*blocksize/samplerate, duty);
+    }
+
+    return;
+}
+
+// ****************************************************************************
+
+static const uint32_t *CvSource(int32_t effect)
+{
+    /*
+    Returns the signal driving the LFO_EXTERNAL profile of an effect: the 
+    second input (CV mode), the detected pitch, or NULL for the expression 
+    pedals. The second input takes precedence.
+    */
+
+    if (aux.mode == AUX_CV && aux.Routed(effect)) return &aux.cv;
+    if (tun.Routed(effect)) return &tun.cv;
+
+    return NULL;
+}
+
+void AuxSources()
+{
+    /*
+    To drive the LFO_EXTERNAL profiles of the routed effects by the second 
+    input (CV mode) or by the pitch detector, or back by the expression 
+    pedals.
+    */
+
+    phr->lfo.SetSource(CvSource(GSP_PHR));
+    wah->lfo.SetSource(CvSource(GSP_WAH));
+    chs->lfo.SetSource(CvSource(GSP_CHS));
+    vbt->lfo.SetSource(CvSource(GSP_VBT));
+    tml->lfo.SetSource(CvSource(GSP_TML));
+    vol->lfo.SetSource(CvSource(GSP_VOL));
+    phr2->lfo.SetSource(CvSource(GSP_PHR2));
+    wah2->lfo.SetSource(CvSource(GSP_WAH2));
+
+    return;
+}
+
+// ****************************************************************************
+
+static void LfoLevel(LowFreqOsc *lfo, uint8_t state, int32_t effect)
+{
+    /*
+    To give its level detector to the LFO of an effect, in use only in the
+    LFO_LEVEL and LFO_REVERSE_LEVEL profiles.
+    */
+
+    lfo->SetLevel(lvd.Level(effect));
+    lvd.Subscribe(effect, state == GSP_ON && chain.Locate(effect) >= 0 
+            && (lfo->profile == LFO_LEVEL || lfo->profile == LFO_REVERSE_LEVEL));
+
+    return;
+}
+
+void LevelSources()
+{
+    /*
+    To give the level detectors to the effects routed to them (lvr), and to
+    subscribe the effects using them: switched on, in the chain and, for the
+    LFOs, in a level profile. The detectors without subscribers aren't 
+    computed, so an idle chain doesn't pay for level detection.
+    */
+
+    LfoLevel(&phr->lfo, phr->state, GSP_PHR);
+    LfoLevel(&wah->lfo, wah->state, GSP_WAH);
+    LfoLevel(&chs->lfo, chs->state, GSP_CHS);
+    LfoLevel(&vbt->lfo, vbt->state, GSP_VBT);
+    LfoLevel(&tml->lfo, tml->state, GSP_TML);
+    LfoLevel(&vol->lfo, vol->state, GSP_VOL);
+    LfoLevel(&phr2->lfo, phr2->state, GSP_PHR2);
+    LfoLevel(&wah2->lfo, wah2->state, GSP_WAH2);
+
+    cps->SetLevel(lvd.Level(GSP_CMP));
+    lvd.Subscribe(GSP_CMP, cps->state == GSP_ON && chain.Locate(GSP_CMP) >= 0);
+    ngt->SetLevel(lvd.Level(GSP_NGT));
+    lvd.Subscribe(GSP_NGT, ngt->state == GSP_ON && chain.Locate(GSP_NGT) >= 0);
+    cps2->SetLevel(lvd.Level(GSP_CMP2));
+    lvd.Subscribe(GSP_CMP2, cps2->state == GSP_ON && chain.Locate(GSP_CMP2) >= 0);
+
+    return;
+}
+
+// ****************************************************************************
+
+void PresetCapture(GSP_Snapshot *snapshot)
+{
+    /*
+    To copy the chain and the parameters of all the effects into a preset.
+    */
+
+    uint32_t    i;
+
+    snapshot->number_effects    = chain.number_effects;
+    for (i = 0; i < MAX_EFFECT_NUMBER; i++)
+    {
+        snapshot->sgn_chain[i]  = chain.sgn_chain[i];
+        snapshot->branch[i]     = chain.branch[i];
+        snapshot->spread[i]     = 0;
+        EffectParams(i, snapshot->params[i], 0);
+        EffectSpread(i, &snapshot->spread[i], 0);
+    }
+    snapshot->stereo_split  = chain.stereo_split;
+    for (i = 0; i < GSP_BRANCHES; i++)
+    {
+        snapshot->branch_level[i]   = chain.branch_level[i];
+    }
+    EffectParams(-1, snapshot->params[PRESET_LVD], 0);
+
+    return;
+}
+
+// ****************************************************************************
+
+void PresetApply(GSP_Snapshot *snapshot)
+{
+    /*
+    To apply a preset while the audio is stopped (audio configuration). The 
+    audio callback by-passes the chain while the preset is applied, so a 
+    sample is never processed by a partially changed chain. The rcl command
+    goes through SceneSwitch, where the old chain keeps playing meanwhile.
+    */
+
+    uint32_t    i;
+
+    preset_hold     = 1;
+    ramps.Cancel(-1);
+
+    chain.number_effects    = snapshot->number_effects;
+    for (i = 0; i < MAX_EFFECT_NUMBER; i++)
+    {
+        chain.sgn_chain[i]  = snapshot->sgn_chain[i];
+        chain.branch[i]     = snapshot->branch[i];
+        EffectParams(i, snapshot->params[i], 1);
+        EffectSpread(i, &snapshot->spread[i], 1);
+    }
+    chain.Merge(snapshot->branch_level[GSP_BRANCH_A], 
+        snapshot->branch_level[GSP_BRANCH_B]);
+    chain.Stereo(snapshot->stereo_split);
+    EffectParams(-1, snapshot->params[PRESET_LVD], 1);
+
+    preset_hold     = 0;
+
+    return;
+}
+
+// ****************************************************************************
+
+static uint8_t TimeBased(int32_t effect)
+{
+    /*
+    Returns 1 for the effects with long memory (delays, echoes, reverber and
+    looper), which keep a single instance during a scene switch.
+    */
+
+    return effect == GSP_RVB || effect == GSP_DFB || effect == GSP_EFB 
+        || effect == GSP_DFF || effect == GSP_EFF || effect == GSP_LPR;
+}
+
+// ****************************************************************************
+
+static int32_t ChainLocate(const int32_t sgn_chain[], uint32_t number_effects, 
+        int32_t effect)
+{
+    /*
+    Returns the position of an effect in a chain, or -1 if not found.
+    */
+
+    uint32_t    i;
+
+    for (i = 0; i < number_effects; i++)
+    {
+        if (sgn_chain[i] == effect) return i;
+    }
+
+    return -1;
+}
+
+// ****************************************************************************
+
+static void SpareCopy(int32_t effect)
+{
+    /*
+    To copy a live effect to the spare rack (scene switch). The live effect
+    keeps running meanwhile, so the copy may mix values a few samples apart;
+    it only starts the new scene, which fades in from silence.
+    */
+
+    GSP_Rack    *l, *s;
+
+    l   = live_rack;
+    s   = old_rack;
+    switch (effect)
+    {
+        case GSP_CMP: *s->cps   = *l->cps; break;
+        case GSP_OVD: *s->ovd   = *l->ovd; break;
+        case GSP_PHR: *s->phr   = *l->phr; break;
+        case GSP_OCT: *s->oct   = *l->oct; break;
+        case GSP_SFT: *s->sft   = *l->sft; break;
+        case GSP_DTN: *s->dtn   = *l->dtn; break;
+        case GSP_WAH: *s->wah   = *l->wah; break;
+        case GSP_EQZ: *s->eqz   = *l->eqz; break;
+        case GSP_CHS: *s->chs   = *l->chs; break;
+        case GSP_VBT: *s->vbt   = *l->vbt; break;
+        case GSP_TML: *s->tml   = *l->tml; break;
+        case GSP_VOL: *s->vol   = *l->vol; break;
+        case GSP_LIM: *s->lmt   = *l->lmt; break;
+        case GSP_NGT: *s->ngt   = *l->ngt; break;
+        case GSP_MBC: *s->mbc   = *l->mbc; break;
+        case GSP_CMP2: *s->cps2     = *l->cps2; break;
+        case GSP_OVD2: *s->ovd2     = *l->ovd2; break;
+        case GSP_PHR2: *s->phr2     = *l->phr2; break;
+        case GSP_WAH2: *s->wah2     = *l->wah2; break;
+        case GSP_EQZ2: *s->eqz2     = *l->eqz2; break;
+        default: break;
+    }
+
+    return;
+}
+
+// ****************************************************************************
+
+static void RackSelect()
+{
+    /*
+    To point the effects used by the commands to the live rack.
+    */
+
+    cps     = live_rack->cps;
+    ovd     = live_rack->ovd;
+    phr     = live_rack->phr;
+    wah     = live_rack->wah;
+    dtn     = live_rack->dtn;
+    sft     = live_rack->sft;
+    oct     = live_rack->oct;
+    eqz     = live_rack->eqz;
+    chs     = live_rack->chs;
+    vbt     = live_rack->vbt;
+    tml     = live_rack->tml;
+    vol     = live_rack->vol;
+    lmt     = live_rack->lmt;
+    ngt     = live_rack->ngt;
+    mbc     = live_rack->mbc;
+    cps2    = live_rack->cps2;
+    ovd2    = live_rack->ovd2;
+    phr2    = live_rack->phr2;
+    wah2    = live_rack->wah2;
+    eqz2    = live_rack->eqz2;
+
+    return;
+}
+
+// ****************************************************************************
+
+int8_t SceneSwitch(GSP_Snapshot *snapshot, uint8_t source)
+{
+    /*
+    To switch to a new scene (chain and parameters) with a crossfade. The 
+    current effects are copied to the spare rack, and the racks are swapped:
+    the current effects keep running the old scene, while the copies become
+    the live effects, are configured with the new one and warm up during the
+    crossfade. Delays, echoes, reverber and looper kept by the new scene 
+    aren't copied: they run once per sample, in the old chain until the new
+    one is configured and then in the new chain, so their tails ring across
+    the switch (their buffers are cleared only if their parameters change).
+    Delays, echoes, reverber and looper dropped by the new scene fade out 
+    with the old chain, and get their new parameters at the end (SceneFinish).
+    With the crossfade off (xfd.time_ms = 0) the old scene plays until the 
+    new one is configured, which takes over at the start of the next block.
+    snapshot
+        New scene
+    source
+        Command source, which receives the processor load report
+    Returns 0, or -1 if a switch is already in progress.
+    */
+
+    uint32_t    i, n;
+    int32_t     effect, nb;
+    float       fn[PRESET_PARAMS];
+    GSP_Rack    *r;
+
+    if (xfd.active) return -1;
+
+    if (snapshot != &scene_next) scene_next     = *snapshot;
+    xfd_source  = source;
+    ramps.Cancel(-1);
+
+    // old chain: the whole current chain, with the single instances kept by
+    // the new scene marked as shared
+    n               = chain.number_effects;
+    xfd.shared      = 0;
+    for (i = 0; i < n; i++)
+    {
+        effect  = chain.sgn_chain[i];
+        xfd.sgn_chain[i]    = effect;
+        if (TimeBased(effect) && ChainLocate(scene_next.sgn_chain, 
+            scene_next.number_effects, effect) >= 0) xfd.shared   |= 1 << effect;
+    }
+    xfd.number_effects  = n;
+    xfd.stereo_split    = chain.stereo_split;
+    for (i = 0; i < MAX_EFFECT_NUMBER; i++) xfd.branch[i]   = chain.branch[i];
+    for (i = 0; i < GSP_BRANCHES; i++) xfd.branch_level[i]  = chain.branch_level[i];
+
+    // the copies are taken while the audio runs (the spare rack isn't
+    // processed), and only the racks are swapped between two samples
+    for (i = 0; i < MAX_EFFECT_NUMBER; i++) SpareCopy(i);
+    __disable_irq();
+    r           = live_rack;
+    live_rack   = old_rack;
+    old_rack    = r;
+    RackSelect();
+    xfd.Start();
+    __enable_irq();
+
+    // new chain, processed only after Release()
+    chain.number_effects    = scene_next.number_effects;
+    for (i = 0; i < MAX_EFFECT_NUMBER; i++)
+    {
+        chain.sgn_chain[i]  = scene_next.sgn_chain[i];
+        chain.branch[i]     = scene_next.branch[i];
+    }
+    chain.Merge(scene_next.branch_level[GSP_BRANCH_A], 
+        scene_next.branch_level[GSP_BRANCH_B]);
+    chain.Stereo(scene_next.stereo_split);
+    for (i = 0; i < MAX_EFFECT_NUMBER; i++)
+    {
+        EffectSpread(i, &scene_next.spread[i], 1);
+        if (TimeBased(i))
+        {
+            // the ones dropped by the new scene are fading out
+            if (((xfd.shared >> i) & 1) == 0 && ChainLocate(xfd.sgn_chain, n, i) >= 0) continue;
+            nb  = EffectParams(i, fn, 0);
+            if (memcmp(fn, scene_next.params[i], nb*sizeof(float)) == 0) continue;
+        }
+        EffectParams(i, scene_next.params[i], 1);
+    }
+    EffectParams(-1, scene_next.params[PRESET_LVD], 1);
+
+    xfd.Release();
+
+    return 0;
+}
+
+// ****************************************************************************
+
+void SceneFinish()
+{
+    /*
+    To apply the new parameters to the delays, echoes, reverber and looper
+    dropped by the new scene, once they have faded out with the old chain.
+    */
+
+    uint32_t    i;
+    int32_t     effect;
+
+    for (i = 0; i < xfd.number_effects; i++)
+    {
+        effect  = xfd.sgn_chain[i];
+        if (TimeBased(effect) && ((xfd.shared >> effect) & 1) == 0) 
+            EffectParams(effect, scene_next.params[effect], 1);
+    }
+
+    return;
+}
+
+// ****************************************************************************
+
+int8_t ChainEdit(int32_t effect, int32_t ceff, int32_t pos, uint8_t source)
+{
+    /*
+    To move an effect in the chain, or to remove it, as requested by an 
+    effect command. With the scene switch on, the edited chain is reached 
+    through a crossfade (SceneSwitch).
+    effect
+        Effect number (see enum gsp_effects)
+    ceff
+        1 to move or add the effect at pos, -1 to remove it, 0 for no change
+    pos
+        New position in the chain
+    source
+        Command source, which receives the processor load report
+    Returns 0, or -1 if a switch is already in progress (chain unchanged).
+    */
+
+    GSP_SignalChain     edit;
+    uint32_t            i;
+
+    if (ceff == 0) return 0;
+    if (xfd.time_ms <= 0)
+    {
+        if (ceff > 0) chain.Swap(effect, pos);
+        if (ceff < 0) chain.Remove(effect);
+        return 0;
+    }
+    if (xfd.active) return -1;
+
+    edit    = chain;
+    if (ceff > 0) edit.Swap(effect, pos);
+    if (ceff < 0) edit.Remove(effect);
+    PresetCapture(&scene_next);
+    scene_next.number_effects   = edit.number_effects;
+    for (i = 0; i < MAX_EFFECT_NUMBER; i++) scene_next.sgn_chain[i]  = edit.sgn_chain[i];
+
+    return SceneSwitch(&scene_next, source);
+}
+
+// ****************************************************************************
+
+int8_t BinaryUpdate()
+{
+    /*
+    To apply the parameter updates of the last decoded binary frame.
+    Consecutive updates of the same effect are gathered and applied with a
+    single SetParams call, after stopping the ramps of the effect.
+    Returns 1 if all the updates were applied, or 0 if any effect or
+    parameter index was out of range (valid updates of the frame are
+    still applied).
+    */
+
+    uint32_t    i;
+    int32_t     effect, nb;
+    float       fn[8];
+    int8_t      result;
+
+    result      = 1;
+    effect      = GSP_LAST;
+    nb          = -1;
+
+    for (i = 0; i < binp.number_updates; i++)
+    {
+        if (binp.effect[i] != effect)
+        {
+            if (nb > 0) EffectParams(effect, fn, 1);
+            effect  = binp.effect[i];
+            if (effect >= 0) ramps.Cancel(effect);
+            nb      = EffectParams(effect, fn, 0);
+        }
+        if (nb > 0 && binp.param[i] < nb)
+        {
+            fn[binp.param[i]]   = binp.value[i];
+        }
+        else result = 0;
+    }
+    if (nb > 0) EffectParams(effect, fn, 1);
+
+    return result;
+}
@@ -15,6 +15,39 @@
 #define ADC_MINVAL 		-32768 				/* ADC minimum value */
 #define ADC_INVHRESF 	0.000030517578125f 	/* 1/ADC_16_HALFRES */
 
+#define GSP_TAIL_LEVEL 	16 					/* spillover tail sleep level (-66 dBFS) */
+
+// Fast base 2 logarithm and exponential (polynomial approximations, errors
+// below 2e-4, about 0.002 dB), for gain computers in decibels.
+
+static inline float FastLog2(float x)
+{
+	union { float f; uint32_t i; } v;
+	float 	e, t;
+
+	v.f 	= x; 			// x > 0
+	e 		= (float)(v.i >> 23) - 127.f;
+	v.i 	= (v.i & 0x007FFFFF) | 0x3F800000;  // mantissa (1 to 2)
+	t 		= v.f - 1.f;
+	return e + (((-0.0791538f*t + 0.3122261f)*t - 0.6695273f)*t 
+		+ 1.4361024f)*t + 0.0002037f;
+}
+
+static inline float FastExp2(float x)
+{
+	union { float f; uint32_t i; } v;
+	int32_t 	n;
+	float 		f;
+
+	if (x < -126.f) x 	= -126.f;
+	if (x > 126.f) x 	= 126.f;
+	n 		= (int32_t)(x + 127.f) - 127; 		// floor(x)
+	f 		= x - n;
+	v.f 	= ((0.0790202f*f + 0.2241273f)*f + 0.6968375f)*f + 0.9998122f;
+	v.i 	+= (uint32_t)n << 23;
+	return v.f;
+}
+
 //**#include  "DaisyDuino.h"
 
 #include "chorus.h"
@@ -22,9 +55,12 @@
 #include "delay_fb.h"
 #include "delay_ff.h"
 #include "detune.h"
+#include "envelope.h"
 #include "equalizer_3b.h"
 #include "level_detector.h"
 #include "lfo.h"
+#include "looper.h"
+#include "multiband.h"
 #include "noise_gate.h"
 #include "octave.h"
 #include "overdrive.h"
@@ -37,6 +73,7 @@
 
 #include "gsp_chain.h"
 #include "pots.h"
+#include "binary_protocol.h"
 
 #endif 	// GUITAR_DSP_H
 
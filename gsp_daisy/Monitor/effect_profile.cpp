@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "effect_profile.h"
+
+// *****************************************************************************
+
+void GSP_EffectProfile::Init(uint32_t sample_rate, uint32_t cpu_rate)
+{
+	/*
+    To initiate the per-effect cycle counters. Shall be called again
+	whenever the sampling rate changes.
+		sample_rate
+			sampling frequency (Hz)
+		cpu_rate
+			processor clock, the rate of the cycle counter (Hz)
+	*/
+
+	cpu_rate_ 		= cpu_rate;
+	sample_cycles_ 	= (float)cpu_rate/sample_rate;
+	state 			= 0;
+
+	Reset();
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_EffectProfile::Switch(uint8_t mode)
+{
+	/*
+    To start (1) or stop (0) timing the effects. The counters are kept.
+	*/
+
+	state 	= mode > 0;
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_EffectProfile::Reset()
+{
+	/*
+    To clear the counters.
+	*/
+
+	memset(cycles_, 0, sizeof(cycles_));
+	memset(samples_, 0, sizeof(samples_));
+	memset(worst_, 0, sizeof(worst_));
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_EffectProfile::Add(int32_t effect, uint32_t cycles)
+{
+	/*
+    To account one timed sample of an effect (audio callback).
+		effect
+			effect number (see enum gsp_effects)
+		cycles
+			processor cycles spent by the effect on the sample
+	*/
+
+	if (effect < 0 || effect >= MAX_EFFECT_NUMBER) return;
+
+	cycles_[effect] 	+= cycles;
+	samples_[effect]++;
+	if (cycles > worst_[effect]) worst_[effect] 	= cycles;
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_EffectProfile::Printout(uint8_t out_list, char *printout)
+{
+	/*
+    To print the timing state and the processor clock.
+	*/
+
+    if (out_list == 0)
+    {
+        sprintf(printout, "->PRF: OFF(0)|ON(1) %d | CPU clock (MHz): %lu "
+        "| Cycles per sample period: %-.0f\n",
+        state, cpu_rate_/1000000, sample_cycles_);
+    }
+    if (out_list == 1)
+    {
+        sprintf(printout, "->PRF %d %lu %-.0f\n",
+        state, cpu_rate_/1000000, sample_cycles_);
+    }
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_EffectProfile::Printout(uint8_t out_list, int32_t effect, int32_t chn_pos,
+	GSP_SignalChain *chain, char *printout)
+{
+	/*
+    To print the cycles of an effect: mean and worst per sample, and the
+	mean in percent of the sampling period.
+	*/
+
+	char 		name[8];
+	uint32_t 	mean;
+	float 		load;
+
+	chain->Name(effect, name);
+	mean 	= 0;
+	if (samples_[effect] > 0) mean 	= cycles_[effect]/samples_[effect];
+	load 	= 100.f*mean/sample_cycles_;
+
+    if (out_list == 0)
+    {
+        sprintf(printout, "->%s (%ld): Cycles: %lu | Worst: %lu | Load (%%): %-.2f "
+        "| Samples: %lu\n",
+        name, chn_pos, mean, worst_[effect], load, samples_[effect]);
+    }
+    if (out_list == 1)
+    {
+        sprintf(printout, "->%s (%ld) %lu %lu %-.2f %lu\n",
+        name, chn_pos, mean, worst_[effect], load, samples_[effect]);
+    }
+
+	return;
+}
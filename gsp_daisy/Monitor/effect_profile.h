@@ -0,0 +1,31 @@
+#ifndef GSP_EFFECT_PROFILE_H
+#define GSP_EFFECT_PROFILE_H
+
+#include <stdint.h>
+#include "gsp_chain.h"
+
+class GSP_EffectProfile
+{
+	public:
+		GSP_EffectProfile() {}
+		~GSP_EffectProfile() {}
+
+		void 		Init(uint32_t sample_rate, uint32_t cpu_rate);
+		void 		Switch(uint8_t mode);
+		void 		Reset();
+		void 		Add(int32_t effect, uint32_t cycles);
+		void		Printout(uint8_t out_list, char *printout);
+		void		Printout(uint8_t out_list, int32_t effect, int32_t chn_pos,
+						GSP_SignalChain *chain, char *printout);
+
+		volatile uint8_t 	state; 	// timing on (1) or off (0)
+
+	private:
+		uint32_t 	cpu_rate_; 		// processor clock (Hz)
+		float 		sample_cycles_; // processor cycles per sample period
+		uint64_t 	cycles_[MAX_EFFECT_NUMBER]; 	// timed cycles since reset
+		uint32_t 	samples_[MAX_EFFECT_NUMBER]; 	// timed samples since reset
+		uint32_t 	worst_[MAX_EFFECT_NUMBER]; 		// longest timed sample
+};
+
+#endif 	// GSP_EFFECT_PROFILE_H
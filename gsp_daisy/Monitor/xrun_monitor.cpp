@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "xrun_monitor.h"
+
+// *****************************************************************************
+
+void GSP_XrunMonitor::Init(uint32_t sample_rate, uint32_t block_size, uint32_t tick_rate)
+{
+	/*
+    To initiate the audio callback monitor. Shall be called again whenever
+	the sampling rate or the block size change.
+		sample_rate
+			sampling frequency (Hz)
+		block_size
+			samples per audio callback
+		tick_rate
+			frequency of the tick counter used to time the callback (Hz)
+	*/
+
+	period_ 		= (uint64_t)tick_rate*block_size/sample_rate;
+	late_ 			= period_ + period_/2;
+	tick_ms_ 		= 1000.f/tick_rate;
+	safe_preset 	= -1;
+
+	Reset();
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_XrunMonitor::Reset()
+{
+	/*
+    To clear the counters and the histogram.
+	*/
+
+	overruns 		= 0;
+	underruns 		= 0;
+	worst_ 			= 0;
+	first_ 			= 1;
+	slot_ 			= 0;
+	second_overruns_ 	= 0;
+	last_overruns_ 	= 0;
+	memset(hist_, 0, sizeof(hist_));
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_XrunMonitor::Start(uint32_t tick)
+{
+	/*
+    To check the callback start, at the beginning of each audio callback. 
+	An interval longer than 1.5 block periods since the previous callback
+	means a missed block (underrun).
+		tick
+			current tick counter
+	*/
+
+	if (!first_ && tick - last_ > late_) underruns++;
+	last_ 	= tick;
+	first_ 	= 0;
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_XrunMonitor::Stop(uint32_t ticks)
+{
+	/*
+    To check the callback duration against the block period (deadline), at 
+	the end of each audio callback.
+		ticks
+			callback duration (ticks)
+	*/
+
+	uint32_t 	bin;
+
+	if (ticks > worst_) worst_ 	= ticks;
+
+	bin 	= (uint64_t)ticks*(XRUN_BINS - 1)/period_;
+	if (ticks > period_)
+	{
+		overruns++;
+		second_overruns_++;
+		bin 	= XRUN_BINS - 1;
+	}
+	if (bin > XRUN_BINS - 1) bin 	= XRUN_BINS - 1;
+	hist_[slot_][bin]++;
+
+	return;
+}
+
+// *****************************************************************************
+
+uint8_t GSP_XrunMonitor::Second()
+{
+	/*
+    To roll the histogram, once per second (main loop). 
+	Returns 1 if the overruns in the last second reached XRUN_TRIP and a
+	safe preset is defined, so the chain shall be replaced by it.
+	*/
+
+	uint32_t 	next;
+	uint32_t 	count;
+
+	// the next second is cleared before the callback starts using it
+	next 	= (slot_ + 1) % XRUN_WINDOW;
+	memset(hist_[next], 0, sizeof(hist_[next]));
+	slot_ 	= next;
+
+	count 				= second_overruns_ - last_overruns_;
+	last_overruns_ 		= second_overruns_;
+
+	return (count >= XRUN_TRIP && safe_preset >= 0);
+}
+
+// *****************************************************************************
+
+void GSP_XrunMonitor::Printout(uint8_t out_list, char *printout)
+{
+	/*
+    To print the xrun counters, the worst callback duration (percent of 
+	the block period), the worst latency (block period plus the worst 
+	callback) and the histogram of the callback durations in the last 
+	XRUN_WINDOW seconds (percent of callbacks in 10% steps of the block 
+	period, the last bin being the overruns).
+	*/
+
+	uint32_t 	i, k, total, bins[XRUN_BINS];
+	float 		worst, latency;
+
+	total 	= 0;
+	for (k = 0; k < XRUN_BINS; k++)
+	{
+		bins[k] 	= 0;
+		for (i = 0; i < XRUN_WINDOW; i++) bins[k] 	+= hist_[i][k];
+		total 	+= bins[k];
+	}
+	if (total == 0) total 	= 1;
+
+	worst 		= 100.f*worst_/period_;
+	latency 	= (period_ + worst_)*tick_ms_;
+
+    if (out_list == 0)
+    {
+        sprintf(printout, "->XRN: Overruns: %lu | Underruns: %lu | Worst (%%): %-.1f "
+        "| Worst latency (ms): %-.3f | Safe preset: %ld | Histogram (%%):", 
+        overruns, underruns, worst, latency, safe_preset);
+    }
+    if (out_list == 1)
+    {
+        sprintf(printout, "->XRN %lu %lu %-.1f %-.3f %ld", 
+        overruns, underruns, worst, latency, safe_preset);
+    }
+
+	for (k = 0; k < XRUN_BINS; k++)
+	{
+		sprintf(printout + strlen(printout), " %-.1f", 100.f*bins[k]/total);
+	}
+	strcat(printout, "\n");
+
+	return;
+}
@@ -0,0 +1,39 @@
+#ifndef GSP_XRUN_MONITOR_H
+#define GSP_XRUN_MONITOR_H
+
+#include <stdint.h>
+
+#define XRUN_BINS 		11 		// 10% steps of the block period, plus overrun
+#define XRUN_WINDOW 	4 		// seconds in the rolling histogram
+#define XRUN_TRIP 		16 		// overruns in one second to recall the safe preset
+
+class GSP_XrunMonitor
+{
+	public:
+		GSP_XrunMonitor() {}
+		~GSP_XrunMonitor() {}
+
+		void 		Init(uint32_t sample_rate, uint32_t block_size, uint32_t tick_rate);
+		void 		Start(uint32_t tick);
+		void 		Stop(uint32_t ticks);
+		uint8_t 	Second();
+		void 		Reset();
+		void		Printout(uint8_t out_list, char *printout);
+
+		uint32_t 	overruns; 		// callbacks longer than the block period
+		uint32_t 	underruns; 		// callbacks started late (missed block)
+		int32_t 	safe_preset; 	// preset recalled on persistent overrun (-1: none)
+
+	private:
+		float 		tick_ms_; 		// milliseconds per tick
+		uint32_t 	period_; 		// block period (ticks)
+		uint32_t 	late_; 			// callback interval of a missed block (ticks)
+		uint32_t 	last_; 			// start of the previous callback
+		uint8_t 	first_;
+		uint32_t 	worst_; 		// longest callback (ticks)
+		uint32_t 	hist_[XRUN_WINDOW][XRUN_BINS];
+		volatile uint32_t 	slot_; 	// current second of the histogram
+		uint32_t 	second_overruns_, last_overruns_;
+};
+
+#endif 	// GSP_XRUN_MONITOR_H
@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "presets.h"
+
+using namespace daisy;
+
+#define QSPI_BASE 	0x90000000
+
+// *****************************************************************************
+
+void GSP_Presets::Init(QSPIHandle *qspi)
+{
+	/*
+    To initiate the preset store, loading all the slots from the QSPI flash.
+	Slots never saved (or written by another firmware version) are cleared.
+		qspi
+			QSPI flash handler
+	*/
+
+	uint32_t 	i;
+
+	qspi_ 	= qspi;
+
+	memcpy(slots_, qspi_->GetData(PRESET_QSPI_OFFSET), sizeof(slots_));
+
+	for (i = 0; i < PRESET_SLOTS; i++)
+	{
+		if (slots_[i].magic != PRESET_MAGIC 
+			|| slots_[i].number_effects > MAX_EFFECT_NUMBER)
+		{
+			memset(&slots_[i], 0, sizeof(GSP_Snapshot));
+		}
+	}
+
+	return;
+}
+
+// *****************************************************************************
+
+GSP_Snapshot *GSP_Presets::Slot(uint32_t slot)
+{
+	/*
+    To get a preset from the RAM copy.
+		slot
+			preset slot (0 to PRESET_SLOTS - 1)
+	Returns the preset, or NULL if the slot is invalid or empty.
+	*/
+
+	if (slot >= PRESET_SLOTS) return NULL;
+	if (slots_[slot].magic != PRESET_MAGIC) return NULL;
+
+	return &slots_[slot];
+}
+
+// *****************************************************************************
+
+int8_t GSP_Presets::Store(uint32_t slot, GSP_Snapshot *snapshot)
+{
+	/*
+    To save a preset in RAM and in the QSPI flash. All the slots are written 
+	again since the flash is erased by sectors. This takes some tens of 
+	milliseconds, and must not be called from the audio callback.
+		slot
+			preset slot (0 to PRESET_SLOTS - 1)
+		snapshot
+			chain and parameters of all the effects
+	Returns 0 if the preset was saved, or -1 otherwise.
+	*/
+
+	uint32_t 	address;
+
+	if (slot >= PRESET_SLOTS) return -1;
+
+	slots_[slot] 		= *snapshot;
+	slots_[slot].magic 	= PRESET_MAGIC;
+
+	address 	= QSPI_BASE + PRESET_QSPI_OFFSET;
+	if (qspi_->Erase(address, address + sizeof(slots_)) != QSPIHandle::Result::OK) return -1;
+	if (qspi_->Write(address, sizeof(slots_), (uint8_t*)slots_) != QSPIHandle::Result::OK) return -1;
+
+	return 0;
+}
+
+// *****************************************************************************
+
+void GSP_Presets::Printout(uint8_t out_list, char *printout)
+{
+	/*
+    To print the used slots
+	*/
+
+	uint32_t 	i;
+	char 		*pt;
+
+	pt 	= printout;
+	if (out_list == 0) pt 	+= sprintf(pt, "->PRS: Slots:");
+	if (out_list == 1) pt 	+= sprintf(pt, "->PRS");
+
+	for (i = 0; i < PRESET_SLOTS; i++)
+	{
+		if (out_list == 0) pt 	+= sprintf(pt, " %lu(%s)", i, 
+			slots_[i].magic == PRESET_MAGIC ? "used" : "empty");
+		if (out_list == 1) pt 	+= sprintf(pt, " %d", slots_[i].magic == PRESET_MAGIC);
+	}
+	sprintf(pt, "\n");
+
+	return;
+}
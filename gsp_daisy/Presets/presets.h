@@ -0,0 +1,44 @@
+#ifndef GSP_PRESETS_H
+#define GSP_PRESETS_H
+
+#include <stdint.h>
+#include "daisy_seed.h"
+#include "gsp_chain.h"
+
+#define PRESET_SLOTS 		8
+#define PRESET_PARAMS 		8 				// maximum number of parameters of an effect
+#define PRESET_LVD 			MAX_EFFECT_NUMBER 	// Level Detector parameters index
+#define PRESET_MAGIC 		0x37505347 		// "GSP7"
+#define PRESET_QSPI_OFFSET 	0x007F0000 		// last 64 kB of the QSPI flash
+
+struct GSP_Snapshot
+{
+	uint32_t 	magic; 							// PRESET_MAGIC if the slot is used
+	uint32_t 	number_effects;
+	int32_t 	sgn_chain[MAX_EFFECT_NUMBER];
+	int8_t 		branch[MAX_EFFECT_NUMBER];
+	float 		branch_level[GSP_BRANCHES];
+	int32_t 	stereo_split;
+	float 		spread[MAX_EFFECT_NUMBER]; 		// stereo spread (see EffectSpread)
+	float 		params[MAX_EFFECT_NUMBER + 1][PRESET_PARAMS];
+};
+
+class GSP_Presets
+{
+	public:
+		GSP_Presets() {}
+		~GSP_Presets() {}
+
+		void 			Init(daisy::QSPIHandle *qspi);
+		GSP_Snapshot 	*Slot(uint32_t slot);
+		int8_t 			Store(uint32_t slot, GSP_Snapshot *snapshot);
+		void			Printout(uint8_t out_list, char *printout);
+
+		GSP_Snapshot 	snapshot; 				// working snapshot
+
+	private:
+		daisy::QSPIHandle 	*qspi_;
+		GSP_Snapshot 		slots_[PRESET_SLOTS]; 	// RAM copy of the QSPI flash
+};
+
+#endif 	// GSP_PRESETS_H
@@ -0,0 +1,202 @@
+#include <stdio.h>
+
+#include "baud_link.h"
+
+using namespace daisy;
+
+// UART error flags (HAL_UART_ERROR_xx)
+#define UART_ERR_NOISE 		0x02
+#define UART_ERR_FRAMING 	0x04
+#define UART_ERR_OVERRUN 	0x08
+
+// *****************************************************************************
+
+void GSP_BaudLink::Init(UartHandler *uart, UartHandler::Config *config, GSP_UartTx *tx)
+{
+	/*
+    Initiate the baud rate negotiation of the UART link to the External Device.
+		uart
+			UART handler, already initialized at BAUD_BASE_RATE
+		config
+			UART configuration, used to change the baud rate
+		tx
+			transmit queue, flushed before any baud rate change
+	*/
+
+	uart_ 			= uart;
+	config_ 		= config;
+	tx_ 			= tx;
+	baudrate 		= config_->baudrate;
+	previous_rate_ 	= baudrate;
+	pending_rate_ 	= 0;
+	probing 		= 0;
+
+	framing_errors 	= 0;
+	noise_errors 	= 0;
+	overrun_errors 	= 0;
+	fallbacks 		= 0;
+	window_errors_ 	= 0;
+	window_start_ 	= System::GetNow();
+
+	return;
+}
+
+// *****************************************************************************
+
+int8_t GSP_BaudLink::Propose(uint32_t rate)
+{
+	/*
+    To request a baud rate change (bdr command). The change is done by
+	Service(), after the reply has been sent at the current baud rate. The
+	External Device shall then switch to the same rate and send 'bok' 
+	within BAUD_PROBE_MS, otherwise the link falls back to the previous rate.
+		rate
+			new baud rate: 115200, 230400, 460800 or 921600
+	Returns 0 if the rate is valid, or -1 otherwise.
+	*/
+
+	uint8_t 	i;
+
+	for (i = 0; i < BAUD_RATES_NUMBER; i++)
+	{
+		if (rate == rates_[i])
+		{
+			pending_rate_ 	= rate;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+// *****************************************************************************
+
+int8_t GSP_BaudLink::Confirm()
+{
+	/*
+    To accept the new baud rate ('bok' command received at the new rate).
+	Returns 0 if there was a baud rate under probe, or -1 otherwise.
+	*/
+
+	if (!probing) return -1;
+
+	probing 		= 0;
+	previous_rate_ 	= baudrate;
+
+	return 0;
+}
+
+// *****************************************************************************
+
+uint8_t GSP_BaudLink::Service()
+{
+	/*
+    To be called by the main loop. Performs the pending baud rate change,
+	checks the probe timeout and counts the UART line errors. If the probe 
+	isn't confirmed in time, the link returns to the previous rate. If the
+	line errors exceed BAUD_ERROR_LIMIT in one second above the base rate,
+	the link falls back to BAUD_BASE_RATE, the same rate the External 
+	Device returns to on its own errors.
+	Returns BAUD_NONE, BAUD_SWITCHED or BAUD_FALLBACK (see baud_event)
+	*/
+
+	int32_t 	err;
+	uint32_t 	now;
+
+	now 	= System::GetNow();
+
+	if (pending_rate_ != 0)
+	{
+		previous_rate_ 	= baudrate;
+		Switch(pending_rate_);
+		pending_rate_ 	= 0;
+		probing 		= 1;
+		probe_start_ 	= now;
+		return BAUD_SWITCHED;
+	}
+
+	// error counters: a line error stops the reception, and re-arming it
+	// clears the error code, so every new error is counted again
+	err 	= uart_->CheckError();
+	if (err != 0)
+	{
+		if (err & UART_ERR_FRAMING) framing_errors++;
+		if (err & UART_ERR_NOISE) noise_errors++;
+		if (err & UART_ERR_OVERRUN) overrun_errors++;
+		if (err & (UART_ERR_FRAMING | UART_ERR_NOISE)) window_errors_++;
+		uart_->DmaReceiveFifo();
+	}
+
+	if (probing && now - probe_start_ > BAUD_PROBE_MS)
+	{
+		probing 	= 0;
+		fallbacks++;
+		Switch(previous_rate_);
+		return BAUD_FALLBACK;
+	}
+
+	if (now - window_start_ > 1000)
+	{
+		if (window_errors_ > BAUD_ERROR_LIMIT && baudrate != BAUD_BASE_RATE)
+		{
+			probing 		= 0;
+			fallbacks++;
+			Switch(BAUD_BASE_RATE);
+			previous_rate_ 	= BAUD_BASE_RATE;
+			window_errors_ 	= 0;
+			window_start_ 	= now;
+			return BAUD_FALLBACK;
+		}
+		window_errors_ 	= 0;
+		window_start_ 	= now;
+	}
+
+	return BAUD_NONE;
+}
+
+// *****************************************************************************
+
+void GSP_BaudLink::Switch(uint32_t rate)
+{
+	/*
+    To change the UART baud rate, after transmitting all the queued replies.
+	The wait is the transmission time of the queue (10 bits per byte) plus
+	a margin; if the queue still isn't empty, it is dropped, so the
+	transmit state is clean for the new rate.
+	*/
+
+	uint32_t 	timeout_ms;
+
+	timeout_ms 	= tx_->Level()*10000/baudrate + 20;
+	if (!tx_->Flush(timeout_ms)) tx_->Abort();
+
+	config_->baudrate 	= rate;
+	uart_->Init(*config_);
+	uart_->DmaReceiveFifo();
+	baudrate 	= rate;
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_BaudLink::Printout(uint8_t out_list, char *printout)
+{
+
+    if (out_list == 0)
+    {
+        sprintf(printout, "->BDR: Baud rate: %lu%s "
+        "| Framing errors: %lu | Noise errors: %lu "
+        "| Overrun errors: %lu | Fallbacks: %lu\n", 
+        baudrate, probing ? " (probe)" : "", 
+        framing_errors, noise_errors, overrun_errors, fallbacks);
+    }
+    if (out_list == 1)
+    {
+        sprintf(printout, "->BDR %lu %d %lu %lu %lu %lu\n", 
+        baudrate, probing, 
+        framing_errors, noise_errors, overrun_errors, fallbacks);
+    }
+
+	return;
+}
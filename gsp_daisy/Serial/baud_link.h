@@ -0,0 +1,50 @@
+#ifndef GSP_BAUD_LINK_H
+#define GSP_BAUD_LINK_H
+
+#include <stdint.h>
+#include "daisy_seed.h"
+#include "uart_tx.h"
+
+#define BAUD_RATES_NUMBER 	4
+#define BAUD_BASE_RATE 		115200 		// power on and fallback baud rate
+#define BAUD_PROBE_MS 		500 		// time to receive 'bok' after a switch
+#define BAUD_ERROR_LIMIT 	8 			// line errors per second to fall back
+
+enum baud_event
+{
+	BAUD_NONE 		= 0,
+	BAUD_SWITCHED 	= 1,
+	BAUD_FALLBACK 	= 2,
+};
+
+class GSP_BaudLink
+{
+	public:
+		GSP_BaudLink() {}
+		~GSP_BaudLink() {}
+
+		void 		Init(daisy::UartHandler *uart, daisy::UartHandler::Config *config, 
+						GSP_UartTx *tx);
+		int8_t 		Propose(uint32_t rate);
+		int8_t 		Confirm();
+		uint8_t 	Service();
+		void		Printout(uint8_t out_list, char *printout);
+
+		uint32_t 	baudrate; 			// current baud rate
+		uint8_t 	probing; 			// waiting for 'bok' at the new baud rate
+		uint32_t 	framing_errors, noise_errors, overrun_errors;
+		uint32_t 	fallbacks;
+
+	private:
+		void 		Switch(uint32_t rate);
+
+		daisy::UartHandler 			*uart_;
+		daisy::UartHandler::Config 	*config_;
+		GSP_UartTx 	*tx_;
+		uint32_t 	rates_[BAUD_RATES_NUMBER] = {115200, 230400, 460800, 921600};
+		uint32_t 	pending_rate_, previous_rate_;
+		uint32_t 	probe_start_, window_start_;
+		uint32_t 	window_errors_;
+};
+
+#endif 	// GSP_BAUD_LINK_H
@@ -0,0 +1,210 @@
+#include <string.h>
+
+#include "binary_protocol.h"
+
+// Frame format (all values little endian, CRC over seq ... last value byte):
+//  STX seq n [effect param value]*n crc_lo crc_hi
+//      param   bits 0-6 parameter index (0 = switch), bit 7 set for int16 value
+//      value   float32 (4 bytes) or int16 (2 bytes)
+
+enum binp_state
+{
+	BP_IDLE,
+	BP_SEQ,
+	BP_COUNT,
+	BP_EFFECT,
+	BP_PARAM,
+	BP_VALUE,
+	BP_CRC_LO,
+	BP_CRC_HI,
+	BP_DISCARD,
+};
+
+// *****************************************************************************
+
+void GSP_BinaryProtocol::Init()
+{
+	/*
+    Initiate the binary protocol decoder. The protocol stays disabled
+	until the External Device enables it with the 'bin' command.
+	*/
+
+	enabled 		= 0;
+	frames_ok 		= 0;
+	frames_error 	= 0;
+	state_ 			= BP_IDLE;
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_BinaryProtocol::Start()
+{
+	/*
+    To start decoding a new frame, after the STX byte has been received
+	*/
+
+	state_ 			= BP_SEQ;
+	crc_ 			= 0xFFFF;
+	number_updates 	= 0;
+	update_ 		= 0;
+	finite_ 		= 1;
+
+	return;
+}
+
+// *****************************************************************************
+
+int8_t GSP_BinaryProtocol::Push(uint8_t byte)
+{
+	/*
+    To decode the next byte of a binary frame.
+		byte
+			byte received from the serial line (STX excluded)
+	Returns 0 while the frame is incomplete, 1 when a valid frame was
+	decoded (see effect[], param[] and value[]), or -1 if the frame was
+	rejected (CRC error, or a NaN or infinite float value). After a rejection the decoder drops the following bytes (the
+	rest of the frame, whose length can't be trusted) until Timeout is
+	called on an idle line.
+	*/
+
+	int16_t 	ivalue;
+
+	switch (state_)
+	{
+		case BP_SEQ:
+			sequence 	= byte;
+			crc_ 		= Crc16(crc_, byte);
+			state_ 		= BP_COUNT;
+			break;
+		case BP_COUNT:
+			number_updates 	= byte;
+			crc_ 		= Crc16(crc_, byte);
+			if (number_updates == 0 || number_updates > BINP_MAX_UPDATES)
+			{
+				state_ 	= BP_DISCARD;
+				frames_error++;
+				return -1;
+			}
+			state_ 		= BP_EFFECT;
+			break;
+		case BP_EFFECT:
+			if (byte == BINP_LVD) effect[update_] = -1;
+			else effect[update_] = byte;
+			crc_ 		= Crc16(crc_, byte);
+			state_ 		= BP_PARAM;
+			break;
+		case BP_PARAM:
+			param[update_] 	= byte & ~BINP_INT16;
+			value_len_ 	= 4;
+			if (byte & BINP_INT16) value_len_ = 2;
+			value_idx_ 	= 0;
+			crc_ 		= Crc16(crc_, byte);
+			state_ 		= BP_VALUE;
+			break;
+		case BP_VALUE:
+			value_buf_[value_idx_] 	= byte;
+			value_idx_++;
+			crc_ 		= Crc16(crc_, byte);
+			if (value_idx_ >= value_len_)
+			{
+				if (value_len_ == 4)
+				{
+					memcpy(&value[update_], value_buf_, 4);
+					// exponent all ones: NaN or infinite (checked on the bits,
+					// it holds whatever the floating point options)
+					if ((value_buf_[3] & 0x7F) == 0x7F && (value_buf_[2] & 0x80)) finite_ = 0;
+				}
+				else
+				{
+					ivalue 	= (int16_t)(value_buf_[0] | (value_buf_[1] << 8));
+					value[update_] 	= ivalue;
+				}
+				update_++;
+				if (update_ >= number_updates) state_ = BP_CRC_LO;
+				else state_ = BP_EFFECT;
+			}
+			break;
+		case BP_CRC_LO:
+			crc_rx_ 	= byte;
+			state_ 		= BP_CRC_HI;
+			break;
+		case BP_CRC_HI:
+			crc_rx_ 	|= (uint16_t)byte << 8;
+			if (crc_rx_ != crc_ || !finite_)
+			{
+				// a corrupted count may end the frame too soon
+				state_ 	= BP_DISCARD;
+				frames_error++;
+				return -1;
+			}
+			state_ 		= BP_IDLE;
+			frames_ok++;
+			return 1;
+		case BP_DISCARD:
+			break;
+		default:
+			return -1;
+	}
+
+	return 0;
+}
+
+// *****************************************************************************
+
+void GSP_BinaryProtocol::Timeout()
+{
+	/*
+    To end the frame in progress when the line has been idle for
+	BINP_IDLE_MS: ends the discarding of a rejected frame, and rejects a
+	frame still incomplete.
+	*/
+
+	if (state_ != BP_IDLE && state_ != BP_DISCARD) frames_error++;
+	state_ 			= BP_IDLE;
+
+	return;
+}
+
+// *****************************************************************************
+
+uint8_t GSP_BinaryProtocol::Reply(uint8_t *frame, uint8_t accepted)
+{
+	/*
+    To build the reply to the last binary frame: STX ACK seq or STX NAK seq
+		frame
+			output buffer (at least 3 bytes)
+		accepted
+			1 if the frame was decoded and applied, 0 otherwise
+	Returns the reply length in bytes.
+	*/
+
+	frame[0] 	= BINP_STX;
+	frame[1] 	= BINP_NAK;
+	if (accepted) frame[1] = BINP_ACK;
+	frame[2] 	= sequence;
+
+	return 3;
+}
+
+// *****************************************************************************
+
+uint16_t GSP_BinaryProtocol::Crc16(uint16_t crc, uint8_t byte)
+{
+	/*
+    CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF), one
+	byte at a time, so it can run while the frame is still arriving.
+	*/
+
+	uint8_t i;
+
+	crc 	^= (uint16_t)byte << 8;
+	for (i = 0; i < 8; i++)
+	{
+		if (crc & 0x8000) crc = (crc << 1) ^ 0x1021;
+		else crc = crc << 1;
+	}
+
+	return crc;
+}
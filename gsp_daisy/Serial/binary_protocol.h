@@ -0,0 +1,45 @@
+#ifndef GSP_BINARY_PROTOCOL_H
+#define GSP_BINARY_PROTOCOL_H
+
+#include <stdint.h>
+
+#define BINP_VERSION 		1
+#define BINP_STX 			2 			// Start of binary frame
+#define BINP_ACK 			6 			// Frame accepted
+#define BINP_NAK 			21 			// Frame rejected (CRC or format error)
+#define BINP_MAX_UPDATES 	16 			// Parameter updates per frame
+#define BINP_INT16 			0x80 		// Parameter index flag: int16 value
+#define BINP_LVD 			0xFF 		// Effect id of the Level Detector
+#define BINP_IDLE_MS 		5 			// Line idle time ending a frame (ms)
+
+class GSP_BinaryProtocol
+{
+	public:
+		GSP_BinaryProtocol() {}
+		~GSP_BinaryProtocol() {}
+
+		void 		Init();
+		void 		Start();
+		int8_t 		Push(uint8_t byte);
+		void 		Timeout();
+		uint8_t 	Reply(uint8_t *frame, uint8_t accepted);
+		uint16_t 	Crc16(uint16_t crc, uint8_t byte);
+
+		uint8_t 	enabled;
+		uint8_t 	sequence;
+		uint8_t 	number_updates;
+		int32_t 	effect[BINP_MAX_UPDATES];
+		uint8_t 	param[BINP_MAX_UPDATES];
+		float 		value[BINP_MAX_UPDATES];
+		uint32_t 	frames_ok, frames_error;
+
+	private:
+		uint8_t 	state_;
+		uint8_t 	update_;
+		uint8_t 	value_len_, value_idx_;
+		uint8_t 	value_buf_[4];
+		uint8_t 	finite_; 	// no NaN or infinite float in the frame
+		uint16_t 	crc_, crc_rx_;
+};
+
+#endif 	// GSP_BINARY_PROTOCOL_H
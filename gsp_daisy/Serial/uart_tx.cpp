@@ -0,0 +1,292 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "uart_tx.h"
+
+using namespace daisy;
+
+// *****************************************************************************
+
+void GSP_UartTx::Init(UartHandler *uart, uint8_t *ptr_buffer, uint32_t buffer_size)
+{
+	/*
+    Initiate the UART transmit queue.
+		uart
+			UART handler, already initialized
+		*ptr_buffer
+			ring buffer for the outgoing bytes. It must be placed in a DMA
+			accessible memory section (DMA_BUFFER_MEM_SECTION).
+		buffer_size
+			ring buffer size in bytes
+	*/
+
+	uart_ 			= uart;
+	ptr_buffer_ 	= ptr_buffer;
+	buffer_size_ 	= buffer_size;
+	head_ 			= 0;
+	tail_ 			= 0;
+	in_flight_ 		= 0;
+	busy_ 			= 0;
+
+	sent_bytes 		= 0;
+	peak_level 		= 0;
+	overflows 		= 0;
+	dropped_bytes 	= 0;
+	dma_errors 		= 0;
+
+	return;
+}
+
+// *****************************************************************************
+
+int32_t GSP_UartTx::Send(const uint8_t *data, uint32_t len)
+{
+	/*
+    To queue a message for transmission, without waiting for the serial line.
+		data
+			message bytes (copied to the ring buffer)
+		len
+			message length
+	Returns len if the message was queued, or -1 if there is no room for the
+	whole message. In this case the message is dropped and counted in the
+	overflow counter, so replies are never truncated.
+	*/
+
+	return Send(NULL, 0, data, len);
+}
+
+int32_t GSP_UartTx::Send(const uint8_t *prefix, uint32_t prefix_len, 
+	const uint8_t *data, uint32_t len)
+{
+	/*
+    To queue a framed message (the '{' prefix and the reply, for instance)
+	as a whole: both parts are queued, or both are dropped.
+		prefix
+			first bytes of the message (or NULL)
+		prefix_len
+			prefix length
+		data
+			message bytes (copied to the ring buffer)
+		len
+			message length
+	Returns prefix_len + len if the message was queued, or -1 if there is
+	no room for the whole message.
+	*/
+
+	uint32_t 	i, level, head;
+
+	level 		= Level();
+	if (level + prefix_len + len >= buffer_size_)
+	{
+		overflows++;
+		dropped_bytes 	+= prefix_len + len;
+		return -1;
+	}
+
+	head 		= head_;
+	for (i = 0; i < prefix_len + len; i++)
+	{
+		ptr_buffer_[head] 	= i < prefix_len ? prefix[i] : data[i - prefix_len];
+		head++;
+		if (head == buffer_size_) head = 0;
+	}
+	head_ 		= head;
+
+	level 		+= prefix_len + len;
+	if (level > peak_level) peak_level = level;
+
+	Poll();
+
+	return prefix_len + len;
+}
+
+// *****************************************************************************
+
+int32_t GSP_UartTx::SendWait(const uint8_t *prefix, uint32_t prefix_len, 
+	const uint8_t *data, uint32_t len, uint32_t timeout_ms)
+{
+	/*
+    To queue a line of a multi-line reply: waits for room in the ring
+	buffer before queueing it, so that a long listing isn't dropped line
+	by line. Telemetry uses Send and is dropped when the buffer is full.
+		prefix, prefix_len, data, len
+			as for Send
+		timeout_ms
+			maximum waiting time in milliseconds
+	Returns prefix_len + len if the message was queued, or -1 if there was
+	still no room on timeout (the message is dropped and counted).
+	*/
+
+	uint32_t 	t0;
+
+	t0 		= System::GetNow();
+	while (Level() + prefix_len + len >= buffer_size_)
+	{
+		Poll();
+		if (System::GetNow() - t0 > timeout_ms) break;
+	}
+
+	return Send(prefix, prefix_len, data, len);
+}
+
+// *****************************************************************************
+
+void GSP_UartTx::Poll()
+{
+	/*
+    To start a new DMA transfer if the line is idle and there are bytes
+	waiting. It is called by Send and by the transfer end callback, but can
+	also be called from the main loop.
+	*/
+
+	if (!busy_ && head_ != tail_) StartDma();
+
+	return;
+}
+
+// *****************************************************************************
+
+uint8_t GSP_UartTx::Flush(uint32_t timeout_ms)
+{
+	/*
+    To wait until all the queued bytes were transmitted (before changing
+	the baud rate, for instance).
+		timeout_ms
+			maximum waiting time in milliseconds
+	Returns 1 if the queue is empty, 0 on timeout.
+	*/
+
+	uint32_t 	t0;
+
+	t0 		= System::GetNow();
+	while (busy_ || head_ != tail_)
+	{
+		Poll();
+		if (System::GetNow() - t0 > timeout_ms) return 0;
+	}
+
+	return 1;
+}
+
+// *****************************************************************************
+
+void GSP_UartTx::Abort()
+{
+	/*
+    To drop the queued bytes and release the line, when a transfer didn't
+	end in time. The UART must be initialized again after it (this stops
+	the DMA transfer, whose end callback is then lost).
+	*/
+
+	uint32_t 	level;
+
+	level 			= Level();
+	if (level > 0)
+	{
+		overflows++;
+		dropped_bytes 	+= level;
+	}
+	tail_ 			= head_;
+	in_flight_ 		= 0;
+	busy_ 			= 0;
+
+	return;
+}
+
+// *****************************************************************************
+
+uint32_t GSP_UartTx::Level()
+{
+	/*
+    Number of bytes waiting to be transmitted (including the DMA transfer
+	in progress).
+	*/
+
+	uint32_t 	head, tail;
+
+	head 	= head_;
+	tail 	= tail_;
+	if (head >= tail) return head - tail;
+
+	return buffer_size_ - tail + head;
+}
+
+// *****************************************************************************
+
+void GSP_UartTx::StartDma()
+{
+	/*
+    To transmit the contiguous block between tail_ and head_ (or up to the
+	end of the ring buffer) by DMA.
+	*/
+
+	uint32_t 	head, len;
+
+	head 	= head_;
+	if (head > tail_) len = head - tail_;
+	else len = buffer_size_ - tail_;
+
+	busy_ 		= 1;
+	in_flight_ 	= len;
+	if (uart_->DmaTransmit(ptr_buffer_ + tail_, len, NULL, 
+		GSP_UartTx::EndCallback, this) != UartHandler::Result::OK)
+	{
+		// the transfer didn't start, try again on the next Poll
+		busy_ 		= 0;
+		in_flight_ 	= 0;
+		dma_errors++;
+	}
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_UartTx::EndCallback(void *context, UartHandler::Result result)
+{
+	/*
+    DMA transfer end callback (interrupt context). Releases the transmitted
+	bytes and chains the next transfer.
+	*/
+
+	GSP_UartTx 	*tx;
+	uint32_t 	tail;
+
+	tx 		= (GSP_UartTx*)context;
+	if (result != UartHandler::Result::OK) tx->dma_errors++;
+
+	tail 	= tx->tail_ + tx->in_flight_;
+	if (tail >= tx->buffer_size_) tail -= tx->buffer_size_;
+	tx->tail_ 		= tail;
+	tx->sent_bytes 	+= tx->in_flight_;
+	tx->in_flight_ 	= 0;
+	tx->busy_ 		= 0;
+
+	tx->Poll();
+
+	return;
+}
+
+// *****************************************************************************
+
+void GSP_UartTx::Printout(uint8_t out_list, char *printout)
+{
+
+    if (out_list == 0)
+    {
+        sprintf(printout, "->TX: Sent (bytes): %lu "
+        "| Queued: %lu | Peak: %lu/%lu "
+        "| Overflows: %lu | Dropped (bytes): %lu "
+        "| DMA errors: %lu\n", 
+        sent_bytes, Level(), peak_level, buffer_size_, 
+        overflows, dropped_bytes, dma_errors);
+    }
+    if (out_list == 1)
+    {
+        sprintf(printout, "->TX %lu %lu %lu %lu %lu %lu %lu\n", 
+        sent_bytes, Level(), peak_level, buffer_size_, 
+        overflows, dropped_bytes, dma_errors);
+    }
+
+	return;
+}
@@ -0,0 +1,45 @@
+#ifndef GSP_UART_TX_H
+#define GSP_UART_TX_H
+
+#include <stdint.h>
+#include "daisy_seed.h"
+
+class GSP_UartTx
+{
+	public:
+		GSP_UartTx() {}
+		~GSP_UartTx() {}
+
+		void 		Init(daisy::UartHandler *uart, uint8_t *ptr_buffer, uint32_t buffer_size);
+		int32_t 	Send(const uint8_t *data, uint32_t len);
+		int32_t 	Send(const uint8_t *prefix, uint32_t prefix_len, 
+						const uint8_t *data, uint32_t len);
+		int32_t 	SendWait(const uint8_t *prefix, uint32_t prefix_len, 
+						const uint8_t *data, uint32_t len, uint32_t timeout_ms);
+		void 		Poll();
+		uint8_t 	Flush(uint32_t timeout_ms);
+		void 		Abort();
+		uint32_t 	Level();
+		void		Printout(uint8_t out_list, char *printout);
+
+		static void EndCallback(void *context, daisy::UartHandler::Result result);
+
+		uint32_t 	sent_bytes;		// bytes transmitted by DMA
+		uint32_t 	peak_level; 	// maximum number of bytes waiting in the buffer
+		uint32_t 	overflows; 		// messages dropped due to full buffer
+		uint32_t 	dropped_bytes;
+		uint32_t 	dma_errors;
+
+	private:
+		void 		StartDma();
+
+		daisy::UartHandler 	*uart_;
+		uint8_t 	*ptr_buffer_;
+		uint32_t 	buffer_size_;
+		volatile uint32_t 	head_; 		// write position (main loop)
+		volatile uint32_t 	tail_; 		// read position (DMA callback)
+		volatile uint32_t 	in_flight_; // bytes under DMA transfer
+		volatile uint8_t 	busy_;
+};
+
+#endif 	// GSP_UART_TX_H
@@ -0,0 +1,86 @@
+// Feedforward delay: the FF_COMB engine against the FF_TAPS reference, on
+// the same buffer, for delays, echoes, parameter changes and buffer wraps.
+
+#include "host_test.h"
+#include "delay_ff.h"
+
+#define SR 			48000
+#define BUF_SIZE 	65536 		// small buffer: the pointer wraps often
+
+static int16_t 	buffer[BUF_SIZE];
+static float 	comb[BUF_SIZE];
+
+static int32_t Compare(int32_t type, float fn[], float decay_change, uint32_t samples)
+{
+	/*
+    Runs the taps and the comb engines on the same input and returns the 
+	largest output difference (LSB). decay_change, if > 0, is a new decay
+	rate set half way (the comb warms up on the taps again).
+	*/
+
+	GSP_DelayFF 	taps(type), cmb(type);
+	uint32_t 		n, bp;
+	int32_t 		x, d, max_diff;
+
+	taps.Init(SR, buffer, BUF_SIZE);
+	cmb.Init(SR, buffer, BUF_SIZE);
+	cmb.SetCombBuffer(comb);
+	fn[6] 	= FF_TAPS;
+	taps.SetParams(fn);
+	fn[6] 	= FF_COMB;
+	cmb.SetParams(fn);
+
+	for (n = 0; n < BUF_SIZE; n++) buffer[n] 	= 0;
+	bp 			= 0;
+	max_diff 	= 0;
+	for (n = 0; n < samples; n++)
+	{
+		if (decay_change > 0 && n == samples/2)
+		{
+			taps.SetDecayRate(decay_change);
+			cmb.SetDecayRate(decay_change);
+		}
+		x 			= Pluck(n, 110.f, SR);
+		buffer[bp] 	= x;
+		d 			= taps.Process(x, bp) - cmb.Process(x, bp);
+		if (d < 0) d 	= -d;
+		if (d > max_diff) max_diff 	= d;
+		bp++;
+		if (bp == BUF_SIZE) bp 	= 0;
+	}
+
+	return max_diff;
+}
+
+int main()
+{
+	// s, delay_ms, decay, repeats, gain, spillover, engine
+	float 		dly[7] 	= {1, 30, 0.7, 4, 1, 0, 0};
+	float 		dly8[7] = {1, 97, 0.9, 8, 1, 0, 0};
+	float 		dly1[7] = {1, 20, 0.5, 1, 1, 0, 0};
+	float 		echo[7] = {1, 350, 0.6, 6, 1, 0, 0};
+	char 		what[80];
+	int32_t 	diff;
+
+	diff 	= Compare(DELAY_FF, dly, 0, 4*SR);
+	snprintf(what, sizeof(what), "dff 30 ms, 4 repeats: comb within 2 LSB of taps (%ld)", (long)diff);
+	Check(diff <= 2, what);
+
+	diff 	= Compare(DELAY_FF, dly8, 0, 4*SR);
+	snprintf(what, sizeof(what), "dff 97 ms, 8 repeats: comb within 2 LSB of taps (%ld)", (long)diff);
+	Check(diff <= 2, what);
+
+	diff 	= Compare(DELAY_FF, dly1, 0, SR);
+	snprintf(what, sizeof(what), "dff 1 repeat (dry only): comb equal to taps (%ld)", (long)diff);
+	Check(diff == 0, what);
+
+	diff 	= Compare(ECHO_FF, echo, 0, 6*SR);
+	snprintf(what, sizeof(what), "eff 350 ms, 6 repeats: comb within 2 LSB of taps (%ld)", (long)diff);
+	Check(diff <= 2, what);
+
+	diff 	= Compare(DELAY_FF, dly, 0.85, 4*SR);
+	snprintf(what, sizeof(what), "dff decay change: comb within 2 LSB of taps (%ld)", (long)diff);
+	Check(diff <= 2, what);
+
+	return TestResult("delay_ff_test");
+}
@@ -0,0 +1,128 @@
+// Harmonizer: note sequences rendered through the pitch shifter (SFT_MAJOR,
+// SFT_MINOR), with the wet pitch measured by the tuner after each transition.
+
+#include "host_test.h"
+#include "pitch_shifter.h"
+#include "pitch_detector.h"
+
+#define SR 			48000
+#define BUF_SIZE 	262144
+#define NOTE_LEN 	(SR*4/10) 	// each note is plucked for 400 ms
+#define SETTLE 		(SR*2/10) 	// pitch measured after 200 ms (glide)
+
+static int16_t 	buffer[BUF_SIZE];
+
+// the tuner printout names its routes with the chain (Daisy build only)
+void GSP_SignalChain::Name(int32_t, char *printout) { printout[0] 	= 0; }
+
+static const uint16_t 	major_mask = 0x0AB5; 	// C D E F G A B (bit = semitone)
+static const uint16_t 	minor_mask = 0x05AD; 	// C D Eb F G Ab Bb
+
+static const int32_t 	notes[] = {40, 45, 48, 50, 52, 53, 55, 57, 59, 60, 61, 64, 66, 69, 72};
+
+static uint8_t InScale(uint16_t mask, int32_t key, int32_t note)
+{
+	return (mask >> (((note - key) % 12 + 12) % 12)) & 1;
+}
+
+static int32_t Expected(uint16_t mask, int32_t key, int32_t note, int32_t steps)
+{
+	/*
+    Reference shift (semitones), walking the scale one semitone at a time:
+	from the input note (or the scale note below it) to the scale note
+	"steps" scale notes away.
+	*/
+
+	int32_t 	base, n, dir;
+
+	base 	= note;
+	while (!InScale(mask, key, base)) base--;
+
+	n 		= base;
+	dir 	= steps > 0 ? 1 : -1;
+	while (steps != 0)
+	{
+		n 	+= dir;
+		if (InScale(mask, key, n)) steps 	-= dir;
+	}
+
+	return n - base;
+}
+
+static void Render(uint8_t mode, int32_t key, int32_t steps)
+{
+	/*
+    Plays the note sequence without a reset between notes, and checks the
+	mean shift of the wet output against the reference, within 0.25 semitones.
+	*/
+
+	GSP_PitchShifter 	sft;
+	GSP_PitchDetect 	tuner;
+	// s, shift, mixer (wet only), gain, mode, key, interval
+	float 		fn[7] 	= {1, 0, 1, 1, (float)mode, (float)key, (float)steps};
+	uint16_t 	mask;
+	uint32_t 	i, k, bp, count, fails;
+	int32_t 	x, expect;
+	float 		f_in, last, acc, shift, worst;
+	char 		what[120];
+
+	sft.Init(SR, buffer, BUF_SIZE);
+	sft.SetParams(fn);
+	tuner.Init(SR);
+	tuner.state 	= 1;
+
+	for (i = 0; i < BUF_SIZE; i++) buffer[i] 	= 0;
+	mask 	= mode == SFT_MINOR ? minor_mask : major_mask;
+	bp 		= 0;
+	fails 	= 0;
+	worst 	= 0;
+	for (k = 0; k < sizeof(notes)/sizeof(notes[0]); k++)
+	{
+		f_in 	= 440.f*powf(2, (notes[k] - 69)/12.f);
+		expect 	= Expected(mask, key, notes[k], steps);
+		last 	= 0;
+		acc 	= 0;
+		count 	= 0;
+		for (i = 0; i < NOTE_LEN; i++)
+		{
+			x 			= Pluck(i, f_in, SR);
+			buffer[bp] 	= x;
+			tuner.Process(sft.Process(x, bp));
+			if (i > SETTLE && tuner.frequency > 0 && tuner.frequency != last)
+			{
+				last 	= tuner.frequency;
+				acc 	+= 12*log2f(last/f_in);
+				count++;
+			}
+			bp++;
+			if (bp == BUF_SIZE) bp 	= 0;
+		}
+		shift 	= count > 0 ? acc/count : 0;
+		if (count == 0 || fabsf(shift - expect) > 0.25f)
+		{
+			printf("     note %ld: %+.2f st (%lu estimates), expected %+ld\n",
+				(long)notes[k], shift, (unsigned long)count, (long)expect);
+			fails++;
+		}
+		else if (fabsf(shift - expect) > worst) worst 	= fabsf(shift - expect);
+	}
+
+	snprintf(what, sizeof(what), "%s key %ld, %+ld steps: %u notes on the scale interval "
+		"(worst %.2f st)", mode == SFT_MINOR ? "minor" : "major", (long)key, (long)steps,
+		(unsigned)(sizeof(notes)/sizeof(notes[0])), worst);
+	Check(fails == 0, what);
+
+	return;
+}
+
+int main()
+{
+	Render(SFT_MAJOR, 0, 2); 		// diatonic third above, C major
+	Render(SFT_MAJOR, 0, 4); 		// fifth
+	Render(SFT_MAJOR, 7, -2); 		// third below, G major
+	Render(SFT_MINOR, 9, 2); 		// third above, A minor
+	Render(SFT_MINOR, 4, 5); 		// sixth, E minor
+	Render(SFT_MAJOR, 0, 7); 		// octave
+
+	return TestResult("harmonizer_test");
+}
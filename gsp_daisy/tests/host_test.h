@@ -0,0 +1,63 @@
+#ifndef GSP_HOST_TEST_H
+#define GSP_HOST_TEST_H
+
+// Host test harness: the effect classes are built for the PC and checked
+// offline, with a deterministic guitar-like input. See tests/Makefile.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "guitar_dsp.h"
+
+static int 		test_failures = 0;
+
+static inline void Check(int ok, const char *what)
+{
+	/*
+    To report a check: "ok" or "FAIL", and counts the failures.
+	*/
+
+	printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+	if (!ok) test_failures++;
+
+	return;
+}
+
+static inline int TestResult(const char *name)
+{
+	/*
+    Returns the exit code of a test program: 0 if all checks passed.
+	*/
+
+	printf("%s: %d failure(s)\n", name, test_failures);
+
+	return test_failures > 0;
+}
+
+static inline int32_t Pluck(uint32_t n, float freq, uint32_t sample_rate)
+{
+	/*
+    Plucked string: six decaying harmonics plus a little noise, restarted
+	every half second, at about -12 dBFS.
+		n
+			sample index
+		freq
+			fundamental (Hz)
+	*/
+
+	static uint32_t 	seed = 12345;
+	uint32_t 	k, t;
+	float 		x, env;
+
+	t 		= n % (sample_rate/2);
+	env 	= expf(-6.f*t/sample_rate);
+	x 		= 0;
+	for (k = 1; k <= 6; k++) x 	+= sinf(GDSP_2PI*k*freq*t/sample_rate)/k;
+	seed 	= 1664525*seed + 1013904223;
+	x 		= 0.4f*env*x + ((int32_t)(seed >> 16) - 32768)*(1.f/32768.f)*0.002f;
+
+	return (int32_t)(ADC_HALFRES*0.25f*x);
+}
+
+#endif 	// GSP_HOST_TEST_H
@@ -0,0 +1,110 @@
+// Looper: a scripted session (record, play, overdub, undo, redo) checking
+// the played loop sample by sample, including an overdub that stops before
+// the end of the loop and is undone.
+
+#include "host_test.h"
+#include "looper.h"
+
+#define SR 			48000
+#define BUF_SIZE 	65536
+#define LOOP_LEN 	1600 		// loop length (samples, a multiple of LPR_BURST)
+#define DUB_LEN 	800 		// partial overdub: first half of the loop
+
+static int16_t 	loop_buffer[BUF_SIZE], layer_buffer[BUF_SIZE];
+
+static GSP_Looper 	looper;
+static uint32_t 	clock_pos = 0; 	// samples played since the loop was closed
+
+static int32_t FirstLayer(uint32_t pos)
+{
+	return (pos % 100)*10;
+}
+
+static int32_t SecondLayer(uint32_t pos)
+{
+	return FirstLayer(pos) + 1000;
+}
+
+static int32_t PartialLayer(uint32_t pos)
+{
+	return SecondLayer(pos) + (pos < DUB_LEN ? 500 : 0);
+}
+
+static uint32_t Run(uint32_t samples, int32_t input, int32_t (*expected)(uint32_t))
+{
+	/*
+    Plays a number of samples of a constant input, and returns the loop
+	samples (output minus input) that differ from expected(position), if
+	given.
+	*/
+
+	uint32_t 	n, bad;
+	int32_t 	y;
+
+	bad 	= 0;
+	for (n = 0; n < samples; n++)
+	{
+		y 	= looper.Process(input) - input;
+		if (expected != NULL && y != expected(clock_pos % LOOP_LEN)) bad++;
+		clock_pos++;
+	}
+
+	return bad;
+}
+
+static void Expect(uint32_t bad, const char *what)
+{
+	char 	line[120];
+
+	snprintf(line, sizeof(line), "%s (%lu wrong samples)", what, (unsigned long)bad);
+	Check(bad == 0, line);
+
+	return;
+}
+
+int main()
+{
+	uint32_t 	n;
+
+	looper.Init(SR, loop_buffer, layer_buffer, BUF_SIZE);
+	looper.Switch(GSP_ON);
+
+	// first layer: a ramp, the loop is closed by play
+	looper.Control(LPR_RECORD);
+	for (n = 0; n < LOOP_LEN; n++) looper.Process(FirstLayer(n));
+	looper.Control(LPR_PLAY);
+	Expect(Run(LOOP_LEN, 0, FirstLayer), "record and play");
+	Check(looper.length == LOOP_LEN, "loop length set by the recording");
+
+	// second layer over a whole pass
+	looper.Control(LPR_OVERDUB);
+	Run(LOOP_LEN, 1000, NULL);
+	looper.Control(LPR_PLAY);
+	Expect(Run(LOOP_LEN, 0, SecondLayer), "overdub a whole pass");
+
+	// third layer over half a pass, undone: the second layer stays where
+	// the overdub didn't reach
+	looper.Control(LPR_OVERDUB);
+	Run(DUB_LEN, 500, NULL);
+	looper.Control(LPR_UNDO);
+	Run(LOOP_LEN - DUB_LEN, 0, NULL);
+	Expect(Run(LOOP_LEN, 0, SecondLayer), "undo an overdub of half a pass");
+
+	looper.Control(LPR_REDO);
+	Expect(Run(LOOP_LEN, 0, PartialLayer), "redo the half pass");
+
+	// a new overdub after undo drops the muted half pass only
+	looper.Control(LPR_UNDO);
+	Run(LOOP_LEN, 0, NULL);
+	looper.Control(LPR_OVERDUB);
+	Run(LOOP_LEN/4, 0, NULL);
+	looper.Control(LPR_PLAY);
+	Run(LOOP_LEN - LOOP_LEN/4, 0, NULL);
+	Expect(Run(LOOP_LEN, 0, SecondLayer), "overdub after undo");
+	Check(looper.layers == 3 && looper.undone == 0, "layers after the new overdub");
+
+	looper.Control(LPR_CLEAR);
+	Expect(Run(LOOP_LEN, 0, NULL) + (looper.length != 0), "clear");
+
+	return TestResult("looper_test");
+}